@@ -14,7 +14,297 @@
 #include "ElasticInternal.h"
 #include "logger.h"
 
+#ifdef __linux__
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <sys/resource.h>
+#include <linux/mempolicy.h>
+#include <pthread.h>
+#include <sched.h>
+#include <fstream>
+#endif
+
+#include <cstring>
+
+// Runtime dispatched non-temporal copy kernels (x86 GCC/Clang). Other targets use memcpy
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define EFP_COPY_KERNELS
+#include <immintrin.h>
+#endif
+
 #define WORKER_THREAD_SLEEP_US 1000 * 10
+#define NACK_MAX_RANGES 256 //Maximum number of missing fragment ranges reported in one NACK
+#define ADAPTIVE_TIMEOUT_GAPS 512 //Number of gaps between fragments used by the adaptive timeout
+#define ADAPTIVE_TIMEOUT_WINDOW 64 //The adaptive timeout is re-calculated every window (gaps)
+#define PLAYOUT_CLOCK_WINDOW_US 1000000 //Window used by the playout clock recovery to estimate the drift
+
+// Copy kernels writing the destination with non-temporal (streaming) stores. Used for large superframes that are
+// written once and then handed to the application, so they do not evict everything else from the caches.
+// The destination is aligned to the vector size using memcpy, the source may be unaligned.
+#ifdef EFP_COPY_KERNELS
+__attribute__((target("avx512f")))
+static void streamCopyAVX512(uint8_t *pDst, const uint8_t *pSrc, size_t lSize) {
+    size_t lHead = std::min((size_t) ((64 - ((uintptr_t) pDst & 63)) & 63), lSize);
+    std::memcpy(pDst, pSrc, lHead);
+    pDst += lHead;
+    pSrc += lHead;
+    lSize -= lHead;
+    for (; lSize >= 64; lSize -= 64, pDst += 64, pSrc += 64) {
+        _mm512_stream_si512((__m512i *) pDst, _mm512_loadu_si512((const void *) pSrc));
+    }
+    std::memcpy(pDst, pSrc, lSize);
+    _mm_sfence();
+}
+
+__attribute__((target("avx2")))
+static void streamCopyAVX2(uint8_t *pDst, const uint8_t *pSrc, size_t lSize) {
+    size_t lHead = std::min((size_t) ((32 - ((uintptr_t) pDst & 31)) & 31), lSize);
+    std::memcpy(pDst, pSrc, lHead);
+    pDst += lHead;
+    pSrc += lHead;
+    lSize -= lHead;
+    for (; lSize >= 32; lSize -= 32, pDst += 32, pSrc += 32) {
+        _mm256_stream_si256((__m256i *) pDst, _mm256_loadu_si256((const __m256i *) pSrc));
+    }
+    std::memcpy(pDst, pSrc, lSize);
+    _mm_sfence();
+}
+
+__attribute__((target("sse2")))
+static void streamCopySSE2(uint8_t *pDst, const uint8_t *pSrc, size_t lSize) {
+    size_t lHead = std::min((size_t) ((16 - ((uintptr_t) pDst & 15)) & 15), lSize);
+    std::memcpy(pDst, pSrc, lHead);
+    pDst += lHead;
+    pSrc += lHead;
+    lSize -= lHead;
+    for (; lSize >= 16; lSize -= 16, pDst += 16, pSrc += 16) {
+        _mm_stream_si128((__m128i *) pDst, _mm_loadu_si128((const __m128i *) pSrc));
+    }
+    std::memcpy(pDst, pSrc, lSize);
+    _mm_sfence();
+}
+
+// Pick the widest kernel the CPU supports
+static void (*selectStreamCopy())(uint8_t *, const uint8_t *, size_t) {
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        return streamCopyAVX512;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        return streamCopyAVX2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return streamCopySSE2;
+    }
+    return nullptr;
+}
+#endif
+
+// Copy lSize bytes. Normal copies use memcpy (already vectorized by the C library)
+static void copyData(uint8_t *pDst, const uint8_t *pSrc, size_t lSize, bool lNonTemporal) {
+    if (!lSize) {
+        return;
+    }
+#ifdef EFP_COPY_KERNELS
+    static void (*const lStreamCopy)(uint8_t *, const uint8_t *, size_t) = selectStreamCopy();
+    if (lNonTemporal && lStreamCopy) {
+        lStreamCopy(pDst, pSrc, lSize);
+        return;
+    }
+#endif
+    std::memcpy(pDst, pSrc, lSize);
+}
+
+#ifdef __linux__
+#define HUGE_PAGE_SIZE (2 * 1024 * 1024)
+#define MAX_NUMA_NODES 1024
+
+// Prefer memory from lNode for the range (before it's faulted in)
+static void bindToNode(void *pMemory, size_t lSize, int32_t lNode) {
+    unsigned long lNodeMask[MAX_NUMA_NODES / (8 * sizeof(unsigned long))] = {0};
+    lNodeMask[lNode / (8 * sizeof(unsigned long))] |= 1UL << (lNode % (8 * sizeof(unsigned long)));
+    if (syscall(SYS_mbind, pMemory, lSize, MPOL_PREFERRED, lNodeMask, MAX_NUMA_NODES, 0)) {
+        EFP_LOGGER(true, LOGG_WARN, "mbind failed for NUMA node " << lNode)
+    }
+}
+
+// Map lSize bytes rounded up to whole pages. Huge pages are taken from the MAP_HUGETLB pool if possible else
+// transparent huge pages are requested. The memory is placed on lNode if >= 0.
+// Returns nullptr if nothing could be mapped. *pMappedSize is set to the size of the mapping
+static uint8_t *mapMemory(size_t lSize, bool lHugePages, bool lPreFault, int32_t lNumaNode, size_t *pMappedSize) {
+    size_t lPageSize = lHugePages ? HUGE_PAGE_SIZE : 4096;
+    size_t lMapSize = (lSize + lPageSize - 1) & ~(lPageSize - 1);
+    bool lTouch = lPreFault;
+    void *pMemory = MAP_FAILED;
+    if (lHugePages) {
+        // MAP_POPULATE faults in the pages now. Not if the memory is bound to a node first
+        bool lPopulate = lPreFault && lNumaNode < 0;
+        pMemory = mmap(nullptr, lMapSize, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | (lPopulate ? MAP_POPULATE : 0), -1, 0);
+        if (pMemory != MAP_FAILED && lPopulate) {
+            lTouch = false;
+        }
+    }
+    if (pMemory == MAP_FAILED) {
+        // Transparent huge pages need a huge page aligned range. Map more and trim it
+        size_t lAlignment = lHugePages ? HUGE_PAGE_SIZE : 0;
+        void *pRange = mmap(nullptr, lMapSize + lAlignment, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (pRange == MAP_FAILED) {
+            return nullptr;
+        }
+        pMemory = pRange;
+        if (lHugePages) {
+            auto lRangeStart = (uintptr_t) pRange;
+            uintptr_t lStart = (lRangeStart + HUGE_PAGE_SIZE - 1) & ~(uintptr_t) (HUGE_PAGE_SIZE - 1);
+            if (lStart != lRangeStart) {
+                munmap(pRange, lStart - lRangeStart);
+            }
+            if (lStart + lMapSize != lRangeStart + lMapSize + HUGE_PAGE_SIZE) {
+                munmap((void *) (lStart + lMapSize), lRangeStart + HUGE_PAGE_SIZE - lStart);
+            }
+            pMemory = (void *) lStart;
+            madvise(pMemory, lMapSize, MADV_HUGEPAGE);
+        }
+    }
+    if (lNumaNode >= 0) {
+        bindToNode(pMemory, lMapSize, lNumaNode);
+    }
+    if (lTouch) {
+        for (size_t x = 0; x < lMapSize; x += 4096) {
+            ((volatile uint8_t *) pMemory)[x] = 0;
+        }
+    }
+    *pMappedSize = lMapSize;
+    return (uint8_t *) pMemory;
+}
+
+// Read the CPUs of a NUMA node. false if the node does not exist
+static bool getNodeCpus(int32_t lNode, cpu_set_t *pCpus) {
+    std::ifstream lCpuList("/sys/devices/system/node/node" + std::to_string(lNode) + "/cpulist");
+    std::string lList;
+    if (!std::getline(lCpuList, lList)) {
+        return false;
+    }
+    CPU_ZERO(pCpus);
+    std::istringstream lRanges(lList);
+    std::string lRange;
+    while (std::getline(lRanges, lRange, ',')) {
+        if (lRange.empty()) {
+            continue;
+        }
+        size_t lDash = lRange.find('-');
+        int lFirst = std::stoi(lRange.substr(0, lDash));
+        int lLast = lDash == std::string::npos ? lFirst : std::stoi(lRange.substr(lDash + 1));
+        for (int lCpu = lFirst; lCpu <= lLast && lCpu < CPU_SETSIZE; lCpu++) {
+            CPU_SET(lCpu, pCpus);
+        }
+    }
+    return CPU_COUNT(pCpus) > 0;
+}
+#endif
+
+// XOR lSize bytes from pSrc into pDst (used by the FEC)
+static void xorBlock(uint8_t *pDst, const uint8_t *pSrc, size_t lSize) {
+    for (size_t x = 0; x < lSize; x++) {
+        pDst[x] ^= pSrc[x];
+    }
+}
+
+//---------------------------------------------------------------------------------------------------------------------
+//
+//
+// ElasticFrameProtocolMemoryBudget
+//
+//
+//---------------------------------------------------------------------------------------------------------------------
+
+ElasticFrameProtocolMemoryBudget::ElasticFrameProtocolMemoryBudget(size_t lMaxBytes) : mMaxBytes(lMaxBytes) {
+}
+
+size_t ElasticFrameProtocolMemoryBudget::getUsedBytes() {
+    std::lock_guard<std::mutex> lock(mBudgetMtx);
+    return mUsedBytes;
+}
+
+size_t ElasticFrameProtocolMemoryBudget::getNumberOfReceivers() {
+    std::lock_guard<std::mutex> lock(mBudgetMtx);
+    return mAttachedReceivers;
+}
+
+uint64_t ElasticFrameProtocolMemoryBudget::attach() {
+    std::lock_guard<std::mutex> lock(mBudgetMtx);
+    uint64_t lReceiverId = mNextReceiverId++;
+    mReceivers[lReceiverId] = ReceiverEntry();
+    mAttachedReceivers++;
+    return lReceiverId;
+}
+
+// The entry is kept until all superframes charged to the receiver are destroyed
+void ElasticFrameProtocolMemoryBudget::detach(uint64_t lReceiverId) {
+    std::lock_guard<std::mutex> lock(mBudgetMtx);
+    auto lReceiver = mReceivers.find(lReceiverId);
+    if (lReceiver == mReceivers.end() || !lReceiver->second.mAttached) {
+        return;
+    }
+    lReceiver->second.mAttached = false;
+    mAttachedReceivers--;
+    if (!lReceiver->second.mUsage.mBytes) {
+        mReceivers.erase(lReceiver);
+    }
+}
+
+bool ElasticFrameProtocolMemoryBudget::reserve(uint64_t lReceiverId, uint8_t lSource, size_t lBytes) {
+    std::lock_guard<std::mutex> lock(mBudgetMtx);
+    auto lReceiver = mReceivers.find(lReceiverId);
+    if (lReceiver == mReceivers.end()) {
+        return false;
+    }
+    Usage &rUsage = lReceiver->second.mUsage;
+    size_t lFairShare = mMaxBytes / std::max(mAttachedReceivers, (size_t) 1);
+    bool lUnderPressure = mUsedBytes + lBytes > (mMaxBytes / 4) * 3;
+    if (lBytes > mMaxBytes - mUsedBytes || (lUnderPressure && rUsage.mBytes + lBytes > lFairShare)) {
+        rUsage.mRefused++;
+        return false;
+    }
+    mUsedBytes += lBytes;
+    rUsage.mBytes += lBytes;
+    rUsage.mSourceBytes[lSource] += lBytes;
+    rUsage.mPeakBytes = std::max(rUsage.mPeakBytes, rUsage.mBytes);
+    return true;
+}
+
+void ElasticFrameProtocolMemoryBudget::release(uint64_t lReceiverId, uint8_t lSource, size_t lBytes) {
+    std::lock_guard<std::mutex> lock(mBudgetMtx);
+    auto lReceiver = mReceivers.find(lReceiverId);
+    if (lReceiver == mReceivers.end()) {
+        return;
+    }
+    Usage &rUsage = lReceiver->second.mUsage;
+    mUsedBytes -= lBytes;
+    rUsage.mBytes -= lBytes;
+    rUsage.mSourceBytes[lSource] -= lBytes;
+    if (!lReceiver->second.mAttached && !rUsage.mBytes) {
+        mReceivers.erase(lReceiver);
+    }
+}
+
+size_t ElasticFrameProtocolMemoryBudget::getReceiverBytes(uint64_t lReceiverId) {
+    std::lock_guard<std::mutex> lock(mBudgetMtx);
+    auto lReceiver = mReceivers.find(lReceiverId);
+    if (lReceiver == mReceivers.end()) {
+        return 0;
+    }
+    return lReceiver->second.mUsage.mBytes;
+}
+
+ElasticFrameProtocolMemoryBudget::Usage ElasticFrameProtocolMemoryBudget::getUsage(uint64_t lReceiverId) {
+    std::lock_guard<std::mutex> lock(mBudgetMtx);
+    auto lReceiver = mReceivers.find(lReceiverId);
+    if (lReceiver == mReceivers.end()) {
+        return Usage();
+    }
+    return lReceiver->second.mUsage;
+}
 
 //---------------------------------------------------------------------------------------------------------------------
 //
@@ -26,7 +316,7 @@
 
 ElasticFrameProtocolReceiver::ElasticFrameProtocolReceiver(uint32_t lBucketTimeoutMasterms, uint32_t lHolTimeoutMasterms, std::shared_ptr<ElasticFrameProtocolContext> pCTX, EFPReceiverMode lReceiverMode) {
     //Throw if you can't reserve the data.
-    mBucketList = new Bucket[CIRCULAR_BUFFER_SIZE + 1];
+    allocateBucketList();
 
     mCTX = std::move(pCTX);
     c_recieveCallback = nullptr;
@@ -41,8 +331,18 @@ ElasticFrameProtocolReceiver::ElasticFrameProtocolReceiver(uint32_t lBucketTimeo
         mThreadActive = true;
         mIsWorkerThreadActive = true;
         mIsDeliveryThreadActive = true;
-        std::thread(std::bind(&ElasticFrameProtocolReceiver::receiverWorker, this)).detach();
-        std::thread(std::bind(&ElasticFrameProtocolReceiver::deliveryWorker, this)).detach();
+        startThread(&mReceiverThread, "rx", std::bind(&ElasticFrameProtocolReceiver::receiverWorker, this));
+        startThread(&mDeliveryThread, "dlv", std::bind(&ElasticFrameProtocolReceiver::deliveryWorker, this));
+    } else if (mCurrentMode == EFPReceiverMode::PULL) {
+#ifdef __linux__
+        mReadinessFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (mReadinessFd < 0) {
+            EFP_LOGGER(true, LOGG_ERROR, "Failed creating the readiness eventfd")
+        }
+#endif
+        mThreadActive = true;
+        mIsWorkerThreadActive = true;
+        startThread(&mReceiverThread, "rx", std::bind(&ElasticFrameProtocolReceiver::receiverWorker, this));
     }
     EFP_LOGGER(true, LOGG_NOTIFY, "ElasticFrameProtocol constructed")
 }
@@ -54,8 +354,15 @@ ElasticFrameProtocolReceiver::~ElasticFrameProtocolReceiver() {
             EFP_LOGGER(true, LOGG_ERROR, "Failed stopping worker thread.")
         }
     }
-    //We allocated so this cant be a nullptr
-    delete[] mBucketList;
+#ifdef __linux__
+    if (mReadinessFd >= 0) {
+        close(mReadinessFd);
+    }
+#endif
+    if (mMemoryBudget) {
+        mMemoryBudget->detach(mMemoryBudgetId);
+    }
+    freeBucketList();
     EFP_LOGGER(true, LOGG_NOTIFY, "ElasticFrameProtocol destruct")
 }
 
@@ -64,24 +371,20 @@ void ElasticFrameProtocolReceiver::gotData(ElasticFrameProtocolReceiver::pFrameP
     if (c_recieveCallback) {
         size_t payloadDataPosition = 0;
         if (c_recieveEmbeddedDataCallback && (rPacket->mFlags & (uint8_t)INLINE_PAYLOAD) && !rPacket->mBroken) {
-            std::vector<std::vector<uint8_t>> embeddedData;
-            std::vector<uint8_t> embeddedContentFlag;
-
-            //This method is not optimal since it moves data.. and there is no need to move any data. FIXME.
-            ElasticFrameMessages info = extractEmbeddedData(rPacket, &embeddedData, &embeddedContentFlag,
-                                                            &payloadDataPosition);
-            if (info != ElasticFrameMessages::noError) {
-                EFP_LOGGER(true, LOGG_ERROR, "extractEmbeddedData fail")
-                return;
-            }
-            for (int x = 0; x<embeddedData.size(); x++) {
-                c_recieveEmbeddedDataCallback(embeddedData[x].data(), embeddedData[x].size(), embeddedContentFlag[x], rPacket->mPts, mCTX->mUnsafePointer);
-            }
-            //Adjust the pointers for the payload callback
-            if (rPacket->mFrameSize < payloadDataPosition) {
-                EFP_LOGGER(true, LOGG_ERROR, "extractEmbeddedData out of bounds")
-                return;
-            }
+            EmbeddedData lEmbeddedData;
+            // Validate all sections before delivering any of them
+            do {
+                if (nextEmbeddedData(rPacket, &payloadDataPosition, &lEmbeddedData) != ElasticFrameMessages::noError) {
+                    EFP_LOGGER(true, LOGG_ERROR, "extractEmbeddedData fail")
+                    return;
+                }
+            } while (!lEmbeddedData.mLast);
+            size_t lPosition = 0;
+            do {
+                nextEmbeddedData(rPacket, &lPosition, &lEmbeddedData);
+                c_recieveEmbeddedDataCallback(const_cast<uint8_t *>(lEmbeddedData.pData), lEmbeddedData.mSize,
+                                              lEmbeddedData.mDataContent, rPacket->mPts, mCTX->mUnsafePointer);
+            } while (!lEmbeddedData.mLast);
         }
         c_recieveCallback(rPacket->pFrameData + payloadDataPosition, //compensate for the embedded data
                           rPacket->mFrameSize - payloadDataPosition, //compensate for the embedded data
@@ -115,6 +418,446 @@ uint64_t ElasticFrameProtocolReceiver::superFrameRecalculator(uint16_t lSuperFra
     return mSuperFrameRecalc;
 }
 
+// mNetMtx must be held by the caller
+// A fragment of superframe lSuperFrameNo maps to the bucket used by another superframe.
+// Depending on the policy deliver the old superframe as it is or drop it and let the caller reuse the bucket.
+// Superframes with higher priority than the fragment are not evicted. Newer superframes are never evicted by older fragments.
+bool ElasticFrameProtocolReceiver::evictBucket(Bucket *pBucket, uint16_t lSuperFrameNo, uint8_t lFlags) {
+    if (mEvictionPolicy == EFPEvictionPolicy::REJECT ||
+        (int16_t) (lSuperFrameNo - pBucket->mSavedSuperFrameNo) < 0 ||
+        (pBucket->mFlags & PRIORITY_MASK) > (lFlags & PRIORITY_MASK)) {
+        mEvictionCounters.mRejected++;
+        return false;
+    }
+
+    if (mEvictionPolicy == EFPEvictionPolicy::DELIVER_BROKEN) {
+        removeBucket(pBucket, true);
+        mEvictionCounters.mDelivered++;
+    } else {
+        removeBucket(pBucket, false);
+        mEvictionCounters.mDropped++;
+    }
+    return true;
+}
+
+// mNetMtx must be held by the caller
+// Take a superframe being assembled out of the delivery order. Deliver it now (most likely broken) or drop it.
+void ElasticFrameProtocolReceiver::removeBucket(Bucket *pBucket, bool lDeliver) {
+    // In HOL mode don't wait for the removed superframe or anything older, delivered or dropped
+    if (mHeadOfLineBlockingTimeoutms && !mDeliveryHOLFirstRun && pBucket->mDeliveryOrder >= mNextExpectedFrameNumber) {
+        mNextExpectedFrameNumber = pBucket->mDeliveryOrder + 1;
+    }
+    if (lDeliver) {
+        deliverBucketNow(pBucket);
+    }
+    mBucketMap.erase(pBucket->mDeliveryOrder);
+    pBucket->mActive = false;
+    pBucket->mBucketData = nullptr;
+}
+
+// mNetMtx must be held by the caller
+// Deliver the superframe of a bucket outside of the normal delivery. In run to completion mode it's delivered by
+// runToCompletionMethod else it's pushed when mNetMtx is released (by receiveFragment or the worker if the queue may block)
+void ElasticFrameProtocolReceiver::deliverBucketNow(Bucket *pBucket) {
+    if (mCurrentMode == EFPReceiverMode::RUN_TO_COMPLETION) {
+        prepareSuperFrame(pBucket);
+        mEvictedSuperFrames.push_back(std::move(pBucket->mBucketData));
+    } else {
+        queueSuperFrame(pBucket);
+    }
+}
+
+// mNetMtx must be held by the caller
+// A jump in the superframe numbers of a source larger than the threshold is a discontinuity (the sender restarted or
+// the counter jumped). The stale buckets are delivered or dropped and the delivery order continues from where it was.
+void ElasticFrameProtocolReceiver::checkDiscontinuity(uint16_t lSuperFrameNo, uint8_t lSource) {
+    if (!mDiscontinuityThreshold) {
+        return;
+    }
+    uint16_t lLastSuperFrameNo = mLastSuperFrameNo[lSource];
+    mLastSuperFrameNo[lSource] = lSuperFrameNo;
+    if (!mHaveLastSuperFrameNo[lSource]) {
+        mHaveLastSuperFrameNo[lSource] = true;
+        return;
+    }
+    if (std::abs((int32_t) (int16_t) (lSuperFrameNo - lLastSuperFrameNo)) <= (int32_t) mDiscontinuityThreshold) {
+        return;
+    }
+
+    // Only the superframes of the source that jumped are stale
+    for (auto lIt = mBucketMap.begin(); lIt != mBucketMap.end();) {
+        Bucket *pBucket = lIt->second;
+        if (pBucket->mSource != lSource) {
+            ++lIt;
+            continue;
+        }
+        // Never deliver superframes older than the head in HOL mode
+        bool lOlderThanHead = mHeadOfLineBlockingTimeoutms && !mDeliveryHOLFirstRun && lIt->first < mNextExpectedFrameNumber;
+        if (mDeliverStaleBuckets && !lOlderThanHead) {
+            deliverBucketNow(pBucket);
+        }
+        pBucket->mActive = false;
+        pBucket->mBucketData = nullptr;
+        lIt = mBucketMap.erase(lIt);
+    }
+
+    // Continue the delivery order after the last superframe and expect that superframe next in HOL mode
+    if (!mSuperFrameFirstTime) {
+        mOldSuperFrameNumber = lSuperFrameNo - 1;
+        mNextExpectedFrameNumber = mSuperFrameRecalc + 1;
+    }
+    // The callback is called by reportDiscontinuities when receiveFragment has released mReceiveMtx and mNetMtx
+    if (discontinuityCallback) {
+        mDiscontinuities.push_back({lSource, lLastSuperFrameNo, lSuperFrameNo});
+    }
+}
+
+// Call the discontinuityCallback outside the locks (the user may call the receiver from the callback)
+void ElasticFrameProtocolReceiver::reportDiscontinuities() {
+    if (!discontinuityCallback) {
+        return;
+    }
+    std::vector<Discontinuity> lDiscontinuities;
+    {
+        std::lock_guard<std::mutex> lock(mNetMtx);
+        if (mDiscontinuities.empty()) {
+            return;
+        }
+        lDiscontinuities.swap(mDiscontinuities);
+    }
+    for (auto &rDiscontinuity: lDiscontinuities) {
+        discontinuityCallback(rDiscontinuity.mSource, rDiscontinuity.mLastSuperFrameNo, rDiscontinuity.mNewSuperFrameNo,
+                              mCTX ? mCTX.get() : nullptr);
+    }
+}
+
+ElasticFrameMessages ElasticFrameProtocolReceiver::setDiscontinuityDetection(uint16_t lThreshold, bool lDeliverStaleBuckets) {
+    std::lock_guard<std::mutex> lock(mNetMtx);
+    mDiscontinuityThreshold = lThreshold;
+    mDeliverStaleBuckets = lDeliverStaleBuckets;
+    for (auto &rHave: mHaveLastSuperFrameNo) {
+        rHave = false;
+    }
+    return ElasticFrameMessages::noError;
+}
+
+void ElasticFrameProtocolReceiver::copyToBucket(Bucket *pBucket, size_t lOffset, const uint8_t *pSrc, size_t lSize) {
+    copyData(pBucket->mBucketData->pFrameData + lOffset, pSrc, lSize,
+             pBucket->mBucketData->mFrameSize >= mNonTemporalThreshold);
+}
+
+// mNetMtx must be held by the caller (or called from the constructor)
+// Allocate the bucket list as set by setHugePages and setNumaNode. The buckets are moved to the new list so superframes
+// being assembled are kept
+void ElasticFrameProtocolReceiver::allocateBucketList() {
+    Bucket *pNewList = nullptr;
+    size_t lMappedSize = 0;
+#ifdef __linux__
+    if (mHugePages || mNumaNode >= 0) {
+        auto *pMemory = mapMemory(sizeof(Bucket) * (CIRCULAR_BUFFER_SIZE + 1), mHugePages, mHugePagePreFault,
+                                  mNumaNode, &lMappedSize);
+        if (pMemory) {
+            pNewList = (Bucket *) pMemory;
+            for (size_t x = 0; x <= CIRCULAR_BUFFER_SIZE; x++) {
+                new(&pNewList[x]) Bucket();
+            }
+        }
+    }
+#endif
+    if (!pNewList) {
+        //Throw if you can't reserve the data.
+        pNewList = new Bucket[CIRCULAR_BUFFER_SIZE + 1];
+        lMappedSize = 0;
+    }
+    if (mBucketList) {
+        for (size_t x = 0; x <= CIRCULAR_BUFFER_SIZE; x++) {
+            pNewList[x] = std::move(mBucketList[x]);
+        }
+        for (auto &rBucket: mBucketMap) {
+            rBucket.second = pNewList + (rBucket.second - mBucketList);
+        }
+        freeBucketList();
+    }
+    mBucketList = pNewList;
+    mBucketListMappedSize = lMappedSize;
+}
+
+void ElasticFrameProtocolReceiver::freeBucketList() {
+#ifdef __linux__
+    if (mBucketListMappedSize) {
+        for (size_t x = 0; x <= CIRCULAR_BUFFER_SIZE; x++) {
+            mBucketList[x].~Bucket();
+        }
+        munmap(mBucketList, mBucketListMappedSize);
+        mBucketList = nullptr;
+        return;
+    }
+#endif
+    delete[] mBucketList;
+    mBucketList = nullptr;
+}
+
+ElasticFrameMessages ElasticFrameProtocolReceiver::setHugePages(bool lEnable, size_t lThreshold, bool lPreFault) {
+#ifdef __linux__
+    std::lock_guard<std::mutex> lock(mNetMtx);
+    mMapThreshold = lThreshold;
+    mHugePagePreFault = lPreFault;
+    if (lEnable != mHugePages) {
+        mHugePages = lEnable;
+        allocateBucketList();
+    }
+    return ElasticFrameMessages::noError;
+#else
+    return ElasticFrameMessages::notImplemented;
+#endif
+}
+
+// Name, pin and schedule a EFP thread as set by setThreadConfig and setNumaNode
+bool ElasticFrameProtocolReceiver::configureThread(const EFPThread &rThread) {
+#ifdef __linux__
+    bool lSuccess = true;
+    // Linux thread names are max 15 characters
+    std::string lName = mThreadConfig.mName.substr(0, 14 - std::min<size_t>(rThread.mRole.size(), 14)) + "-" + rThread.mRole;
+    if (pthread_setname_np(rThread.mHandle, lName.substr(0, 15).c_str())) {
+        EFP_LOGGER(true, LOGG_WARN, "Failed setting the thread name")
+        lSuccess = false;
+    }
+    if (mThreadsPinned && pthread_setaffinity_np(rThread.mHandle, sizeof(cpu_set_t), &mThreadCpus)) {
+        EFP_LOGGER(true, LOGG_WARN, "Failed setting the thread affinity")
+        lSuccess = false;
+    }
+    if (!mThreadConfigSet) {
+        return lSuccess;
+    }
+    sched_param lParam = {};
+    int lPolicy = SCHED_OTHER;
+    if (mThreadConfig.mPolicy == EFPThreadPolicy::FIFO) {
+        lPolicy = SCHED_FIFO;
+        lParam.sched_priority = mThreadConfig.mPriority;
+    } else if (mThreadConfig.mPolicy == EFPThreadPolicy::RR) {
+        lPolicy = SCHED_RR;
+        lParam.sched_priority = mThreadConfig.mPriority;
+    }
+    if (pthread_setschedparam(rThread.mHandle, lPolicy, &lParam)) {
+        EFP_LOGGER(true, LOGG_WARN, "Failed setting the thread scheduling")
+        lSuccess = false;
+    }
+    // The nice value is per thread on Linux
+    if (lPolicy == SCHED_OTHER && setpriority(PRIO_PROCESS, (id_t)rThread.mTid, mThreadConfig.mNice)) {
+        EFP_LOGGER(true, LOGG_WARN, "Failed setting the thread nice value")
+        lSuccess = false;
+    }
+    return lSuccess;
+#else
+    return true;
+#endif
+}
+
+bool ElasticFrameProtocolReceiver::configureThreads() {
+    bool lSuccess = true;
+    if (mIsWorkerThreadActive && mReceiverThread.mTid) {
+        lSuccess &= configureThread(mReceiverThread);
+    }
+    if (mIsDeliveryThreadActive && mDeliveryThread.mTid) {
+        lSuccess &= configureThread(mDeliveryThread);
+    }
+    // The lanes are only created and destroyed while holding mNetMtx
+    std::lock_guard<std::mutex> lock(mNetMtx);
+    for (auto &rLane: mDeliveryLanes) {
+        if (rLane && rLane->mThreadActive && rLane->mThread.mTid) {
+            lSuccess &= configureThread(rLane->mThread);
+        }
+    }
+    return lSuccess;
+}
+
+void ElasticFrameProtocolReceiver::updateThreadCpus() {
+#ifdef __linux__
+    CPU_ZERO(&mThreadCpus);
+    if (!mThreadConfig.mCpus.empty()) {
+        for (auto lCpu: mThreadConfig.mCpus) {
+            if (lCpu >= 0 && lCpu < CPU_SETSIZE) {
+                CPU_SET(lCpu, &mThreadCpus);
+            }
+        }
+    } else if (mNumaPinned) {
+        mThreadCpus = mNumaCpus;
+    } else {
+        // Unpin the threads pinned earlier
+        for (int lCpu = 0; lCpu < CPU_SETSIZE; lCpu++) {
+            CPU_SET(lCpu, &mThreadCpus);
+        }
+    }
+    mThreadsPinned |= !mThreadConfig.mCpus.empty() || mNumaPinned;
+#endif
+}
+
+void ElasticFrameProtocolReceiver::startThread(EFPThread *pThread, const std::string &rRole,
+                                               const std::function<void()> &rFunction) {
+    // Not seen by configureThreads yet. The worker threads are started by the constructor and the lanes holding mNetMtx
+    pThread->mRole = rRole;
+    pThread->mTid = 0;
+    // The thread configures itself so a configuration set while it starts is not lost
+    std::thread([this, pThread, rFunction] {
+        {
+            std::lock_guard<std::mutex> lock(mThreadConfigMtx);
+#ifdef __linux__
+            pThread->mHandle = pthread_self();
+            pThread->mTid = syscall(SYS_gettid);
+#else
+            pThread->mTid = 1;
+#endif
+            configureThread(*pThread);
+        }
+        rFunction();
+    }).detach();
+}
+
+ElasticFrameMessages ElasticFrameProtocolReceiver::setThreadConfig(const ThreadConfig &rConfig) {
+#ifdef __linux__
+    if (rConfig.mPolicy != EFPThreadPolicy::OTHER) {
+        int lPolicy = rConfig.mPolicy == EFPThreadPolicy::FIFO ? SCHED_FIFO : SCHED_RR;
+        if (rConfig.mPriority < sched_get_priority_min(lPolicy) || rConfig.mPriority > sched_get_priority_max(lPolicy)) {
+            return ElasticFrameMessages::threadConfigFailed;
+        }
+    }
+    std::lock_guard<std::mutex> lock(mThreadConfigMtx);
+    mThreadConfig = rConfig;
+    mThreadConfigSet = true;
+    updateThreadCpus();
+    if (!configureThreads()) {
+        return ElasticFrameMessages::threadConfigFailed;
+    }
+    return ElasticFrameMessages::noError;
+#else
+    return ElasticFrameMessages::notImplemented;
+#endif
+}
+
+ElasticFrameMessages ElasticFrameProtocolReceiver::setNumaNode(int32_t lNode) {
+#ifdef __linux__
+    cpu_set_t lCpus;
+    CPU_ZERO(&lCpus);
+    if (lNode >= 0) {
+        if (lNode >= MAX_NUMA_NODES || !getNodeCpus(lNode, &lCpus)) {
+            return ElasticFrameMessages::numaNodeNotAvailable;
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(mThreadConfigMtx);
+        mNumaCpus = lCpus;
+        mNumaPinned = lNode >= 0;
+        updateThreadCpus();
+        configureThreads();
+    }
+    std::lock_guard<std::mutex> lock(mNetMtx);
+    mNumaNode = lNode < 0 ? -1 : lNode;
+    allocateBucketList();
+    return ElasticFrameMessages::noError;
+#else
+    return ElasticFrameMessages::notImplemented;
+#endif
+}
+
+void ElasticFrameProtocolReceiver::setNonTemporalCopyThreshold(size_t lBytes) {
+    std::lock_guard<std::mutex> lock(mNetMtx);
+    mNonTemporalThreshold = lBytes;
+}
+
+ElasticFrameMessages ElasticFrameProtocolReceiver::setSingleFragmentView(bool lEnable) {
+    if (mCurrentMode != EFPReceiverMode::RUN_TO_COMPLETION) {
+        return ElasticFrameMessages::notImplemented;
+    }
+    std::lock_guard<std::mutex> lock(mNetMtx);
+    mSingleFragmentView = lEnable;
+    return ElasticFrameMessages::noError;
+}
+
+ElasticFrameMessages ElasticFrameProtocolReceiver::setEvictionPolicy(EFPEvictionPolicy lPolicy) {
+    std::lock_guard<std::mutex> lock(mNetMtx);
+    mEvictionPolicy = lPolicy;
+    return ElasticFrameMessages::noError;
+}
+
+ElasticFrameProtocolReceiver::EvictionCounters ElasticFrameProtocolReceiver::getEvictionCounters() {
+    std::lock_guard<std::mutex> lock(mNetMtx);
+    return mEvictionCounters;
+}
+
+ElasticFrameMessages ElasticFrameProtocolReceiver::setMemoryBudget(std::shared_ptr<ElasticFrameProtocolMemoryBudget> pBudget) {
+    std::lock_guard<std::mutex> lock(mNetMtx);
+    if (mMemoryBudget) {
+        mMemoryBudget->detach(mMemoryBudgetId);
+    }
+    mMemoryBudget = std::move(pBudget);
+    if (mMemoryBudget) {
+        mMemoryBudgetId = mMemoryBudget->attach();
+    }
+    return ElasticFrameMessages::noError;
+}
+
+ElasticFrameProtocolMemoryBudget::Usage ElasticFrameProtocolReceiver::getMemoryUsage() {
+    std::lock_guard<std::mutex> lock(mNetMtx);
+    if (!mMemoryBudget) {
+        return ElasticFrameProtocolMemoryBudget::Usage();
+    }
+    return mMemoryBudget->getUsage(mMemoryBudgetId);
+}
+
+// mNetMtx must be held by the caller
+ElasticFrameMessages ElasticFrameProtocolReceiver::allocateSuperFrame(pFramePtr &rFrame, size_t lSize, Bucket *pBucket) {
+    if (mMemoryBudget) {
+        bool lReserved = mMemoryBudget->reserve(mMemoryBudgetId, pBucket->mSource, lSize);
+        // Refused. Drop the oldest superframes being assembled that return memory to the budget. They are dropped
+        // whatever the eviction policy, a superframe delivered broken is charged until the host destroys it.
+        // Superframes newer than this one or with higher priority are kept.
+        auto lIt = mBucketMap.begin();
+        while (!lReserved && mEvictionPolicy != EFPEvictionPolicy::REJECT && lIt != mBucketMap.end()) {
+            Bucket *pOldest = lIt->second;
+            if ((int16_t) (pBucket->mSavedSuperFrameNo - pOldest->mSavedSuperFrameNo) < 0) {
+                break;
+            }
+            ++lIt;
+            if (pOldest == pBucket || !pOldest->mBucketData || pOldest->mBucketData->mBudget != mMemoryBudget ||
+                (pOldest->mFlags & PRIORITY_MASK) > (pBucket->mFlags & PRIORITY_MASK)) {
+                continue;
+            }
+            removeBucket(pOldest, false);
+            mEvictionCounters.mBudgetDropped++;
+            lReserved = mMemoryBudget->reserve(mMemoryBudgetId, pBucket->mSource, lSize);
+        }
+        if (!lReserved) {
+            mEvictionCounters.mBudgetRefused++;
+            return ElasticFrameMessages::memoryBudgetExceeded;
+        }
+    }
+    rFrame = nullptr;
+#ifdef __linux__
+    if ((mHugePages || mNumaNode >= 0) && lSize >= mMapThreshold) {
+        size_t lMappedSize = 0;
+        uint8_t *pData = mapMemory(lSize, mHugePages, mHugePagePreFault, mNumaNode, &lMappedSize);
+        if (pData) {
+            rFrame.reset(new SuperFrame(pData, lSize, lMappedSize));
+        }
+    }
+#endif
+    if (!rFrame) {
+        rFrame = std::make_unique<SuperFrame>(lSize);
+    }
+    if (mMemoryBudget) {
+        // From now on the destructor of the superframe returns the memory
+        rFrame->mBudget = mMemoryBudget;
+        rFrame->mBudgetReceiverId = mMemoryBudgetId;
+        rFrame->mBudgetSource = pBucket->mSource;
+        rFrame->mBudgetBytes = lSize;
+    }
+    if (rFrame->pFrameData == nullptr) {
+        rFrame = nullptr;
+        return ElasticFrameMessages::memoryAllocationError;
+    }
+    return ElasticFrameMessages::noError;
+}
+
 // Unpack method for type1 packets. Type1 packets are the parts of superFrames larger than the MTU
 ElasticFrameMessages
 ElasticFrameProtocolReceiver::unpackType1(const uint8_t *pSubPacket, size_t lPacketSize, uint8_t lFromSource) {
@@ -125,6 +868,15 @@ ElasticFrameProtocolReceiver::unpackType1(const uint8_t *pSubPacket, size_t lPac
     //EFP_LOGGER(false, LOGG_NOTIFY, "superFrameNo1-> " << unsigned(type1Frame.superFrameNo))
 
     // Is this entry in the buffer active? If no, create a new else continue filling the bucket with fragments.
+    // Did the sender restart or jump? Then get rid of the stale buckets first
+    checkDiscontinuity(lType1Frame->hSuperFrameNo, lFromSource);
+
+    // The bucket is still used by another superframe mapping to the same slot. Evict it if the policy allows
+    if (pThisBucket->mActive && lType1Frame->hSuperFrameNo != pThisBucket->mSavedSuperFrameNo &&
+        !evictBucket(pThisBucket, lType1Frame->hSuperFrameNo, lType1Frame->hFrameType)) {
+        return ElasticFrameMessages::bufferOutOfResources;
+    }
+
     if (!pThisBucket->mActive) {
         //EFP_LOGGER(false,LOGG_NOTIFY,"Setting: " << unsigned(type1Frame.superFrameNo));
         uint64_t lDeliveryOrderCandidate = superFrameRecalculator(lType1Frame->hSuperFrameNo);
@@ -144,34 +896,33 @@ ElasticFrameProtocolReceiver::unpackType1(const uint8_t *pSubPacket, size_t lPac
         pThisBucket->mCode = pThisStream->mCode;
         pThisBucket->mSavedSuperFrameNo = lType1Frame->hSuperFrameNo;
         pThisBucket->mHaveReceivedFragment.reset();
+        pThisBucket->mFECParity.clear();
         pThisBucket->mPts = UINT64_MAX;
         pThisBucket->mDts = UINT64_MAX;
         pThisBucket->mHaveReceivedFragment[lType1Frame->hFragmentNo] = true;
-        pThisBucket->mTimeout = std::chrono::duration_cast<std::chrono::microseconds>(
-                std::chrono::steady_clock::now().time_since_epoch()).count() + (mBucketTimeoutms * 1000);
+        pThisBucket->mTimeout = bucketDeadline(pThisBucket, lType1Frame->hFragmentNo, true);
+        pThisBucket->mNextNackTime = pThisBucket->mLastFragmentTime + (mNackDelayms * 1000);
+        pThisBucket->mNackCounter = 0;
+        pThisBucket->mContiguousFragments = 0;
         pThisBucket->mFragmentCounter = 0;
         pThisBucket->mOfFragmentNo = lType1Frame->hOfFragmentNo;
         pThisBucket->mFragmentSize = (lPacketSize - sizeof(ElasticFrameType1));
         size_t lInsertDataPointer = pThisBucket->mFragmentSize * lType1Frame->hFragmentNo;
-        pThisBucket->mBucketData = std::make_unique<SuperFrame>(
-                pThisBucket->mFragmentSize * ((size_t) lType1Frame->hOfFragmentNo + 1));
-        pThisBucket->mBucketData->mFrameSize = pThisBucket->mFragmentSize * lType1Frame->hOfFragmentNo;
-
-        if (pThisBucket->mBucketData->pFrameData == nullptr) {
+        ElasticFrameMessages lAllocStatus = allocateSuperFrame(pThisBucket->mBucketData,
+                pThisBucket->mFragmentSize * ((size_t) lType1Frame->hOfFragmentNo + 1), pThisBucket);
+        if (lAllocStatus != ElasticFrameMessages::noError) {
             mBucketMap.erase(pThisBucket->mDeliveryOrder);
             pThisBucket->mActive = false;
-            return ElasticFrameMessages::memoryAllocationError;
+            return lAllocStatus;
+        }
+        pThisBucket->mBucketData->mFrameSize = pThisBucket->mFragmentSize * lType1Frame->hOfFragmentNo;
+        copyToBucket(pThisBucket, lInsertDataPointer, pSubPacket + sizeof(ElasticFrameType1), lPacketSize - sizeof(ElasticFrameType1));
+        if (receiveChunkCallback) {
+            deliverChunks(pThisBucket);
         }
-        std::copy_n(pSubPacket + sizeof(ElasticFrameType1), lPacketSize - sizeof(ElasticFrameType1), pThisBucket->mBucketData->pFrameData + lInsertDataPointer);
         return ElasticFrameMessages::noError;
     }
 
-    // There is a gap in receiving the packets. Increase the bucket size list.. if the
-    // bucket size list is == X*UINT16_MAX you will no longer detect any buffer errors
-    if (lType1Frame->hSuperFrameNo != pThisBucket->mSavedSuperFrameNo) {
-        return ElasticFrameMessages::bufferOutOfResources;
-    }
-
     // I'm getting a packet with data larger than the expected size
     // this can be generated by wraparound in the bucket bucketList
     // The notification about more than 50% buffer full level should already
@@ -194,8 +945,7 @@ ElasticFrameProtocolReceiver::unpackType1(const uint8_t *pSubPacket, size_t lPac
     }
 
     // Let's re-set the timout and let also add +1 to the fragment counter
-    pThisBucket->mTimeout =  std::chrono::duration_cast<std::chrono::microseconds>(
-            std::chrono::steady_clock::now().time_since_epoch()).count() + (mBucketTimeoutms * 1000);
+    pThisBucket->mTimeout = bucketDeadline(pThisBucket, lType1Frame->hFragmentNo, false);
     pThisBucket->mFragmentCounter++;
 
     // Move the data to the correct fragment position in the frame.
@@ -205,16 +955,71 @@ ElasticFrameProtocolReceiver::unpackType1(const uint8_t *pSubPacket, size_t lPac
     // lInsertDataPointer will point to the fragment start above and fill with the incoming data
 
     size_t lInsertDataPointer = pThisBucket->mFragmentSize * lType1Frame->hFragmentNo;
-    std::copy_n(pSubPacket + sizeof(ElasticFrameType1), lPacketSize - sizeof(ElasticFrameType1), pThisBucket->mBucketData->pFrameData + lInsertDataPointer);
+    copyToBucket(pThisBucket, lInsertDataPointer, pSubPacket + sizeof(ElasticFrameType1), lPacketSize - sizeof(ElasticFrameType1));
+
+    // If we hold FEC parity for the group this fragment belongs to we might be able to rebuild a lost fragment now
+    if (!pThisBucket->mFECParity.empty()) {
+        recoverWithFEC(pThisBucket, lType1Frame->hFragmentNo);
+    }
+    if (receiveChunkCallback) {
+        deliverChunks(pThisBucket);
+    }
     return ElasticFrameMessages::noError;
 }
 
-// Unpack method for type2 packets. Where we know there is also type 1 packets involved and possibly type3.
-// Type2 packets are also parts of frames smaller than the MTU
-// The data IS the last data of a sequence
-
-ElasticFrameMessages ElasticFrameProtocolReceiver::unpackType2(const uint8_t *pSubPacket, size_t lPacketSize, uint8_t lFromSource) {
-    std::lock_guard<std::mutex> lock(mNetMtx);
+// mNetMtx must be held by the caller
+// Deliver a superframe carried by a single type2 fragment without claiming the bucket (no map insert, no reset of the
+// fragment bit-mask and no wait for the worker). The bucket is only used to hold the superframe while delivering it
+// and to remember the delivery order so duplicates are detected.
+ElasticFrameMessages ElasticFrameProtocolReceiver::deliverSingleFragment(Bucket *pBucket, const uint8_t *pSubPacket,
+                                                                         uint64_t lDeliveryOrder, uint8_t lFromSource) {
+    auto *lType2Frame = (ElasticFrameType2 *) pSubPacket;
+    pBucket->mDeliveryOrder = lDeliveryOrder;
+    pBucket->mSource = lFromSource;
+    pBucket->mFlags = lType2Frame->hFrameType & (uint8_t)0xf0;
+    pBucket->mStream = lType2Frame->hStreamID;
+    Stream *pThisStream = &mStreams[lType2Frame->hStreamID];
+    pThisStream->mDataContent = lType2Frame->hDataContent;
+    pThisStream->mCode = lType2Frame->hCode;
+    pBucket->mDataContent = pThisStream->mDataContent;
+    pBucket->mCode = pThisStream->mCode;
+    pBucket->mSavedSuperFrameNo = lType2Frame->hSuperFrameNo;
+    pBucket->mPts = lType2Frame->hPts;
+    if (lType2Frame->hDtsPtsDiff == UINT32_MAX) {
+        pBucket->mDts = UINT64_MAX;
+    } else {
+        pBucket->mDts = lType2Frame->hPts - (uint64_t) lType2Frame->hDtsPtsDiff;
+    }
+    pBucket->mOfFragmentNo = 0;
+    pBucket->mFragmentCounter = 0;
+    pBucket->mFragmentSize = lType2Frame->hType1PacketSize;
+    pBucket->mTimeout = bucketDeadline(pBucket, 0, true);
+
+    if (mSingleFragmentView) {
+        // Points to the fragment. Only valid until receiveFragment returns
+        pBucket->mBucketData = std::make_unique<SuperFrame>(const_cast<uint8_t *>(pSubPacket + sizeof(ElasticFrameType2)),
+                                                            lType2Frame->hSizeOfData);
+    } else {
+        ElasticFrameMessages lAllocStatus = allocateSuperFrame(pBucket->mBucketData, lType2Frame->hSizeOfData, pBucket);
+        if (lAllocStatus != ElasticFrameMessages::noError) {
+            return lAllocStatus;
+        }
+        copyToBucket(pBucket, 0, pSubPacket + sizeof(ElasticFrameType2), lType2Frame->hSizeOfData);
+    }
+    if (mHeadOfLineBlockingTimeoutms) {
+        mNextExpectedFrameNumber++;
+    }
+    deliverBucketNow(pBucket);
+    pBucket->mBucketData = nullptr;
+    return ElasticFrameMessages::noError;
+}
+
+// Unpack method for type2 packets. Where we know there is also type 1 packets involved and possibly type3.
+// Type2 packets are also parts of frames smaller than the MTU
+// The data IS the last data of a sequence
+
+ElasticFrameMessages ElasticFrameProtocolReceiver::unpackType2(const uint8_t *pSubPacket, size_t lPacketSize, uint8_t lFromSource) {
+    std::lock_guard<std::mutex> lock(mNetMtx);
     auto *lType2Frame = (ElasticFrameType2 *) pSubPacket;
 
     if (lPacketSize < ((sizeof(ElasticFrameType2) + lType2Frame->hSizeOfData))) {
@@ -223,6 +1028,15 @@ ElasticFrameMessages ElasticFrameProtocolReceiver::unpackType2(const uint8_t *pS
 
     Bucket *pThisBucket = &mBucketList[lType2Frame->hSuperFrameNo & (uint16_t)CIRCULAR_BUFFER_SIZE];
 
+    // Did the sender restart or jump? Then get rid of the stale buckets first
+    checkDiscontinuity(lType2Frame->hSuperFrameNo, lFromSource);
+
+    // The bucket is still used by another superframe mapping to the same slot. Evict it if the policy allows
+    if (pThisBucket->mActive && lType2Frame->hSuperFrameNo != pThisBucket->mSavedSuperFrameNo &&
+        !evictBucket(pThisBucket, lType2Frame->hSuperFrameNo, lType2Frame->hFrameType)) {
+        return ElasticFrameMessages::bufferOutOfResources;
+    }
+
     if (!pThisBucket->mActive) {
         uint64_t lDeliveryOrderCandidate = superFrameRecalculator(lType2Frame->hSuperFrameNo);
         //Is this a old fragment where we already delivered the super frame?
@@ -230,6 +1044,15 @@ ElasticFrameMessages ElasticFrameProtocolReceiver::unpackType2(const uint8_t *pS
             return ElasticFrameMessages::tooOldFragment;
         }
 
+        // A complete superframe in a single fragment. Deliver it now unless HOL mode is waiting for something else or
+        // an older superframe is still assembled (it would be overtaken)
+        if (lType2Frame->hOfFragmentNo == 0 && !receiveChunkCallback &&
+            (!mHeadOfLineBlockingTimeoutms ||
+             (!mDeliveryHOLFirstRun && lDeliveryOrderCandidate == mNextExpectedFrameNumber)) &&
+            (mBucketMap.empty() || mBucketMap.begin()->first > lDeliveryOrderCandidate)) {
+            return deliverSingleFragment(pThisBucket, pSubPacket, lDeliveryOrderCandidate, lFromSource);
+        }
+
         pThisBucket->mDeliveryOrder = lDeliveryOrderCandidate;
         mBucketMap[pThisBucket->mDeliveryOrder] = pThisBucket;
         pThisBucket->mActive = true;
@@ -243,6 +1066,7 @@ ElasticFrameMessages ElasticFrameProtocolReceiver::unpackType2(const uint8_t *pS
         pThisBucket->mCode = pThisStream->mCode;
         pThisBucket->mSavedSuperFrameNo = lType2Frame->hSuperFrameNo;
         pThisBucket->mHaveReceivedFragment.reset();
+        pThisBucket->mFECParity.clear();
         pThisBucket->mPts = lType2Frame->hPts;
 
         if (lType2Frame->hDtsPtsDiff == UINT32_MAX) {
@@ -252,26 +1076,36 @@ ElasticFrameMessages ElasticFrameProtocolReceiver::unpackType2(const uint8_t *pS
         }
 
         pThisBucket->mHaveReceivedFragment[lType2Frame->hOfFragmentNo] = true;
-        pThisBucket->mTimeout =  std::chrono::duration_cast<std::chrono::microseconds>(
-                std::chrono::steady_clock::now().time_since_epoch()).count() + (mBucketTimeoutms * 1000);
+        pThisBucket->mTimeout = bucketDeadline(pThisBucket, lType2Frame->hOfFragmentNo, true);
+        pThisBucket->mNextNackTime = pThisBucket->mLastFragmentTime + (mNackDelayms * 1000);
+        pThisBucket->mNackCounter = 0;
+        pThisBucket->mContiguousFragments = 0;
         pThisBucket->mOfFragmentNo = lType2Frame->hOfFragmentNo;
         pThisBucket->mFragmentCounter = 0;
         pThisBucket->mFragmentSize = lType2Frame->hType1PacketSize;
         size_t lReserveThis = ((pThisBucket->mFragmentSize * lType2Frame->hOfFragmentNo) +
                                lType2Frame->hSizeOfData);
-        pThisBucket->mBucketData = std::make_unique<SuperFrame>(lReserveThis);
-        if (pThisBucket->mBucketData->pFrameData == nullptr) {
+        ElasticFrameMessages lAllocStatus = allocateSuperFrame(pThisBucket->mBucketData, lReserveThis, pThisBucket);
+        if (lAllocStatus != ElasticFrameMessages::noError) {
             mBucketMap.erase(pThisBucket->mDeliveryOrder);
             pThisBucket->mActive = false;
-            return ElasticFrameMessages::memoryAllocationError;
+            return lAllocStatus;
         }
         size_t lInsertDataPointer = (size_t) lType2Frame->hType1PacketSize * (size_t) lType2Frame->hOfFragmentNo;
-        std::copy_n(pSubPacket + sizeof(ElasticFrameType2), lType2Frame->hSizeOfData, pThisBucket->mBucketData->pFrameData + lInsertDataPointer);
+        copyToBucket(pThisBucket, lInsertDataPointer, pSubPacket + sizeof(ElasticFrameType2), lType2Frame->hSizeOfData);
+        if (receiveChunkCallback) {
+            deliverChunks(pThisBucket);
+        }
         return ElasticFrameMessages::noError;
     }
 
-    if (lType2Frame->hSuperFrameNo != pThisBucket->mSavedSuperFrameNo) {
-        return ElasticFrameMessages::bufferOutOfResources;
+    // The end of a streamed superframe
+    if (pThisBucket->mOfFragmentNo == UINT16_MAX) {
+        ElasticFrameMessages lStatus = endStreamedBucket(pThisBucket, lType2Frame->hOfFragmentNo, lType2Frame->hType1PacketSize,
+                                                         ((size_t) lType2Frame->hType1PacketSize * lType2Frame->hOfFragmentNo) + lType2Frame->hSizeOfData);
+        if (lStatus != ElasticFrameMessages::noError) {
+            return lStatus;
+        }
     }
 
     if (pThisBucket->mOfFragmentNo < lType2Frame->hOfFragmentNo ||
@@ -290,8 +1124,7 @@ ElasticFrameMessages ElasticFrameProtocolReceiver::unpackType2(const uint8_t *pS
 
     // Type 2 frames contains the pts and code. If for some reason the type2 packet is missing or the frame is delivered
     // Before the type2 frame arrives PTS,DTS and CODE are set to it's respective 'illegal' value. meaning you can't use them.
-    pThisBucket->mTimeout = std::chrono::duration_cast<std::chrono::microseconds>(
-            std::chrono::steady_clock::now().time_since_epoch()).count() + (mBucketTimeoutms * 1000);
+    pThisBucket->mTimeout = bucketDeadline(pThisBucket, lType2Frame->hOfFragmentNo, false);
     pThisBucket->mPts = lType2Frame->hPts;
 
     if (lType2Frame->hDtsPtsDiff == UINT32_MAX) {
@@ -318,7 +1151,10 @@ ElasticFrameMessages ElasticFrameProtocolReceiver::unpackType2(const uint8_t *pS
                 (pThisBucket->mFragmentSize * lType2Frame->hOfFragmentNo) + lType2Frame->hSizeOfData;
         // Type 2 is always at the end and is always the highest number fragment
         size_t lInsertDataPointer = (size_t) lType2Frame->hType1PacketSize * (size_t) lType2Frame->hOfFragmentNo;
-        std::copy_n(pSubPacket + sizeof(ElasticFrameType2), lType2Frame->hSizeOfData, pThisBucket->mBucketData->pFrameData + lInsertDataPointer);
+        copyToBucket(pThisBucket, lInsertDataPointer, pSubPacket + sizeof(ElasticFrameType2), lType2Frame->hSizeOfData);
+    }
+    if (receiveChunkCallback) {
+        deliverChunks(pThisBucket);
     }
     return ElasticFrameMessages::noError;
 }
@@ -337,6 +1173,15 @@ ElasticFrameProtocolReceiver::unpackType3(const uint8_t *pSubPacket, size_t lPac
     uint16_t lThisFragmentNo = lType3Frame->hOfFragmentNo - 1;
 
     // Is this entry in the buffer active? If no, create a new else continue filling the bucket with data.
+    // Did the sender restart or jump? Then get rid of the stale buckets first
+    checkDiscontinuity(lType3Frame->hSuperFrameNo, lFromSource);
+
+    // The bucket is still used by another superframe mapping to the same slot. Evict it if the policy allows
+    if (pThisBucket->mActive && lType3Frame->hSuperFrameNo != pThisBucket->mSavedSuperFrameNo &&
+        !evictBucket(pThisBucket, lType3Frame->hSuperFrameNo, lType3Frame->hFrameType)) {
+        return ElasticFrameMessages::bufferOutOfResources;
+    }
+
     if (!pThisBucket->mActive) {
         //EFP_LOGGER(false,LOGG_NOTIFY,"Setting: " << unsigned(type1Frame.superFrameNo));
         uint64_t lDeliveryOrderCandidate = superFrameRecalculator(lType3Frame->hSuperFrameNo);
@@ -356,32 +1201,40 @@ ElasticFrameProtocolReceiver::unpackType3(const uint8_t *pSubPacket, size_t lPac
         pThisBucket->mCode = thisStream->mCode;
         pThisBucket->mSavedSuperFrameNo = lType3Frame->hSuperFrameNo;
         pThisBucket->mHaveReceivedFragment.reset();
+        pThisBucket->mFECParity.clear();
         pThisBucket->mPts = UINT64_MAX;
         pThisBucket->mDts = UINT64_MAX;
         pThisBucket->mHaveReceivedFragment[lThisFragmentNo] = true;
-        pThisBucket->mTimeout = std::chrono::duration_cast<std::chrono::microseconds>(
-                std::chrono::steady_clock::now().time_since_epoch()).count() + (mBucketTimeoutms * 1000);
+        pThisBucket->mTimeout = bucketDeadline(pThisBucket, lThisFragmentNo, true);
+        pThisBucket->mNextNackTime = pThisBucket->mLastFragmentTime + (mNackDelayms * 1000);
+        pThisBucket->mNackCounter = 0;
+        pThisBucket->mContiguousFragments = 0;
         pThisBucket->mFragmentCounter = 0;
         pThisBucket->mOfFragmentNo = lType3Frame->hOfFragmentNo;
         pThisBucket->mFragmentSize = lType3Frame->hType1PacketSize;
         size_t lInsertDataPointer = pThisBucket->mFragmentSize * lThisFragmentNo;
         size_t lReserveThis = ((pThisBucket->mFragmentSize * (lType3Frame->hOfFragmentNo - 1)) +
                                (lPacketSize - sizeof(ElasticFrameType3)));
-        pThisBucket->mBucketData = std::make_unique<SuperFrame>(lReserveThis);
-
-        if (pThisBucket->mBucketData->pFrameData == nullptr) {
+        ElasticFrameMessages lAllocStatus = allocateSuperFrame(pThisBucket->mBucketData, lReserveThis, pThisBucket);
+        if (lAllocStatus != ElasticFrameMessages::noError) {
             mBucketMap.erase(pThisBucket->mDeliveryOrder);
             pThisBucket->mActive = false;
-            return ElasticFrameMessages::memoryAllocationError;
+            return lAllocStatus;
+        }
+        copyToBucket(pThisBucket, lInsertDataPointer, pSubPacket + sizeof(ElasticFrameType3), lPacketSize - sizeof(ElasticFrameType3));
+        if (receiveChunkCallback) {
+            deliverChunks(pThisBucket);
         }
-        std::copy_n(pSubPacket + sizeof(ElasticFrameType3),lPacketSize - sizeof(ElasticFrameType3), pThisBucket->mBucketData->pFrameData + lInsertDataPointer);
         return ElasticFrameMessages::noError;
     }
 
-    // There is a gap in receiving the packets. Increase the bucket size list.. if the
-    // bucket size list is == X*UINT16_MAX you will no longer detect any buffer errors
-    if (lType3Frame->hSuperFrameNo != pThisBucket->mSavedSuperFrameNo) {
-        return ElasticFrameMessages::bufferOutOfResources;
+    // The end of a streamed superframe
+    if (pThisBucket->mOfFragmentNo == UINT16_MAX) {
+        ElasticFrameMessages lStatus = endStreamedBucket(pThisBucket, lType3Frame->hOfFragmentNo, lType3Frame->hType1PacketSize,
+                                                         ((size_t) lType3Frame->hType1PacketSize * lThisFragmentNo) + (lPacketSize - sizeof(ElasticFrameType3)));
+        if (lStatus != ElasticFrameMessages::noError) {
+            return lStatus;
+        }
     }
 
     // I'm getting a packet with data larger than the expected size
@@ -405,8 +1258,7 @@ ElasticFrameProtocolReceiver::unpackType3(const uint8_t *pSubPacket, size_t lPac
     }
 
     // Let's re-set the timout and let also add +1 to the fragment counter
-    pThisBucket->mTimeout = std::chrono::duration_cast<std::chrono::microseconds>(
-            std::chrono::steady_clock::now().time_since_epoch()).count() + (mBucketTimeoutms * 1000);
+    pThisBucket->mTimeout = bucketDeadline(pThisBucket, lThisFragmentNo, false);
     pThisBucket->mFragmentCounter++;
 
     pThisBucket->mBucketData->mFrameSize =
@@ -420,14 +1272,511 @@ ElasticFrameProtocolReceiver::unpackType3(const uint8_t *pSubPacket, size_t lPac
     // lInsertDataPointer will point to the fragment start above and fill with the incoming data
 
     size_t lInsertDataPointer = pThisBucket->mFragmentSize * lThisFragmentNo;
-    std::copy_n(pSubPacket + sizeof(ElasticFrameType3), lPacketSize - sizeof(ElasticFrameType3), pThisBucket->mBucketData->pFrameData + lInsertDataPointer);
+    copyToBucket(pThisBucket, lInsertDataPointer, pSubPacket + sizeof(ElasticFrameType3), lPacketSize - sizeof(ElasticFrameType3));
+    if (receiveChunkCallback) {
+        deliverChunks(pThisBucket);
+    }
     return ElasticFrameMessages::noError;
 }
 
-//mNetMtx is already taken no need to lock anything
-void ElasticFrameProtocolReceiver::runToCompletionMethod(const std::function<void(pFramePtr &rPacket, ElasticFrameProtocolContext* pCTX)>& rReceiveFunction) {
+// mNetMtx must be held by the caller
+// Streamed superframes (type7) do not know the final size. Grow the superframe geometrically when the data does not fit.
+ElasticFrameMessages ElasticFrameProtocolReceiver::growBucket(Bucket *pBucket, size_t lSize) {
+    if (lSize <= pBucket->mBucketDataCapacity) {
+        return ElasticFrameMessages::noError;
+    }
+    size_t lNewCapacity = std::max(lSize, pBucket->mBucketDataCapacity * 2);
+    pFramePtr lNewData;
+    ElasticFrameMessages lAllocStatus = allocateSuperFrame(lNewData, lNewCapacity, pBucket);
+    if (lAllocStatus != ElasticFrameMessages::noError) {
+        return lAllocStatus;
+    }
+    if (pBucket->mBucketData) {
+        copyData(lNewData->pFrameData, pBucket->mBucketData->pFrameData, pBucket->mBucketDataCapacity,
+                 lNewData->mFrameSize >= mNonTemporalThreshold);
+        lNewData->mFrameSize = pBucket->mBucketData->mFrameSize;
+    }
+    pBucket->mBucketData = std::move(lNewData);
+    pBucket->mBucketDataCapacity = lNewCapacity;
+    return ElasticFrameMessages::noError;
+}
+
+// Unpack method for type7 packets. Type7 packets are type1 packets where the number of fragments is unknown until
+// the type2 (and type3) packet ending the superframe is received.
+ElasticFrameMessages
+ElasticFrameProtocolReceiver::unpackType7(const uint8_t *pSubPacket, size_t lPacketSize, uint8_t lFromSource) {
+    std::lock_guard<std::mutex> lock(mNetMtx);
+
+    auto *lType7Frame = (ElasticFrameType7 *) pSubPacket;
+    if (lPacketSize - sizeof(ElasticFrameType7) != lType7Frame->hType1PacketSize || lType7Frame->hFragmentNo >= UINT16_MAX - 1) {
+        return ElasticFrameMessages::frameSizeMismatch;
+    }
+    Bucket *pThisBucket = &mBucketList[lType7Frame->hSuperFrameNo & (uint16_t)CIRCULAR_BUFFER_SIZE];
+    size_t lInsertDataPointer = (size_t) lType7Frame->hType1PacketSize * lType7Frame->hFragmentNo;
+    size_t lEndOfData = lInsertDataPointer + lType7Frame->hType1PacketSize;
+
+    // Did the sender restart or jump? Then get rid of the stale buckets first
+    checkDiscontinuity(lType7Frame->hSuperFrameNo, lFromSource);
+
+    // The bucket is still used by another superframe mapping to the same slot. Evict it if the policy allows
+    if (pThisBucket->mActive && lType7Frame->hSuperFrameNo != pThisBucket->mSavedSuperFrameNo &&
+        !evictBucket(pThisBucket, lType7Frame->hSuperFrameNo, lType7Frame->hFrameType)) {
+        return ElasticFrameMessages::bufferOutOfResources;
+    }
+
+    if (!pThisBucket->mActive) {
+        uint64_t lDeliveryOrderCandidate = superFrameRecalculator(lType7Frame->hSuperFrameNo);
+        //Is this a old fragment where we already delivered the superframe?
+        if (lDeliveryOrderCandidate == pThisBucket->mDeliveryOrder) {
+            return ElasticFrameMessages::tooOldFragment;
+        }
+
+        pThisBucket->mDeliveryOrder = lDeliveryOrderCandidate;
+        mBucketMap[pThisBucket->mDeliveryOrder] = pThisBucket;
+        pThisBucket->mActive = true;
+        pThisBucket->mSource = lFromSource;
+        pThisBucket->mFlags = lType7Frame->hFrameType & (uint8_t)0xf0;
+        pThisBucket->mStream = lType7Frame->hStreamID;
+        Stream *pThisStream = &mStreams[lType7Frame->hStreamID];
+        pThisBucket->mDataContent = pThisStream->mDataContent;
+        pThisBucket->mCode = pThisStream->mCode;
+        pThisBucket->mSavedSuperFrameNo = lType7Frame->hSuperFrameNo;
+        pThisBucket->mHaveReceivedFragment.reset();
+        pThisBucket->mFECParity.clear();
+        pThisBucket->mPts = UINT64_MAX;
+        pThisBucket->mDts = UINT64_MAX;
+        pThisBucket->mHaveReceivedFragment[lType7Frame->hFragmentNo] = true;
+        pThisBucket->mTimeout = bucketDeadline(pThisBucket, lType7Frame->hFragmentNo, true);
+        pThisBucket->mNextNackTime = pThisBucket->mLastFragmentTime + (mNackDelayms * 1000);
+        pThisBucket->mNackCounter = 0;
+        pThisBucket->mContiguousFragments = 0;
+        pThisBucket->mFragmentCounter = 0;
+        // The end is unknown. UINT16_MAX is never a valid number of fragments
+        pThisBucket->mOfFragmentNo = UINT16_MAX;
+        pThisBucket->mFragmentSize = lType7Frame->hType1PacketSize;
+        pThisBucket->mBucketData = nullptr;
+        pThisBucket->mBucketDataCapacity = 0;
+        // Start with room for 16 fragments
+        ElasticFrameMessages lGrowStatus = growBucket(pThisBucket, std::max(lEndOfData, pThisBucket->mFragmentSize * 16));
+        if (lGrowStatus != ElasticFrameMessages::noError) {
+            mBucketMap.erase(pThisBucket->mDeliveryOrder);
+            pThisBucket->mActive = false;
+            return lGrowStatus;
+        }
+        pThisBucket->mBucketData->mFrameSize = lEndOfData;
+        copyToBucket(pThisBucket, lInsertDataPointer, pSubPacket + sizeof(ElasticFrameType7), lType7Frame->hType1PacketSize);
+        if (receiveChunkCallback) {
+            deliverChunks(pThisBucket);
+        }
+        return ElasticFrameMessages::noError;
+    }
+
+    // If the end is known the fragment must be before the end. All type7 fragments must be of the same size
+    if ((pThisBucket->mOfFragmentNo != UINT16_MAX && lType7Frame->hFragmentNo >= pThisBucket->mOfFragmentNo) ||
+        lType7Frame->hType1PacketSize != pThisBucket->mFragmentSize) {
+        EFP_LOGGER(true, LOGG_FATAL, "bufferOutOfBounds")
+        mBucketMap.erase(pThisBucket->mDeliveryOrder);
+        pThisBucket->mActive = false;
+        return ElasticFrameMessages::bufferOutOfBounds;
+    }
+
+    if (pThisBucket->mHaveReceivedFragment[lType7Frame->hFragmentNo] == 1) {
+        return ElasticFrameMessages::duplicatePacketReceived;
+    }
+
+    if (pThisBucket->mOfFragmentNo == UINT16_MAX) {
+        ElasticFrameMessages lGrowStatus = growBucket(pThisBucket, lEndOfData);
+        if (lGrowStatus != ElasticFrameMessages::noError) {
+            mBucketMap.erase(pThisBucket->mDeliveryOrder);
+            pThisBucket->mActive = false;
+            return lGrowStatus;
+        }
+        pThisBucket->mBucketData->mFrameSize = std::max(pThisBucket->mBucketData->mFrameSize, lEndOfData);
+    }
+    pThisBucket->mHaveReceivedFragment[lType7Frame->hFragmentNo] = true;
+
+    pThisBucket->mTimeout = bucketDeadline(pThisBucket, lType7Frame->hFragmentNo, false);
+    pThisBucket->mFragmentCounter++;
+
+    copyToBucket(pThisBucket, lInsertDataPointer, pSubPacket + sizeof(ElasticFrameType7), lType7Frame->hType1PacketSize);
+    if (receiveChunkCallback) {
+        deliverChunks(pThisBucket);
+    }
+    return ElasticFrameMessages::noError;
+}
+
+// mNetMtx must be held by the caller
+// The end of a streamed superframe is received. Now the number of fragments and the size is known.
+ElasticFrameMessages ElasticFrameProtocolReceiver::endStreamedBucket(Bucket *pBucket, uint16_t lOfFragmentNo, size_t lType1PacketSize, size_t lFrameSize) {
+    // All type7 fragments received so far must be before the end
+    if (lType1PacketSize != pBucket->mFragmentSize || lOfFragmentNo == UINT16_MAX ||
+        pBucket->mBucketData->mFrameSize > pBucket->mFragmentSize * lOfFragmentNo) {
+        EFP_LOGGER(true, LOGG_FATAL, "bufferOutOfBounds")
+        mBucketMap.erase(pBucket->mDeliveryOrder);
+        pBucket->mActive = false;
+        return ElasticFrameMessages::bufferOutOfBounds;
+    }
+    ElasticFrameMessages lGrowStatus = growBucket(pBucket, lFrameSize);
+    if (lGrowStatus != ElasticFrameMessages::noError) {
+        mBucketMap.erase(pBucket->mDeliveryOrder);
+        pBucket->mActive = false;
+        return lGrowStatus;
+    }
+    pBucket->mOfFragmentNo = lOfFragmentNo;
+    pBucket->mBucketData->mFrameSize = lFrameSize;
+    return ElasticFrameMessages::noError;
+}
+
+// Unpack method for type5 packets. Type5 packets carry the XOR parity of a group of type1 fragments.
+// The parity is stored in the bucket and used as soon as exactly one fragment in the group is missing.
+ElasticFrameMessages
+ElasticFrameProtocolReceiver::unpackType5(const uint8_t *pSubPacket, size_t lPacketSize) {
+    std::lock_guard<std::mutex> lock(mNetMtx);
+
+    auto *lType5Frame = (ElasticFrameType5 *) pSubPacket;
+    if (lPacketSize != sizeof(ElasticFrameType5) + lType5Frame->hType1PacketSize || !lType5Frame->hGroupSize) {
+        return ElasticFrameMessages::frameSizeMismatch;
+    }
+
+    Bucket *pThisBucket = &mBucketList[lType5Frame->hSuperFrameNo & (uint16_t)CIRCULAR_BUFFER_SIZE];
+
+    // We only use FEC for superframes we are assembling. If the superframe is already delivered the parity is not needed.
+    if (!pThisBucket->mActive) {
+        if (pThisBucket->mSavedSuperFrameNo == lType5Frame->hSuperFrameNo && pThisBucket->mDeliveryOrder != UINT64_MAX) {
+            return ElasticFrameMessages::tooOldFragment;
+        }
+        return ElasticFrameMessages::fecFragmentDropped;
+    }
+
+    if (lType5Frame->hSuperFrameNo != pThisBucket->mSavedSuperFrameNo) {
+        return ElasticFrameMessages::bufferOutOfResources;
+    }
+
+    if (lType5Frame->hOfFragmentNo != pThisBucket->mOfFragmentNo ||
+        lType5Frame->hType1PacketSize != pThisBucket->mFragmentSize ||
+        lPacketSize - sizeof(ElasticFrameType5) != pThisBucket->mFragmentSize ||
+        ((uint32_t) lType5Frame->hFragmentNo + (uint32_t) lType5Frame->hGroupSize) > pThisBucket->mOfFragmentNo) {
+        return ElasticFrameMessages::bufferOutOfBounds;
+    }
+
+    FECParity &rParity = pThisBucket->mFECParity[lType5Frame->hFragmentNo];
+    if (!rParity.mData.empty()) {
+        return ElasticFrameMessages::duplicatePacketReceived;
+    }
+    rParity.mGroupSize = lType5Frame->hGroupSize;
+    rParity.mData.assign(pSubPacket + sizeof(ElasticFrameType5), pSubPacket + lPacketSize);
+    recoverWithFEC(pThisBucket, lType5Frame->hFragmentNo);
+    if (receiveChunkCallback) {
+        deliverChunks(pThisBucket);
+    }
+    return ElasticFrameMessages::noError;
+}
+
+// mNetMtx must be held by the caller
+// If exactly one fragment is missing in the group covering lFragmentNo it's rebuilt from the parity and the other fragments.
+// When the group is complete the parity is released.
+void ElasticFrameProtocolReceiver::recoverWithFEC(Bucket *pBucket, uint16_t lFragmentNo) {
+    auto lGroup = pBucket->mFECParity.upper_bound(lFragmentNo);
+    if (lGroup == pBucket->mFECParity.begin()) {
+        return;
+    }
+    --lGroup;
+    uint16_t lGroupStart = lGroup->first;
+    uint16_t lGroupEnd = lGroupStart + lGroup->second.mGroupSize;
+    if (lFragmentNo >= lGroupEnd) {
+        return;
+    }
+
+    int32_t lMissingFragment = -1;
+    for (uint16_t lFragment = lGroupStart; lFragment < lGroupEnd; lFragment++) {
+        if (!pBucket->mHaveReceivedFragment[lFragment]) {
+            if (lMissingFragment >= 0) {
+                //More than one fragment is missing. Wait for more data.
+                return;
+            }
+            lMissingFragment = lFragment;
+        }
+    }
+
+    if (lMissingFragment >= 0) {
+        // Rebuild the fragment in the parity buffer (dropped below) then copy it like received fragment data
+        uint8_t *pRecovered = lGroup->second.mData.data();
+        for (uint16_t lFragment = lGroupStart; lFragment < lGroupEnd; lFragment++) {
+            if (lFragment != lMissingFragment) {
+                xorBlock(pRecovered, pBucket->mBucketData->pFrameData + (pBucket->mFragmentSize * lFragment), pBucket->mFragmentSize);
+            }
+        }
+        copyToBucket(pBucket, pBucket->mFragmentSize * lMissingFragment, pRecovered, pBucket->mFragmentSize);
+        pBucket->mHaveReceivedFragment[lMissingFragment] = true;
+        pBucket->mFragmentCounter++;
+        EFP_LOGGER(true, LOGG_NOTIFY, "FEC recovered fragment " << signed(lMissingFragment))
+    }
+    pBucket->mFECParity.erase(lGroup);
+}
+
+// Copy all information about the superframe from the bucket to the superframe to be delivered.
+// If the superframe is broken also describe what data is missing.
+void ElasticFrameProtocolReceiver::prepareSuperFrame(Bucket *pBucket) {
+    SuperFrame *pSuperFrame = pBucket->mBucketData.get();
+    pSuperFrame->mDataContent = pBucket->mDataContent;
+    pSuperFrame->mBroken = pBucket->mFragmentCounter != pBucket->mOfFragmentNo;
+    pSuperFrame->mPts = pBucket->mPts;
+    pSuperFrame->mDts = pBucket->mDts;
+    pSuperFrame->mCode = pBucket->mCode;
+    pSuperFrame->mStreamID = pBucket->mStream;
+    pSuperFrame->mSource = pBucket->mSource;
+    pSuperFrame->mFlags = pBucket->mFlags;
+    if (!pSuperFrame->mBroken) {
+        return;
+    }
+
+    // Merge missing fragments next to each other to one range. A missing tail can't be described since the size is unknown.
+    uint32_t lFragmentNo = 0;
+    while (lFragmentNo <= pBucket->mOfFragmentNo && lFragmentNo < UINT16_MAX) {
+        if (pBucket->mHaveReceivedFragment[lFragmentNo]) {
+            lFragmentNo++;
+            continue;
+        }
+        uint32_t lFirstMissing = lFragmentNo;
+        while (lFragmentNo <= pBucket->mOfFragmentNo && lFragmentNo < UINT16_MAX && !pBucket->mHaveReceivedFragment[lFragmentNo]) {
+            lFragmentNo++;
+        }
+        size_t lStart = pBucket->mFragmentSize * lFirstMissing;
+        size_t lEnd = std::min(pBucket->mFragmentSize * lFragmentNo, pSuperFrame->mFrameSize);
+        if (lStart >= lEnd) {
+            break;
+        }
+        pSuperFrame->mMissingRanges.emplace_back(lStart, lEnd - lStart);
+    }
+}
+
+// mNetMtx must be held by the caller
+// Find how far the contiguous received fragments reach from the start of the superframe and pass the new data to the user.
+// All fragments except the last two are type1 fragments of mFragmentSize bytes. The byte position of the end of the
+// contiguous data is capped by mFrameSize since the type3/type2 fragments at the end may carry less data.
+void ElasticFrameProtocolReceiver::deliverChunks(Bucket *pBucket) {
+    uint32_t lContiguousFragments = pBucket->mContiguousFragments;
+    while (lContiguousFragments <= pBucket->mOfFragmentNo && lContiguousFragments < UINT16_MAX &&
+           pBucket->mHaveReceivedFragment[lContiguousFragments]) {
+        lContiguousFragments++;
+    }
+    if (lContiguousFragments == pBucket->mContiguousFragments) {
+        return;
+    }
+
+    size_t lFrameSize = pBucket->mBucketData->mFrameSize;
+    size_t lStart = std::min(pBucket->mFragmentSize * pBucket->mContiguousFragments, lFrameSize);
+    size_t lEnd = lFrameSize;
+    if (lContiguousFragments <= pBucket->mOfFragmentNo) {
+        lEnd = std::min(pBucket->mFragmentSize * lContiguousFragments, lFrameSize);
+    }
+    pBucket->mContiguousFragments = lContiguousFragments;
+    if (lEnd > lStart) {
+        receiveChunkCallback(pBucket->mBucketData->pFrameData + lStart, lStart, lEnd - lStart, pBucket->mSavedSuperFrameNo,
+                             pBucket->mStream, pBucket->mSource, mCTX ? mCTX.get() : nullptr);
+    }
+}
+
+// mNetMtx must be held by the caller
+// Create a NACK for every bucket missing fragments where the NACK delay/interval has passed
+void ElasticFrameProtocolReceiver::generateNacks(int64_t lTimeNow, std::vector<std::pair<uint8_t, std::vector<uint8_t>>> &rNacks) {
+    for (const auto &rBucket : mBucketMap) {
+        Bucket *pBucket = rBucket.second;
+        //Don't NACK complete, timed out or already NACKed (within the interval) buckets
+        if (pBucket->mFragmentCounter == pBucket->mOfFragmentNo || pBucket->mNackCounter >= mMaxNacks ||
+            pBucket->mNextNackTime > lTimeNow || pBucket->mTimeout <= lTimeNow) {
+            continue;
+        }
+
+        // For streamed superframes where the end is unknown only gaps before the last received fragment can be NACKed
+        uint32_t lLastFragmentNo = pBucket->mOfFragmentNo;
+        if (lLastFragmentNo == UINT16_MAX) {
+            lLastFragmentNo = (uint32_t) (pBucket->mBucketData->mFrameSize / pBucket->mFragmentSize) - 1;
+        }
+
+        std::vector<uint8_t> lNack(sizeof(ElasticFrameType6));
+        uint16_t lNumberOfRanges = 0;
+        uint32_t lFragmentNo = 0;
+        while (lFragmentNo <= lLastFragmentNo && lNumberOfRanges < NACK_MAX_RANGES) {
+            if (pBucket->mHaveReceivedFragment[lFragmentNo]) {
+                lFragmentNo++;
+                continue;
+            }
+            ElasticNackRange lRange;
+            lRange.hFirstFragmentNo = (uint16_t) lFragmentNo;
+            while (lFragmentNo < lLastFragmentNo && !pBucket->mHaveReceivedFragment[lFragmentNo + 1]) {
+                lFragmentNo++;
+            }
+            lRange.hLastFragmentNo = (uint16_t) lFragmentNo;
+            lNack.insert(lNack.end(), (uint8_t *) &lRange, (uint8_t *) &lRange + sizeof(ElasticNackRange));
+            lNumberOfRanges++;
+            lFragmentNo++;
+        }
+
+        auto *pType6Frame = (ElasticFrameType6 *) lNack.data();
+        pType6Frame->hFrameType = Frametype::type6;
+        pType6Frame->hStreamID = pBucket->mStream;
+        pType6Frame->hSuperFrameNo = pBucket->mSavedSuperFrameNo;
+        pType6Frame->hNumberOfRanges = lNumberOfRanges;
+        pBucket->mNackCounter++;
+        pBucket->mNextNackTime = lTimeNow + (mNackIntervalms * 1000);
+        rNacks.emplace_back(pBucket->mSource, std::move(lNack));
+    }
+}
+
+// Generate the NACKs under the lock then call the nackCallback outside the lock
+// (The user might pass the NACK to a sender sending the fragments back to this receiver)
+void ElasticFrameProtocolReceiver::sendNacks(int64_t lTimeNow) {
+    if (!nackCallback) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mNetMtx);
+        if (!mMaxNacks) {
+            return;
+        }
+        generateNacks(lTimeNow, mNacks);
+    }
+    for (auto &rNack : mNacks) {
+        nackCallback(rNack.second, rNack.first, mCTX ? mCTX.get() : nullptr);
+    }
+    mNacks.clear();
+}
+
+// mNetMtx must be held by the caller
+int64_t ElasticFrameProtocolReceiver::bucketDeadline(Bucket *pBucket, uint16_t lFragmentNo, bool lNewBucket) {
     int64_t lTimeNow = std::chrono::duration_cast<std::chrono::microseconds>(
             std::chrono::steady_clock::now().time_since_epoch()).count();
+    int64_t lTimeoutUs = (int64_t) mBucketTimeoutms * 1000;
+    if (mAdaptiveTimeout) {
+        AdaptiveTimeout &rAdaptive = mAdaptiveTimeouts[(uint16_t) (pBucket->mSource << 8 | pBucket->mStream)];
+        if (!lNewBucket) {
+            if (rAdaptive.mGaps.size() < ADAPTIVE_TIMEOUT_GAPS) {
+                rAdaptive.mGaps.push_back(lTimeNow - pBucket->mLastFragmentTime);
+            } else {
+                rAdaptive.mGaps[rAdaptive.mNextGap] = lTimeNow - pBucket->mLastFragmentTime;
+            }
+            rAdaptive.mNextGap = (rAdaptive.mNextGap + 1) % ADAPTIVE_TIMEOUT_GAPS;
+            if (lFragmentNo < pBucket->mHighestFragmentNo) {
+                rAdaptive.mWindowReorderDepth = std::max(rAdaptive.mWindowReorderDepth,
+                                                         (uint32_t) (pBucket->mHighestFragmentNo - lFragmentNo));
+            }
+            // Re-calculate the timeout every window. The reorder depth is the largest of this and the previous window
+            if (++rAdaptive.mSamples % ADAPTIVE_TIMEOUT_WINDOW == 0) {
+                std::vector<int64_t> lGaps = rAdaptive.mGaps;
+                size_t lIndex = std::min((size_t) (mAdaptivePercentile * (double) lGaps.size()), lGaps.size() - 1);
+                std::nth_element(lGaps.begin(), lGaps.begin() + (int64_t) lIndex, lGaps.end());
+                rAdaptive.mGapPercentileUs = lGaps[lIndex];
+                uint32_t lReorderDepth = std::max(rAdaptive.mReorderDepth, rAdaptive.mWindowReorderDepth);
+                rAdaptive.mReorderDepth = rAdaptive.mWindowReorderDepth;
+                rAdaptive.mWindowReorderDepth = 0;
+                rAdaptive.mTimeoutUs = std::max(rAdaptive.mGapPercentileUs * 2 * ((int64_t) lReorderDepth + 1), (int64_t) 1);
+            }
+        }
+        if (rAdaptive.mTimeoutUs) {
+            lTimeoutUs = rAdaptive.mTimeoutUs;
+        }
+        lTimeoutUs = std::clamp(lTimeoutUs, mAdaptiveFloorUs, mAdaptiveCeilingUs);
+    }
+    if (lNewBucket || lFragmentNo > pBucket->mHighestFragmentNo) {
+        pBucket->mHighestFragmentNo = lFragmentNo;
+    }
+    pBucket->mLastFragmentTime = lTimeNow;
+    pBucket->mLastFragmentSequence = ++mFragmentSequence;
+
+    // Max reorder distance. Older buckets too far behind this fragment are lost, let them time out now
+    if (mMaxReorderSuperFrames || mMaxReorderFragments) {
+        for (auto &rOlder: mBucketMap) {
+            if (rOlder.first >= pBucket->mDeliveryOrder) {
+                break;
+            }
+            if ((mMaxReorderSuperFrames && pBucket->mDeliveryOrder - rOlder.first > mMaxReorderSuperFrames) ||
+                (mMaxReorderFragments && mFragmentSequence - rOlder.second->mLastFragmentSequence > mMaxReorderFragments)) {
+                rOlder.second->mTimeout = 0;
+            }
+        }
+    }
+    return lTimeNow + lTimeoutUs;
+}
+
+// mNetMtx must be held by the caller
+// In HOL mode may the delivery jump past the expected superframe to this bucket?
+// Yes if the bucket has timed out or, using the max reorder distance, if a superframe too far after the expected
+// superframe is received (then the expected superframe is lost)
+bool ElasticFrameProtocolReceiver::headOfLineExpired(Bucket *pBucket, int64_t lTimeNow) {
+    return pBucket->mTimeout <= (lTimeNow + (mHeadOfLineBlockingTimeoutms * 1000)) ||
+           (mMaxReorderSuperFrames && !mBucketMap.empty() &&
+            mBucketMap.rbegin()->first > mNextExpectedFrameNumber + mMaxReorderSuperFrames);
+}
+
+ElasticFrameMessages ElasticFrameProtocolReceiver::setMaxReorderDistance(uint32_t lSuperFrames, uint32_t lFragments) {
+    std::lock_guard<std::mutex> lock(mNetMtx);
+    mMaxReorderSuperFrames = lSuperFrames;
+    mMaxReorderFragments = lFragments;
+    return ElasticFrameMessages::noError;
+}
+
+ElasticFrameMessages ElasticFrameProtocolReceiver::setAdaptiveTimeout(bool lEnable, double lPercentile, uint32_t lFloorms, uint32_t lCeilingms) {
+    std::lock_guard<std::mutex> lock(mNetMtx);
+    mAdaptiveTimeout = lEnable;
+    mAdaptivePercentile = std::clamp(lPercentile, 0.0, 1.0);
+    mAdaptiveFloorUs = (int64_t) lFloorms * 1000;
+    mAdaptiveCeilingUs = (int64_t) std::max(lFloorms, lCeilingms) * 1000;
+    mAdaptiveTimeouts.clear();
+    return ElasticFrameMessages::noError;
+}
+
+std::vector<ElasticFrameProtocolReceiver::LearnedTimeout> ElasticFrameProtocolReceiver::getLearnedTimeouts() {
+    std::lock_guard<std::mutex> lock(mNetMtx);
+    std::vector<LearnedTimeout> lLearned;
+    for (auto &rAdaptive: mAdaptiveTimeouts) {
+        LearnedTimeout lValues;
+        lValues.mSource = rAdaptive.first >> 8;
+        lValues.mStreamID = rAdaptive.first & 0xff;
+        lValues.mSamples = rAdaptive.second.mSamples;
+        lValues.mGapPercentileUs = rAdaptive.second.mGapPercentileUs;
+        lValues.mReorderDepth = std::max(rAdaptive.second.mReorderDepth, rAdaptive.second.mWindowReorderDepth);
+        int64_t lTimeoutUs = rAdaptive.second.mTimeoutUs ? rAdaptive.second.mTimeoutUs : (int64_t) mBucketTimeoutms * 1000;
+        lValues.mTimeoutms = (uint32_t) (std::clamp(lTimeoutUs, mAdaptiveFloorUs, mAdaptiveCeilingUs) / 1000);
+        lLearned.push_back(lValues);
+    }
+    return lLearned;
+}
+
+ElasticFrameMessages ElasticFrameProtocolReceiver::setNackMode(uint32_t lNackDelayms, uint32_t lNackIntervalms, uint8_t lMaxNacks) {
+    std::lock_guard<std::mutex> lock(mNetMtx);
+    mNackDelayms = lNackDelayms;
+    mNackIntervalms = lNackIntervalms;
+    mMaxNacks = lMaxNacks;
+    return ElasticFrameMessages::noError;
+}
+
+void ElasticFrameProtocolReceiver::deliverRunToCompletion(Bucket *pBucket, const std::function<void(pFramePtr &rPacket, ElasticFrameProtocolContext* pCTX)>& rReceiveFunction) {
+    prepareSuperFrame(pBucket);
+    if (rReceiveFunction) {
+        rReceiveFunction(pBucket->mBucketData, mCTX ? mCTX.get() : nullptr);
+    } else if (receiveBatchCallback) {
+        mRunToCompletionBatch.push_back(std::move(pBucket->mBucketData));
+    } else {
+        receiveCallback(pBucket->mBucketData, mCTX ? mCTX.get() : nullptr);
+    }
+}
+
+//mNetMtx is already taken no need to lock anything
+void ElasticFrameProtocolReceiver::runToCompletionMethod(const std::function<void(pFramePtr &rPacket, ElasticFrameProtocolContext* pCTX)>& rReceiveFunction, int64_t lTimeNow) {
+    sendNacks(lTimeNow);
+
+    // Superframes evicted from the buckets go first
+    for (auto &rSuperFrame: mEvictedSuperFrames) {
+        if (rReceiveFunction) {
+            rReceiveFunction(rSuperFrame, mCTX ? mCTX.get() : nullptr);
+        } else if (receiveBatchCallback) {
+            mRunToCompletionBatch.push_back(std::move(rSuperFrame));
+        } else {
+            receiveCallback(rSuperFrame, mCTX ? mCTX.get() : nullptr);
+        }
+    }
+    mEvictedSuperFrames.clear();
 
     std::vector<Bucket*> lCandidates;
     lCandidates.reserve(CIRCULAR_BUFFER_SIZE);
@@ -439,6 +1788,10 @@ void ElasticFrameProtocolReceiver::runToCompletionMethod(const std::function<voi
     }
     if (lCandidates.empty()) {
         //I might need more fragments to assemble the super frame or no old data has yet timed out
+        if (!mRunToCompletionBatch.empty()) {
+            receiveBatchCallback(mRunToCompletionBatch, mCTX ? mCTX.get() : nullptr);
+            mRunToCompletionBatch.clear();
+        }
         return;
     }
 
@@ -447,8 +1800,8 @@ void ElasticFrameProtocolReceiver::runToCompletionMethod(const std::function<voi
         if (mDeliveryHOLFirstRun) {
             //It's the first run. We are in HOL mode (Run to completion)
             //We can't wait for two frames since we don't know when
-            //we will be here again and we can't time out single frames since
-            //we are event driven externally. Set the HEAD speculatively and go with that.
+            //we will be here again (unless the host drives us using nextDeadline/processTimeouts).
+            //Set the HEAD speculatively and go with that.
 
             mDeliveryHOLFirstRun = false;
             mNextExpectedFrameNumber = lCandidates[0]->mDeliveryOrder;
@@ -458,24 +1811,12 @@ void ElasticFrameProtocolReceiver::runToCompletionMethod(const std::function<voi
             if (rBucket->mDeliveryOrder ==  mNextExpectedFrameNumber) {
                 //We got what we expected. Now deliver.
                 //Assemble all data for delivery
-                rBucket->mBucketData->mDataContent = rBucket->mDataContent;
-                rBucket->mBucketData->mBroken = rBucket->mFragmentCounter != rBucket->mOfFragmentNo;
-                rBucket->mBucketData->mPts = rBucket->mPts;
-                rBucket->mBucketData->mDts = rBucket->mDts;
-                rBucket->mBucketData->mCode = rBucket->mCode;
-                rBucket->mBucketData->mStreamID = rBucket->mStream;
-                rBucket->mBucketData->mSource = rBucket->mSource;
-                rBucket->mBucketData->mFlags = rBucket->mFlags;
-                if (rReceiveFunction) {
-                    rReceiveFunction(rBucket->mBucketData, mCTX ? mCTX.get() : nullptr);
-                } else {
-                    receiveCallback(rBucket->mBucketData, mCTX ? mCTX.get() : nullptr);
-                }
+                deliverRunToCompletion(rBucket, rReceiveFunction);
                 mBucketMap.erase(rBucket->mDeliveryOrder); //We delivered let's collect the garbage
                 rBucket->mActive = false; //Inactivate the bucket
                 rBucket->mBucketData = nullptr; //Release the data
                 mNextExpectedFrameNumber++; //The next expected frame is this frame number + 1
-            } else if (rBucket->mTimeout <= (lTimeNow + (mHeadOfLineBlockingTimeoutms * 1000))) {
+            } else if (headOfLineExpired(rBucket, lTimeNow)) {
                 //We got HOL but the next frame has timed out meaning the time out of the bucket + the HOL timeout
                 //We need now need to jump ahead and reset the mNextExpectedFrameNumber
                 //Assemble all data for delivery and reset the HOL pointer.
@@ -486,19 +1827,7 @@ void ElasticFrameProtocolReceiver::runToCompletionMethod(const std::function<voi
                     rBucket->mBucketData = nullptr;
                     rBucket->mActive = false;
                 } else {
-                    rBucket->mBucketData->mDataContent = rBucket->mDataContent;
-                    rBucket->mBucketData->mBroken = rBucket->mFragmentCounter != rBucket->mOfFragmentNo;
-                    rBucket->mBucketData->mPts = rBucket->mPts;
-                    rBucket->mBucketData->mDts = rBucket->mDts;
-                    rBucket->mBucketData->mCode = rBucket->mCode;
-                    rBucket->mBucketData->mStreamID = rBucket->mStream;
-                    rBucket->mBucketData->mSource = rBucket->mSource;
-                    rBucket->mBucketData->mFlags = rBucket->mFlags;
-                    if (rReceiveFunction) {
-                        rReceiveFunction(rBucket->mBucketData, mCTX ? mCTX.get() : nullptr);
-                    } else {
-                        receiveCallback(rBucket->mBucketData, mCTX ? mCTX.get() : nullptr);
-                    }
+                    deliverRunToCompletion(rBucket, rReceiveFunction);
                     mBucketMap.erase(rBucket->mDeliveryOrder); //We delivered let's collect the garbage
                     rBucket->mActive = false; //Inactivate the bucket
                     rBucket->mBucketData = nullptr; //Release the data
@@ -514,29 +1843,22 @@ void ElasticFrameProtocolReceiver::runToCompletionMethod(const std::function<voi
         //We are not in HOL mode.. This means just deliver as the frames arrive or times out
         for (auto &rBucket: lCandidates) {
             //Assemble all data for delivery
-            rBucket->mBucketData->mDataContent = rBucket->mDataContent;
-            rBucket->mBucketData->mBroken =
-                    rBucket->mFragmentCounter != rBucket->mOfFragmentNo;
-            rBucket->mBucketData->mPts = rBucket->mPts;
-            rBucket->mBucketData->mDts = rBucket->mDts;
-            rBucket->mBucketData->mCode = rBucket->mCode;
-            rBucket->mBucketData->mStreamID = rBucket->mStream;
-            rBucket->mBucketData->mSource = rBucket->mSource;
-            rBucket->mBucketData->mFlags = rBucket->mFlags;
-            if (rReceiveFunction) {
-                rReceiveFunction(rBucket->mBucketData, mCTX ? mCTX.get() : nullptr);
-            } else {
-                receiveCallback(rBucket->mBucketData, mCTX ? mCTX.get() : nullptr);
-            }
+            deliverRunToCompletion(rBucket, rReceiveFunction);
             mBucketMap.erase(rBucket->mDeliveryOrder); //We delivered let's collect the garbage
             rBucket->mActive = false; //Inactivate the bucket
             rBucket->mBucketData = nullptr; //Release the data
         }
     }
+
+    if (!mRunToCompletionBatch.empty()) {
+        receiveBatchCallback(mRunToCompletionBatch, mCTX ? mCTX.get() : nullptr);
+        mRunToCompletionBatch.clear();
+    }
 }
 
 //This thread is delivering the super frames to the host
 void ElasticFrameProtocolReceiver::deliveryWorker() {
+    std::vector<pFramePtr> lSuperframes;
     while (mThreadActive) {
         pFramePtr lSuperframe = nullptr;
         {
@@ -546,24 +1868,492 @@ void ElasticFrameProtocolReceiver::deliveryWorker() {
                                                           [this] { return mSuperFrameReady; }); //if mSuperFrameReady == true we already got data no need to wait for signal
             // We got a signal a frame is ready
 
-            // pop until queue is empty
-            if (!mSuperFrameQueue.empty()) {
-                lSuperframe = std::move(mSuperFrameQueue.front());
+            if (mPlayout) {
+                // Take the superframes that are due
+                waitForPlayout(lk, lSuperframes);
+            } else if (receiveBatchCallback) {
+                // Take all superframes in the queue
+                popFramesLocked(lSuperframes, SIZE_MAX);
+            } else {
+                // pop until queue is empty
+                if (!mSuperFrameQueue.empty()) {
+                    auto lNext = nextFrameToDeliver();
+                    lSuperframe = std::move(*lNext);
+                    mSuperFrameQueue.erase(lNext);
+                    mSuperFrameSpaceConditionVariable.notify_one();
+                }
+                // If there is more to pop don't close the semaphore else do.
+                if (mSuperFrameQueue.empty()) {
+                    mSuperFrameReady = false;
+                }
+            }
+        }
+        //I want to be outside the scope of the lock when calling the callback. Else the
+        //callback may lock the internal workers.
+        if (lSuperframe) {
+            receiveCallback(lSuperframe, mCTX ? mCTX.get() : nullptr);
+            lSuperframe = nullptr; //Drop the ownership.
+        }
+        if (!lSuperframes.empty()) {
+            if (receiveBatchCallback) {
+                receiveBatchCallback(lSuperframes, mCTX ? mCTX.get() : nullptr);
+            } else {
+                for (auto &rSuperframe: lSuperframes) {
+                    receiveCallback(rSuperframe, mCTX ? mCTX.get() : nullptr);
+                }
+            }
+            lSuperframes.clear(); //Drop the ownership.
+        }
+    }
+    mIsDeliveryThreadActive = false;
+}
+
+// mNetMtx must be held by the caller
+void ElasticFrameProtocolReceiver::queueSuperFrame(Bucket *pBucket) {
+    prepareSuperFrame(pBucket);
+    mSuperFramesToPush.push_back(std::move(pBucket->mBucketData));
+    mHaveSuperFramesToPush = true;
+}
+
+// mPushMtx makes sure the superframes taken by one call are pushed before the ones taken by the next call.
+// If the caller may not block the superframes not pushed are put back first in line for the worker.
+void ElasticFrameProtocolReceiver::pushSuperFrames(bool lMayBlock) {
+    if (!mHaveSuperFramesToPush) {
+        return;
+    }
+    std::unique_lock<std::mutex> lPushLock(mPushMtx, std::defer_lock);
+    if (lMayBlock) {
+        lPushLock.lock();
+    } else if (!lPushLock.try_lock()) {
+        return;
+    }
+    std::vector<pFramePtr> lSuperFrames;
+    {
+        std::lock_guard<std::mutex> lock(mNetMtx);
+        lSuperFrames.swap(mSuperFramesToPush);
+        mHaveSuperFramesToPush = false;
+        for (auto &rSuperFrame: lSuperFrames) {
+            pushToLane(rSuperFrame);
+        }
+    }
+    auto lSuperFrame = lSuperFrames.begin();
+    while (lSuperFrame != lSuperFrames.end() && (!*lSuperFrame || pushSuperFrame(*lSuperFrame, lMayBlock))) {
+        ++lSuperFrame;
+    }
+    if (lSuperFrame != lSuperFrames.end()) {
+        std::lock_guard<std::mutex> lock(mNetMtx);
+        std::vector<pFramePtr> lLater;
+        lLater.swap(mSuperFramesToPush);
+        for (; lSuperFrame != lSuperFrames.end(); ++lSuperFrame) {
+            if (*lSuperFrame) {
+                mSuperFramesToPush.push_back(std::move(*lSuperFrame));
+            }
+        }
+        std::move(lLater.begin(), lLater.end(), std::back_inserter(mSuperFramesToPush));
+        mHaveSuperFramesToPush = true;
+    }
+}
+
+// mNetMtx must be held by the caller (the lanes are replaced holding mNetMtx). Never blocks
+bool ElasticFrameProtocolReceiver::pushToLane(pFramePtr &rFrame) {
+    DeliveryLane *pLane = mDeliveryLanes[rFrame->mStreamID].get();
+    if (!pLane) {
+        return false;
+    }
+    {
+        std::lock_guard<std::mutex> lk(pLane->mMtx);
+        pLane->mQueue.push_back(std::move(rFrame));
+        pLane->mReady = true;
+    }
+    pLane->mConditionVariable.notify_one();
+    return true;
+}
+
+bool ElasticFrameProtocolReceiver::pushSuperFrame(pFramePtr &rFrame, bool lMayBlock) {
+    {
+        std::unique_lock<std::mutex> lk(mSuperFrameMtx);
+#ifdef EFP_COROUTINES
+        // Hand the superframe directly to the waiting coroutine. It's resumed when the worker has released the locks.
+        if (pFrameWaiter) {
+            pFrameWaiter->mFrame = std::move(rFrame);
+            pFrameWaiter = nullptr;
+            mCoroutinesToResume.push_back(mFrameWaiterHandle);
+            return true;
+        }
+#endif
+        if (mPlayout) {
+            schedulePlayout(rFrame);
+            mSuperFrameReady = !mPlayoutBuffer.empty();
+            lk.unlock();
+            // The superframe may be due before the one the delivery worker is waiting for
+            mSuperFrameDeliveryConditionVariable.notify_one();
+            return true;
+        }
+        if (mQueuePolicy == EFPQueuePolicy::LATEST_ONLY) {
+            uint8_t lStreamID = rFrame->mStreamID;
+            size_t lQueueSize = mSuperFrameQueue.size();
+            mSuperFrameQueue.erase(std::remove_if(mSuperFrameQueue.begin(), mSuperFrameQueue.end(),
+                                                  [lStreamID](const pFramePtr &rFrame) { return rFrame->mStreamID == lStreamID; }),
+                                   mSuperFrameQueue.end());
+            mQueueCounters.mReplacedByLatest += lQueueSize - mSuperFrameQueue.size();
+        } else if (mMaxQueueSize && mSuperFrameQueue.size() >= mMaxQueueSize) {
+            if (mQueuePolicy == EFPQueuePolicy::DROP_OLDEST) {
                 mSuperFrameQueue.pop_front();
+                mQueueCounters.mDroppedOldest++;
+            } else if (mQueuePolicy == EFPQueuePolicy::DROP_NEWEST) {
+                mQueueCounters.mDroppedNewest++;
+                rFrame = nullptr;
+                return true;
+            } else {
+                if (!lMayBlock) {
+                    return false;
+                }
+                // Wait for the consumer. Fragments are still received, they wait in the buckets
+                mQueueCounters.mBlocked++;
+                mSuperFrameSpaceConditionVariable.wait(lk, [this] {
+                    return mSuperFrameQueue.size() < mMaxQueueSize || !mMaxQueueSize || !mThreadActive;
+                });
             }
-            // If there is more to pop don't close the semaphore else do.
-            if (mSuperFrameQueue.empty()) {
-                mSuperFrameReady = false;
+        }
+        mSuperFrameQueue.push_back(std::move(rFrame));
+        mSuperFrameReady = true;
+#ifdef __linux__
+        // The eventfd is readable as long as the queue is not empty
+        if (mReadinessFd >= 0 && mSuperFrameQueue.size() == 1) {
+            uint64_t lOne = 1;
+            if (write(mReadinessFd, &lOne, sizeof(lOne)) != sizeof(lOne)) {
+                EFP_LOGGER(true, LOGG_ERROR, "Failed signaling the readiness eventfd")
             }
         }
-        //I want to be outside the scope of the lock when calling the callback. Else the
-        //callback may lock the internal workers.
-        if (lSuperframe) {
-            receiveCallback(lSuperframe, mCTX ? mCTX.get() : nullptr);
-            lSuperframe = nullptr; //Drop the ownership.
+#endif
+    }
+    mSuperFrameDeliveryConditionVariable.notify_one();
+    return true;
+}
+
+// mSuperFrameMtx must be held by the caller
+void ElasticFrameProtocolReceiver::schedulePlayout(pFramePtr &rFrame) {
+    int64_t lTimeNow = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    int64_t lDeliveryTime = lTimeNow;
+    uint64_t lTimestamp = rFrame->mDts != UINT64_MAX ? rFrame->mDts : rFrame->mPts;
+    if (lTimestamp != UINT64_MAX) {
+        auto lTimestampUs = (int64_t) ((lTimestamp / mPlayoutTimebase) * 1000000 +
+                                       ((lTimestamp % mPlayoutTimebase) * 1000000) / mPlayoutTimebase);
+        lDeliveryTime = lTimestampUs + recoverPlayoutClock(mPlayoutClocks[rFrame->mStreamID], lTimestampUs, lTimeNow) +
+                        mPlayoutLatencyUs;
+        if (lDeliveryTime < lTimeNow) {
+            mPlayoutCounters.mLate++;
+            mPlayoutCounters.mMaxLateUs = std::max(mPlayoutCounters.mMaxLateUs, lTimeNow - lDeliveryTime);
+            rFrame = nullptr;
+            return;
+        }
+    }
+    mPlayoutBuffer.emplace(lDeliveryTime, std::move(rFrame));
+}
+
+// mSuperFrameMtx must be held by the caller
+// The offset is the smallest (local time - time stamp) seen, that is the superframe with the shortest transfer time.
+// The smallest offset of every window is also used to estimate the drift of the sender clock and to let the offset
+// increase if the transfer time increases.
+int64_t ElasticFrameProtocolReceiver::recoverPlayoutClock(PlayoutClock &rClock, int64_t lTimestampUs, int64_t lTimeNow) {
+    int64_t lOffset = lTimeNow - lTimestampUs;
+    if (!rClock.mLocked) {
+        rClock = PlayoutClock();
+        rClock.mLocked = true;
+        rClock.mOffsetUs = lOffset;
+        rClock.mOffsetTime = lTimeNow;
+        rClock.mWindowStart = lTimeNow;
+        rClock.mWindowMinOffset = lOffset;
+        return lOffset;
+    }
+    int64_t lExpectedOffset = rClock.mOffsetUs + (int64_t) (rClock.mDrift * (double) (lTimeNow - rClock.mOffsetTime));
+    if (lOffset < lExpectedOffset) {
+        mPlayoutCounters.mEarly++;
+        mPlayoutCounters.mMaxEarlyUs = std::max(mPlayoutCounters.mMaxEarlyUs, lExpectedOffset - lOffset);
+        rClock.mOffsetUs = lOffset;
+        rClock.mOffsetTime = lTimeNow;
+        lExpectedOffset = lOffset;
+    }
+    rClock.mWindowMinOffset = std::min(rClock.mWindowMinOffset, lOffset);
+    if (lTimeNow - rClock.mWindowStart >= PLAYOUT_CLOCK_WINDOW_US) {
+        if (rClock.mHavePreviousWindow) {
+            double lDrift = (double) (rClock.mWindowMinOffset - rClock.mPreviousWindowMinOffset) /
+                            (double) (lTimeNow - rClock.mWindowStart);
+            rClock.mDrift += (lDrift - rClock.mDrift) / 8.0;
+        }
+        rClock.mPreviousWindowMinOffset = rClock.mWindowMinOffset;
+        rClock.mHavePreviousWindow = true;
+        rClock.mOffsetUs = rClock.mWindowMinOffset;
+        rClock.mOffsetTime = lTimeNow;
+        rClock.mWindowStart = lTimeNow;
+        rClock.mWindowMinOffset = lOffset;
+    }
+    return lExpectedOffset;
+}
+
+// mSuperFrameMtx must be held by the caller (rLock)
+void ElasticFrameProtocolReceiver::waitForPlayout(std::unique_lock<std::mutex> &rLock, std::vector<pFramePtr> &rFrames) {
+    // Superframes queued before the playout mode was enabled are delivered at once
+    if (popFramesLocked(rFrames, SIZE_MAX)) {
+        mSuperFrameReady = !mPlayoutBuffer.empty();
+        return;
+    }
+    while (mThreadActive && !mPlayoutBuffer.empty()) {
+        int64_t lDeliveryTime = mPlayoutBuffer.begin()->first;
+        int64_t lTimeNow = std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+        if (lDeliveryTime <= lTimeNow) {
+            break;
+        }
+        // Woken up early if a new superframe is scheduled or the receiver is stopped
+        mSuperFrameDeliveryConditionVariable.wait_until(rLock, std::chrono::steady_clock::time_point(
+                std::chrono::microseconds(lDeliveryTime)));
+    }
+    int64_t lTimeNow = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    while (!mPlayoutBuffer.empty() && mPlayoutBuffer.begin()->first <= lTimeNow) {
+        rFrames.push_back(std::move(mPlayoutBuffer.begin()->second));
+        mPlayoutBuffer.erase(mPlayoutBuffer.begin());
+        mPlayoutCounters.mDelivered++;
+    }
+    // The playout mode may have been disabled while waiting, moving the superframes to the queue
+    mSuperFrameReady = !mPlayoutBuffer.empty() || !mSuperFrameQueue.empty();
+}
+
+ElasticFrameMessages ElasticFrameProtocolReceiver::setPlayoutMode(bool lEnable, uint32_t lLatencyms, uint32_t lTimebaseHz) {
+    if (mCurrentMode != EFPReceiverMode::THREADED) {
+        return ElasticFrameMessages::notImplemented;
+    }
+    {
+        std::lock_guard<std::mutex> lk(mSuperFrameMtx);
+        mPlayout = lEnable;
+        mPlayoutLatencyUs = (int64_t) lLatencyms * 1000;
+        mPlayoutTimebase = std::max(lTimebaseHz, (uint32_t) 1);
+        for (auto &rClock: mPlayoutClocks) {
+            rClock = PlayoutClock();
+        }
+        mPlayoutCounters = PlayoutCounters();
+        // Superframes waiting for playout are delivered at once
+        for (auto &rWaiting: mPlayoutBuffer) {
+            mSuperFrameQueue.push_back(std::move(rWaiting.second));
+        }
+        mPlayoutBuffer.clear();
+        mSuperFrameReady = !mSuperFrameQueue.empty();
+    }
+    mSuperFrameDeliveryConditionVariable.notify_one();
+    return ElasticFrameMessages::noError;
+}
+
+ElasticFrameProtocolReceiver::PlayoutCounters ElasticFrameProtocolReceiver::getPlayoutCounters() {
+    std::lock_guard<std::mutex> lk(mSuperFrameMtx);
+    return mPlayoutCounters;
+}
+
+ElasticFrameMessages ElasticFrameProtocolReceiver::setDeliveryQueueLimit(size_t lMaxFrames, EFPQueuePolicy lPolicy) {
+    {
+        std::lock_guard<std::mutex> lk(mSuperFrameMtx);
+        mMaxQueueSize = lMaxFrames;
+        mQueuePolicy = lPolicy;
+        mQueueCounters = DeliveryQueueCounters();
+    }
+    // If the worker is blocked let it re-evaluate the new limit
+    mSuperFrameSpaceConditionVariable.notify_one();
+    return ElasticFrameMessages::noError;
+}
+
+ElasticFrameProtocolReceiver::DeliveryQueueCounters ElasticFrameProtocolReceiver::getDeliveryQueueCounters() {
+    std::lock_guard<std::mutex> lk(mSuperFrameMtx);
+    return mQueueCounters;
+}
+
+ElasticFrameMessages ElasticFrameProtocolReceiver::setPriorityDelivery(bool lEnable) {
+    std::lock_guard<std::mutex> lk(mSuperFrameMtx);
+    mPriorityDelivery = lEnable;
+    return ElasticFrameMessages::noError;
+}
+
+// Only the oldest superframe of every stream may be delivered (per stream order).
+// Of those pick the one with the highest priority. If equal, the oldest.
+std::deque<ElasticFrameProtocolReceiver::pFramePtr>::iterator ElasticFrameProtocolReceiver::nextFrameToDeliver() {
+    if (!mPriorityDelivery || mSuperFrameQueue.size() < 2) {
+        return mSuperFrameQueue.begin();
+    }
+    std::bitset<UINT8_MAX + 1> lStreamSeen;
+    auto lBest = mSuperFrameQueue.begin();
+    int lBestPriority = -1;
+    for (auto lIt = mSuperFrameQueue.begin(); lIt != mSuperFrameQueue.end(); ++lIt) {
+        uint8_t lStreamID = (*lIt)->mStreamID;
+        if (lStreamSeen[lStreamID]) {
+            continue;
+        }
+        lStreamSeen[lStreamID] = true;
+        int lPriority = (*lIt)->mFlags & PRIORITY_MASK;
+        if (lPriority > lBestPriority) {
+            lBestPriority = lPriority;
+            lBest = lIt;
+            if (lPriority == PRIORITY_P3) {
+                break;
+            }
+        }
+    }
+    return lBest;
+}
+
+bool ElasticFrameProtocolReceiver::tryPopFrame(pFramePtr &rFrame) {
+    std::vector<pFramePtr> lFrames;
+    if (!popFrames(lFrames, 1)) {
+        return false;
+    }
+    rFrame = std::move(lFrames[0]);
+    return true;
+}
+
+size_t ElasticFrameProtocolReceiver::popFrames(std::vector<pFramePtr> &rFrames, size_t lMaxFrames) {
+    if (mCurrentMode != EFPReceiverMode::PULL) {
+        return 0;
+    }
+    std::lock_guard<std::mutex> lk(mSuperFrameMtx);
+    return popFramesLocked(rFrames, lMaxFrames);
+}
+
+size_t ElasticFrameProtocolReceiver::popFramesLocked(std::vector<pFramePtr> &rFrames, size_t lMaxFrames) {
+    size_t lFrames = 0;
+    while (lFrames < lMaxFrames && !mSuperFrameQueue.empty()) {
+        auto lNext = nextFrameToDeliver();
+        rFrames.push_back(std::move(*lNext));
+        mSuperFrameQueue.erase(lNext);
+        lFrames++;
+    }
+    if (lFrames) {
+        mSuperFrameSpaceConditionVariable.notify_one();
+    }
+    if (mSuperFrameQueue.empty()) {
+        mSuperFrameReady = false;
+#ifdef __linux__
+        // Reset the eventfd
+        if (lFrames && mReadinessFd >= 0) {
+            uint64_t lValue;
+            if (read(mReadinessFd, &lValue, sizeof(lValue)) != sizeof(lValue)) {
+                EFP_LOGGER(true, LOGG_ERROR, "Failed resetting the readiness eventfd")
+            }
+        }
+#endif
+    }
+    return lFrames;
+}
+
+#ifdef EFP_COROUTINES
+void ElasticFrameProtocolReceiver::resumeCoroutines() {
+    std::vector<std::coroutine_handle<>> lHandles;
+    {
+        std::lock_guard<std::mutex> lk(mSuperFrameMtx);
+        if (mCoroutinesToResume.empty()) {
+            return;
+        }
+        lHandles.swap(mCoroutinesToResume);
+    }
+    for (auto &rHandle: lHandles) {
+        if (coroutineExecutor) {
+            coroutineExecutor(rHandle);
+        } else {
+            rHandle.resume();
+        }
+    }
+}
+
+bool ElasticFrameProtocolReceiver::FrameAwaitable::await_ready() {
+    if (pReceiver->mCurrentMode != EFPReceiverMode::PULL || !pReceiver->mThreadActive) {
+        return true;
+    }
+    std::vector<pFramePtr> lFrames;
+    if (pReceiver->popFrames(lFrames, 1)) {
+        mFrame = std::move(lFrames[0]);
+        return true;
+    }
+    return false;
+}
+
+bool ElasticFrameProtocolReceiver::FrameAwaitable::await_suspend(std::coroutine_handle<> lHandle) {
+    std::lock_guard<std::mutex> lk(pReceiver->mSuperFrameMtx);
+    // A superframe might have been queued after await_ready
+    std::vector<pFramePtr> lFrames;
+    if (pReceiver->popFramesLocked(lFrames, 1)) {
+        mFrame = std::move(lFrames[0]);
+        return false;
+    }
+    if (!pReceiver->mThreadActive) {
+        return false;
+    }
+    pReceiver->pFrameWaiter = this;
+    pReceiver->mFrameWaiterHandle = lHandle;
+    return true;
+}
+#endif
+
+void ElasticFrameProtocolReceiver::laneWorker(DeliveryLane *pLane) {
+    while (pLane->mActive) {
+        pFramePtr lSuperframe = nullptr;
+        {
+            std::unique_lock<std::mutex> lk(pLane->mMtx);
+            pLane->mConditionVariable.wait(lk, [pLane] { return pLane->mReady; });
+            if (!pLane->mQueue.empty()) {
+                lSuperframe = std::move(pLane->mQueue.front());
+                pLane->mQueue.pop_front();
+            }
+            if (pLane->mQueue.empty()) {
+                pLane->mReady = false;
+            }
+        }
+        if (lSuperframe && pLane->mActive) {
+            pLane->mCallback(lSuperframe, mCTX ? mCTX.get() : nullptr);
+        }
+    }
+    pLane->mThreadActive = false;
+}
+
+ElasticFrameMessages ElasticFrameProtocolReceiver::stopLane(std::unique_ptr<DeliveryLane> pLane) {
+    pLane->mActive = false;
+    {
+        std::lock_guard<std::mutex> lk(pLane->mMtx);
+        pLane->mReady = true;
+    }
+    pLane->mConditionVariable.notify_one();
+    uint32_t lLockProtect = 1000;
+    while (pLane->mThreadActive) {
+        std::this_thread::sleep_for(std::chrono::microseconds(1000));
+        if (!--lLockProtect) {
+            //The consumer is stuck in the callback. Leave the lane to the thread, it's not safe to delete it.
+            EFP_LOGGER(true, LOGG_FATAL, "Lane thread not stopping.")
+            pLane.release();
+            return ElasticFrameMessages::failedStoppingReceiver;
+        }
+    }
+    return ElasticFrameMessages::noError;
+}
+
+ElasticFrameMessages ElasticFrameProtocolReceiver::setStreamCallback(uint8_t lStreamID, const std::function<void(pFramePtr &rPacket, ElasticFrameProtocolContext* pCTX)>& rCallback) {
+    if (mCurrentMode == EFPReceiverMode::RUN_TO_COMPLETION) {
+        return ElasticFrameMessages::notImplemented;
+    }
+    std::unique_ptr<DeliveryLane> lOldLane;
+    {
+        std::lock_guard<std::mutex> lock(mNetMtx);
+        lOldLane = std::move(mDeliveryLanes[lStreamID]);
+        if (rCallback) {
+            mDeliveryLanes[lStreamID] = std::make_unique<DeliveryLane>();
+            DeliveryLane *pLane = mDeliveryLanes[lStreamID].get();
+            pLane->mCallback = rCallback;
+            pLane->mActive = true;
+            pLane->mThreadActive = true;
+            startThread(&pLane->mThread, "ln" + std::to_string(lStreamID),
+                        std::bind(&ElasticFrameProtocolReceiver::laneWorker, this, pLane));
         }
     }
-    mIsDeliveryThreadActive = false;
+    if (lOldLane) {
+        return stopLane(std::move(lOldLane));
+    }
+    return ElasticFrameMessages::noError;
 }
 
 // This is the thread going trough the buckets to see if they should be delivered to
@@ -608,6 +2398,11 @@ void ElasticFrameProtocolReceiver::receiverWorker() {
 
         int64_t lTimeAfterSleep = lTimeNow + lTimeCompensation;
 
+        sendNacks(lTimeAfterSleep);
+
+        // Superframes delivered by receiveFragment that could not be pushed without blocking
+        pushSuperFrames(true);
+
         mNetMtx.lock();
         auto lActiveCount = (uint32_t)mBucketMap.size();
         if (!lActiveCount) {
@@ -655,27 +2450,13 @@ void ElasticFrameProtocolReceiver::receiverWorker() {
                     //Assemble all data for delivery
 
                     //Assemble all data for delivery
-                    {
-                        std::lock_guard<std::mutex> lk(mSuperFrameMtx);
-                        rBucket->mBucketData->mDataContent = rBucket->mDataContent;
-                        rBucket->mBucketData->mBroken =
-                                rBucket->mFragmentCounter != rBucket->mOfFragmentNo;
-                        rBucket->mBucketData->mPts = rBucket->mPts;
-                        rBucket->mBucketData->mDts = rBucket->mDts;
-                        rBucket->mBucketData->mCode = rBucket->mCode;
-                        rBucket->mBucketData->mStreamID = rBucket->mStream;
-                        rBucket->mBucketData->mSource = rBucket->mSource;
-                        rBucket->mBucketData->mFlags = rBucket->mFlags;
-                        mSuperFrameQueue.push_back(std::move(rBucket->mBucketData));
-                        mSuperFrameReady = true;
-                    }
-                    mSuperFrameDeliveryConditionVariable.notify_one();
+                    queueSuperFrame(rBucket);
                     mBucketMap.erase(rBucket->mDeliveryOrder);
                     rBucket->mActive = false;
 
                     mNextExpectedFrameNumber++;
 
-                } else if (rBucket->mTimeout <= (lTimeAfterSleep + (mHeadOfLineBlockingTimeoutms * 1000))) {
+                } else if (headOfLineExpired(rBucket, lTimeAfterSleep)) {
                     //We got HOL but the next frame has timed out meaning the time out of the bucket + the HOL timeout
                     //We need now need to jump ahead and reset the mNextExpectedFrameNumber
                     //Assemble all data for delivery and reset the HOL pointer.
@@ -690,21 +2471,7 @@ void ElasticFrameProtocolReceiver::receiverWorker() {
                     } else {
                         //The frame is newer than the head
                         //Assemble all data for delivery
-                        {
-                            std::lock_guard<std::mutex> lk(mSuperFrameMtx);
-                            rBucket->mBucketData->mDataContent = rBucket->mDataContent;
-                            rBucket->mBucketData->mBroken =
-                                    rBucket->mFragmentCounter != rBucket->mOfFragmentNo;
-                            rBucket->mBucketData->mPts = rBucket->mPts;
-                            rBucket->mBucketData->mDts = rBucket->mDts;
-                            rBucket->mBucketData->mCode = rBucket->mCode;
-                            rBucket->mBucketData->mStreamID = rBucket->mStream;
-                            rBucket->mBucketData->mSource = rBucket->mSource;
-                            rBucket->mBucketData->mFlags = rBucket->mFlags;
-                            mSuperFrameQueue.push_back(std::move(rBucket->mBucketData));
-                            mSuperFrameReady = true;
-                        }
-                        mSuperFrameDeliveryConditionVariable.notify_one();
+                        queueSuperFrame(rBucket);
                         mBucketMap.erase(rBucket->mDeliveryOrder);
                         rBucket->mActive = false;
                         mNextExpectedFrameNumber = rBucket->mDeliveryOrder + 1;
@@ -719,21 +2486,7 @@ void ElasticFrameProtocolReceiver::receiverWorker() {
             //We are not in HOL mode.. This means just deliver as the frames arrive or times out
             for (auto &rBucket: lCandidates) {
                 //Assemble all data for delivery
-                {
-                    std::lock_guard<std::mutex> lk(mSuperFrameMtx);
-                    rBucket->mBucketData->mDataContent = rBucket->mDataContent;
-                    rBucket->mBucketData->mBroken =
-                            rBucket->mFragmentCounter != rBucket->mOfFragmentNo;
-                    rBucket->mBucketData->mPts = rBucket->mPts;
-                    rBucket->mBucketData->mDts = rBucket->mDts;
-                    rBucket->mBucketData->mCode = rBucket->mCode;
-                    rBucket->mBucketData->mStreamID = rBucket->mStream;
-                    rBucket->mBucketData->mSource = rBucket->mSource;
-                    rBucket->mBucketData->mFlags = rBucket->mFlags;
-                    mSuperFrameQueue.push_back(std::move(rBucket->mBucketData));
-                    mSuperFrameReady = true;
-                }
-                mSuperFrameDeliveryConditionVariable.notify_one();
+                queueSuperFrame(rBucket);
                 mBucketMap.erase(rBucket->mDeliveryOrder);
                 rBucket->mActive = false;
             }
@@ -744,6 +2497,13 @@ void ElasticFrameProtocolReceiver::receiverWorker() {
 
         mNetMtx.unlock();
 
+        // Outside mNetMtx since the queue policy may block until the consumer has taken superframes
+        pushSuperFrames(true);
+
+#ifdef EFP_COROUTINES
+        resumeCoroutines();
+#endif
+
         // Is more than 75% of the buffer used. //FIXME notify the user in some way
         if (lActiveCount > (CIRCULAR_BUFFER_SIZE / 4) * 3) {
             EFP_LOGGER(true, LOGG_WARN, "Current active buckets are more than 75% of the circular buffer.")
@@ -765,6 +2525,7 @@ ElasticFrameMessages ElasticFrameProtocolReceiver::stopReceiver() {
         mSuperFrameReady = true;
     }
     mSuperFrameDeliveryConditionVariable.notify_one();
+    mSuperFrameSpaceConditionVariable.notify_one();
 
     //check for it to actually stop
     while (mIsWorkerThreadActive || mIsDeliveryThreadActive) {
@@ -775,7 +2536,27 @@ ElasticFrameMessages ElasticFrameProtocolReceiver::stopReceiver() {
             return ElasticFrameMessages::failedStoppingReceiver;
         }
     }
-    return ElasticFrameMessages::noError;
+
+    // The receiver worker is stopped. Now stop the lanes.
+    ElasticFrameMessages lStatus = ElasticFrameMessages::noError;
+    for (auto &rLane: mDeliveryLanes) {
+        if (rLane && stopLane(std::move(rLane)) != ElasticFrameMessages::noError) {
+            lStatus = ElasticFrameMessages::failedStoppingReceiver;
+        }
+    }
+
+#ifdef EFP_COROUTINES
+    // Resume a coroutine waiting for a superframe. It will get a nullptr.
+    {
+        std::lock_guard<std::mutex> lk(mSuperFrameMtx);
+        if (pFrameWaiter) {
+            pFrameWaiter = nullptr;
+            mCoroutinesToResume.push_back(mFrameWaiterHandle);
+        }
+    }
+    resumeCoroutines();
+#endif
+    return lStatus;
 }
 
 ElasticFrameMessages
@@ -792,72 +2573,154 @@ ElasticFrameProtocolReceiver::receiveFragmentFromPtr(const uint8_t *pSubPacket,
     // Type 2 are frames smaller than MTU
     // Type 2 packets are also used at the end of Type 1 packet superFrames
     // Type 3 frames carry the reminder of data when it's too large for type2 to carry.
+    // Type 5 frames carry FEC parity for type 1 fragments.
+    // Type 7 are frames larger than MTU where the size is unknown when sending starts (ended by type 3 and/or type 2)
 
     ElasticFrameMessages lMessage;
 
-    std::lock_guard<std::mutex> lock(mReceiveMtx);
-
-    if (!(mIsWorkerThreadActive & mIsDeliveryThreadActive) && mCurrentMode == EFPReceiverMode::THREADED) {
-        EFP_LOGGER(true, LOGG_ERROR, "Receiver not running")
-        return ElasticFrameMessages::receiverNotRunning;
-    }
+    {
+        std::lock_guard<std::mutex> lock(mReceiveMtx);
 
-    if ((pSubPacket[0] & (uint8_t)0x0f) == Frametype::type0) {
-        return ElasticFrameMessages::type0Frame;
-    } else if ((pSubPacket[0] & (uint8_t)0x0f) == Frametype::type1) {
-        if (lPacketSize < sizeof(ElasticFrameType1)) {
-            return ElasticFrameMessages::frameSizeMismatch;
+        if ((!(mIsWorkerThreadActive & mIsDeliveryThreadActive) && mCurrentMode == EFPReceiverMode::THREADED) ||
+            (!mIsWorkerThreadActive && mCurrentMode == EFPReceiverMode::PULL)) {
+            EFP_LOGGER(true, LOGG_ERROR, "Receiver not running")
+            return ElasticFrameMessages::receiverNotRunning;
         }
-        lMessage = unpackType1(pSubPacket, lPacketSize, lFromSource);
-        if (mCurrentMode == EFPReceiverMode::RUN_TO_COMPLETION) {
-            runToCompletionMethod(rReceiveFunction);
-        }
-        return lMessage;
-    } else if ((pSubPacket[0] & (uint8_t)0x0f) == Frametype::type2) {
-        if (lPacketSize < sizeof(ElasticFrameType2)) {
-            return ElasticFrameMessages::frameSizeMismatch;
+
+        if ((pSubPacket[0] & (uint8_t)0x0f) == Frametype::type0) {
+            return ElasticFrameMessages::type0Frame;
+        } else if ((pSubPacket[0] & (uint8_t)0x0f) == Frametype::type1) {
+            if (lPacketSize < sizeof(ElasticFrameType1)) {
+                return ElasticFrameMessages::frameSizeMismatch;
+            }
+            lMessage = unpackType1(pSubPacket, lPacketSize, lFromSource);
+        } else if ((pSubPacket[0] & (uint8_t)0x0f) == Frametype::type2) {
+            if (lPacketSize < sizeof(ElasticFrameType2)) {
+                return ElasticFrameMessages::frameSizeMismatch;
+            }
+            lMessage = unpackType2(pSubPacket, lPacketSize, lFromSource);
+        } else if ((pSubPacket[0] & (uint8_t)0x0f) == Frametype::type3) {
+            if (lPacketSize < sizeof(ElasticFrameType3)) {
+                return ElasticFrameMessages::frameSizeMismatch;
+            }
+            lMessage = unpackType3(pSubPacket, lPacketSize, lFromSource);
+        } else if ((pSubPacket[0] & (uint8_t)0x0f) == Frametype::type7) {
+            if (lPacketSize <= sizeof(ElasticFrameType7)) {
+                return ElasticFrameMessages::frameSizeMismatch;
+            }
+            lMessage = unpackType7(pSubPacket, lPacketSize, lFromSource);
+        } else if ((pSubPacket[0] & (uint8_t)0x0f) == Frametype::type5) {
+            if (lPacketSize < sizeof(ElasticFrameType5)) {
+                return ElasticFrameMessages::frameSizeMismatch;
+            }
+            lMessage = unpackType5(pSubPacket, lPacketSize);
+        } else {
+            // Did not catch anything I understand
+            return ElasticFrameMessages::unknownFrameType;
         }
-        lMessage = unpackType2(pSubPacket, lPacketSize, lFromSource);
+
         if (mCurrentMode == EFPReceiverMode::RUN_TO_COMPLETION) {
-            runToCompletionMethod(rReceiveFunction);
+            runToCompletionMethod(rReceiveFunction, std::chrono::duration_cast<std::chrono::microseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch()).count());
+        } else {
+            // Superframes evicted, flushed or delivered by this fragment. Left to the worker if the delivery queue would block
+            pushSuperFrames(false);
         }
-        return lMessage;
-    } else if ((pSubPacket[0] & (uint8_t)0x0f) == Frametype::type3) {
-        if (lPacketSize < sizeof(ElasticFrameType3)) {
-            return ElasticFrameMessages::frameSizeMismatch;
+    }
+
+    // Outside mReceiveMtx since the user may call the receiver from the callback or the resumed coroutine
+    reportDiscontinuities();
+#ifdef EFP_COROUTINES
+    if (mCurrentMode == EFPReceiverMode::PULL) {
+        resumeCoroutines();
+    }
+#endif
+    return lMessage;
+}
+
+ElasticFrameMessages
+ElasticFrameProtocolReceiver::processTimeouts(const std::function<void(pFramePtr &rPacket, ElasticFrameProtocolContext* pCTX)>& rReceiveFunction) {
+    if (mCurrentMode != EFPReceiverMode::RUN_TO_COMPLETION) {
+        return ElasticFrameMessages::notImplemented;
+    }
+    std::lock_guard<std::mutex> lock(mReceiveMtx);
+    runToCompletionMethod(rReceiveFunction, std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    return ElasticFrameMessages::noError;
+}
+
+// Find the earliest time runToCompletionMethod would do something. That is when a bucket times out, when a complete bucket
+// waiting for the head of line may be delivered or when a NACK is due.
+int64_t ElasticFrameProtocolReceiver::nextDeadline() {
+    std::lock_guard<std::mutex> lock(mReceiveMtx);
+    if (mCurrentMode != EFPReceiverMode::RUN_TO_COMPLETION) {
+        return -1;
+    }
+    std::lock_guard<std::mutex> lockNet(mNetMtx);
+    int64_t lTimeNow = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    int64_t lDeadline = INT64_MAX;
+    bool lNacksActive = nackCallback && mMaxNacks;
+    for (const auto &rBucket : mBucketMap) {
+        Bucket *pBucket = rBucket.second;
+        bool lComplete = pBucket->mFragmentCounter == pBucket->mOfFragmentNo;
+        if (lComplete && !mHeadOfLineBlockingTimeoutms) {
+            return 0;
         }
-        lMessage = unpackType3(pSubPacket, lPacketSize, lFromSource);
-        if (mCurrentMode == EFPReceiverMode::RUN_TO_COMPLETION) {
-            runToCompletionMethod(rReceiveFunction);
+        int64_t lBucketDeadline = pBucket->mTimeout;
+        if (lComplete) {
+            lBucketDeadline -= (mHeadOfLineBlockingTimeoutms * 1000);
+            if (pBucket->mDeliveryOrder == mNextExpectedFrameNumber || mDeliveryHOLFirstRun) {
+                return 0;
+            }
+        } else if (lNacksActive && pBucket->mNackCounter < mMaxNacks) {
+            lBucketDeadline = std::min(lBucketDeadline, pBucket->mNextNackTime);
         }
-        return lMessage;
+        lDeadline = std::min(lDeadline, lBucketDeadline);
+    }
+    if (lDeadline == INT64_MAX) {
+        return -1;
     }
-    // Did not catch anything I understand
-    return ElasticFrameMessages::unknownFrameType;
+    return std::max(lDeadline - lTimeNow, (int64_t) 0);
 }
 
 ElasticFrameMessages ElasticFrameProtocolReceiver::extractEmbeddedData(ElasticFrameProtocolReceiver::pFramePtr &rPacket,
                                                                        std::vector<std::vector<uint8_t>> *pEmbeddedDataList,
                                                                        std::vector<uint8_t> *pDataContent,
                                                                        size_t *pPayloadDataPosition) {
-    bool lMoreData;
-    size_t lHeaderSize = sizeof(ElasticFrameContentNamespace::ElasticEmbeddedHeader);
+    EmbeddedData lEmbeddedData;
     do {
-        ElasticFrameContentNamespace::ElasticEmbeddedHeader lEmbeddedHeader =
-                *(ElasticFrameContentNamespace::ElasticEmbeddedHeader *) (rPacket->pFrameData + *pPayloadDataPosition);
-        if (lEmbeddedHeader.mEmbeddedFrameType == ElasticEmbeddedFrameContent::illegal) {
-            return ElasticFrameMessages::illegalEmbeddedData;
+        ElasticFrameMessages lStatus = nextEmbeddedData(rPacket, pPayloadDataPosition, &lEmbeddedData);
+        if (lStatus != ElasticFrameMessages::noError) {
+            return lStatus;
         }
-        pDataContent->emplace_back((lEmbeddedHeader.mEmbeddedFrameType & (uint8_t)0x7f));
-        std::vector<uint8_t> lEmbeddedData(lEmbeddedHeader.mSize);
-        std::copy_n(rPacket->pFrameData + lHeaderSize + *pPayloadDataPosition, lEmbeddedHeader.mSize, lEmbeddedData.data());
-        pEmbeddedDataList->emplace_back(lEmbeddedData);
-        lMoreData = lEmbeddedHeader.mEmbeddedFrameType & (uint8_t)0x80;
-        *pPayloadDataPosition += (lEmbeddedHeader.mSize + lHeaderSize);
-        if (*pPayloadDataPosition >= rPacket->mFrameSize) {
-            return ElasticFrameMessages::bufferOutOfBounds;
-        }
-    } while (!lMoreData);
+        pDataContent->emplace_back(lEmbeddedData.mDataContent);
+        pEmbeddedDataList->emplace_back(lEmbeddedData.pData, lEmbeddedData.pData + lEmbeddedData.mSize);
+    } while (!lEmbeddedData.mLast);
+    return ElasticFrameMessages::noError;
+}
+
+ElasticFrameMessages ElasticFrameProtocolReceiver::nextEmbeddedData(const ElasticFrameProtocolReceiver::pFramePtr &rPacket,
+                                                                    size_t *pPosition,
+                                                                    EmbeddedData *pEmbeddedData) {
+    size_t lHeaderSize = sizeof(ElasticFrameContentNamespace::ElasticEmbeddedHeader);
+    if (*pPosition + lHeaderSize > rPacket->mFrameSize) {
+        return ElasticFrameMessages::bufferOutOfBounds;
+    }
+    ElasticFrameContentNamespace::ElasticEmbeddedHeader lEmbeddedHeader =
+            *(ElasticFrameContentNamespace::ElasticEmbeddedHeader *) (rPacket->pFrameData + *pPosition);
+    if (lEmbeddedHeader.mEmbeddedFrameType == ElasticEmbeddedFrameContent::illegal) {
+        return ElasticFrameMessages::illegalEmbeddedData;
+    }
+    // There must be payload after the last section
+    if (*pPosition + lHeaderSize + lEmbeddedHeader.mSize >= rPacket->mFrameSize) {
+        return ElasticFrameMessages::bufferOutOfBounds;
+    }
+    pEmbeddedData->mDataContent = lEmbeddedHeader.mEmbeddedFrameType & (uint8_t)0x7f;
+    pEmbeddedData->pData = rPacket->pFrameData + *pPosition + lHeaderSize;
+    pEmbeddedData->mSize = lEmbeddedHeader.mSize;
+    pEmbeddedData->mLast = lEmbeddedHeader.mEmbeddedFrameType & (uint8_t)0x80;
+    *pPosition += lHeaderSize + lEmbeddedHeader.mSize;
     return ElasticFrameMessages::noError;
 }
 
@@ -904,6 +2767,34 @@ void ElasticFrameProtocolSender::sendData(const std::vector<uint8_t> &rSubPacket
     }
 }
 
+// Send a fragment. If a send function is provided it overrides the sendCallback
+void ElasticFrameProtocolSender::sendFragment(const std::vector<uint8_t> &rFragment, uint8_t lStreamID,
+                                              const std::function<void(const std::vector<uint8_t> &rSubPacket,
+                                                                       uint8_t streamID)>& rSendFunction) {
+    if (rSendFunction) {
+        rSendFunction(rFragment, lStreamID);
+    } else {
+        sendCallback(rFragment, lStreamID, mCTX ? mCTX.get() : nullptr);
+    }
+}
+
+// mSendMtx must be held by the caller
+// Save the fragment in the retransmit ring overwriting the oldest entry
+void ElasticFrameProtocolSender::cacheFragment(const std::vector<uint8_t> &rFragment, uint16_t lSuperFrameNo, uint16_t lFragmentNo, uint8_t lStreamID) {
+    CachedFragment &rEntry = mRetransmitCache[mRetransmitCachePosition];
+    auto lOldEntry = mRetransmitCacheIndex.find(rEntry.mKey);
+    if (lOldEntry != mRetransmitCacheIndex.end() && lOldEntry->second == mRetransmitCachePosition) {
+        mRetransmitCacheIndex.erase(lOldEntry);
+    }
+    rEntry.mKey = ((uint32_t) lSuperFrameNo << 16) | lFragmentNo;
+    rEntry.mStreamID = lStreamID;
+    rEntry.mData.assign(rFragment.begin(), rFragment.end());
+    mRetransmitCacheIndex[rEntry.mKey] = mRetransmitCachePosition;
+    if (++mRetransmitCachePosition == mRetransmitCache.size()) {
+        mRetransmitCachePosition = 0;
+    }
+}
+
 // Pack data method. Fragments the data and calls the sendCallback method at the host level.
 ElasticFrameMessages
 ElasticFrameProtocolSender::packAndSend(const std::vector<uint8_t> &rPacket, ElasticFrameContent lDataContent,
@@ -925,6 +2816,77 @@ ElasticFrameProtocolSender::packAndSendFromPtr(const uint8_t *rPacket, size_t lP
                                                const std::function<void(const std::vector<uint8_t> &rSubPacket,
                                                                         uint8_t streamID)>& rSendFunction) {
     std::lock_guard<std::mutex> lock(mSendMtx);
+    mGatherSegments.clear();
+    mGatherSegments.emplace_back(rPacket, lPacketSize);
+    return packAndSendSegments(lPacketSize, lDataContent, lPts, lDts, lCode, lStreamID, lFlags, rSendFunction);
+}
+
+// Pack data method. The embedded data headers are generated and the sections and payload are copied straight into the
+// fragments
+ElasticFrameMessages
+ElasticFrameProtocolSender::packAndSend(const EmbeddedSection *pEmbeddedData, size_t lNumberOfSections,
+                                        const uint8_t *pPayload, size_t lPayloadSize,
+                                        ElasticFrameContent lDataContent,
+                                        uint64_t lPts, uint64_t lDts,
+                                        uint32_t lCode, uint8_t lStreamID, uint8_t lFlags,
+                                        const std::function<void(const std::vector<uint8_t> &rSubPacket,
+                                                                 uint8_t streamID)>& rSendFunction) {
+    std::lock_guard<std::mutex> lock(mSendMtx);
+    size_t lPacketSize = lPayloadSize;
+    mGatherHeaders.resize(lNumberOfSections);
+    mGatherSegments.clear();
+    for (size_t x = 0; x < lNumberOfSections; x++) {
+        const EmbeddedSection &rSection = pEmbeddedData[x];
+        if (rSection.mSize > UINT16_MAX) {
+            return ElasticFrameMessages::tooLargeEmbeddedData;
+        }
+        if (rSection.mContent == ElasticEmbeddedFrameContent::illegal ||
+            rSection.mContent & ElasticEmbeddedFrameContent::lastembeddedcontent) {
+            return ElasticFrameMessages::illegalEmbeddedData;
+        }
+        ElasticFrameContentNamespace::ElasticEmbeddedHeader &rHeader = mGatherHeaders[x];
+        rHeader.mSize = (uint16_t) rSection.mSize;
+        rHeader.mEmbeddedFrameType = rSection.mContent;
+        if (x == lNumberOfSections - 1) {
+            rHeader.mEmbeddedFrameType |= ElasticEmbeddedFrameContent::lastembeddedcontent;
+        }
+        mGatherSegments.emplace_back((const uint8_t *) &rHeader, sizeof(rHeader));
+        mGatherSegments.emplace_back(rSection.pData, rSection.mSize);
+        lPacketSize += sizeof(rHeader) + rSection.mSize;
+    }
+    mGatherSegments.emplace_back(pPayload, lPayloadSize);
+    if (lNumberOfSections) {
+        lFlags |= INLINE_PAYLOAD;
+    }
+    return packAndSendSegments(lPacketSize, lDataContent, lPts, lDts, lCode, lStreamID, lFlags, rSendFunction);
+}
+
+// Copy the next lSize bytes of the superframe from mGatherSegments
+void ElasticFrameProtocolSender::gatherCopy(uint8_t *pDst, size_t lSize) {
+    while (lSize) {
+        const std::pair<const uint8_t *, size_t> &rSegment = mGatherSegments[mGatherSegment];
+        size_t lCopy = std::min(lSize, rSegment.second - mGatherOffset);
+        copyData(pDst, rSegment.first + mGatherOffset, lCopy, false);
+        pDst += lCopy;
+        lSize -= lCopy;
+        mGatherOffset += lCopy;
+        if (mGatherOffset == rSegment.second) {
+            mGatherSegment++;
+            mGatherOffset = 0;
+        }
+    }
+}
+
+// mSendMtx must be held by the caller
+// Fragments the superframe described by mGatherSegments (lPacketSize bytes in total)
+ElasticFrameMessages
+ElasticFrameProtocolSender::packAndSendSegments(size_t lPacketSize, ElasticFrameContent lDataContent,
+                                                uint64_t lPts, uint64_t lDts,
+                                                uint32_t lCode, uint8_t lStreamID, uint8_t lFlags,
+                                                const std::function<void(const std::vector<uint8_t> &rSubPacket,
+                                                                         uint8_t streamID)>& rSendFunction) {
+    mGatherSegment = 0;
+    mGatherOffset = 0;
 
     if (sizeof(ElasticFrameType1) != sizeof(ElasticFrameType3)) {
         return ElasticFrameMessages::type1And3SizeError;
@@ -974,11 +2936,10 @@ ElasticFrameProtocolSender::packAndSendFromPtr(const uint8_t *rPacket, size_t lP
         pType2Frame->hPts = lPts;
         pType2Frame->hDtsPtsDiff = (uint32_t) lPtsDtsDiff;
         pType2Frame->hCode = lCode;
-        std::copy_n(rPacket, lPacketSize, mSendBufferEnd.data() + sizeof(ElasticFrameType2));
-        if (rSendFunction) {
-            rSendFunction(mSendBufferEnd, lStreamID);
-        } else {
-            sendCallback(mSendBufferEnd, lStreamID, mCTX ? mCTX.get() : nullptr);
+        gatherCopy(mSendBufferEnd.data() + sizeof(ElasticFrameType2), lPacketSize);
+        sendFragment(mSendBufferEnd, lStreamID, rSendFunction);
+        if (!mRetransmitCache.empty()) {
+            cacheFragment(mSendBufferEnd, mSuperFrameNoGenerator, 0, lStreamID);
         }
         mSuperFrameNoGenerator++;
         return ElasticFrameMessages::noError;
@@ -1008,14 +2969,42 @@ ElasticFrameProtocolSender::packAndSendFromPtr(const uint8_t *rPacket, size_t lP
     pType1Frame->hSuperFrameNo = mSuperFrameNoGenerator;
     pType1Frame->hOfFragmentNo = lOfFragmentNo;
 
+    // FEC parity is accumulated over the type1 fragments and sent after each group
+    uint16_t lFECGroupSize = mFECGroupSize[lStreamID];
+    uint16_t lFECGroupStart = 0;
+    ElasticFrameType5 *pType5Frame = nullptr;
+    if (lFECGroupSize) {
+        mSendBufferFEC.resize(sizeof(ElasticFrameType5) + lDataPayloadType1);
+        pType5Frame = (ElasticFrameType5*)mSendBufferFEC.data();
+        pType5Frame->hFrameType = Frametype::type5 | lFlags;
+        pType5Frame->hStreamID = lStreamID;
+        pType5Frame->hSuperFrameNo = mSuperFrameNoGenerator;
+        pType5Frame->hOfFragmentNo = lOfFragmentNo;
+        pType5Frame->hType1PacketSize = (uint16_t) lDataPayloadType1;
+    }
+
     while (lFragmentNo < lOfFragmentNoType1) {
         pType1Frame->hFragmentNo = lFragmentNo++;
-        std::copy_n(rPacket + lDataPointer, lDataPayloadType1, mSendBufferFixed.data() + sizeof(ElasticFrameType1));
+        gatherCopy(mSendBufferFixed.data() + sizeof(ElasticFrameType1), lDataPayloadType1);
         lDataPointer += lDataPayloadType1;
-        if (rSendFunction) {
-            rSendFunction(mSendBufferFixed, lStreamID);
-        } else {
-            sendCallback(mSendBufferFixed, lStreamID, mCTX ? mCTX.get() : nullptr);
+        sendFragment(mSendBufferFixed, lStreamID, rSendFunction);
+        if (!mRetransmitCache.empty()) {
+            cacheFragment(mSendBufferFixed, mSuperFrameNoGenerator, pType1Frame->hFragmentNo, lStreamID);
+        }
+
+        if (pType5Frame) {
+            if (pType1Frame->hFragmentNo == lFECGroupStart) {
+                std::copy_n(mSendBufferFixed.data() + sizeof(ElasticFrameType1), lDataPayloadType1, mSendBufferFEC.data() + sizeof(ElasticFrameType5));
+            } else {
+                xorBlock(mSendBufferFEC.data() + sizeof(ElasticFrameType5), mSendBufferFixed.data() + sizeof(ElasticFrameType1), lDataPayloadType1);
+            }
+            // Send the parity when the group is full or when there are no more type1 fragments
+            if (lFragmentNo - lFECGroupStart == lFECGroupSize || lFragmentNo == lOfFragmentNoType1) {
+                pType5Frame->hFragmentNo = lFECGroupStart;
+                pType5Frame->hGroupSize = lFragmentNo - lFECGroupStart;
+                sendFragment(mSendBufferFEC, lStreamID, rSendFunction);
+                lFECGroupStart = lFragmentNo;
+            }
         }
     }
 
@@ -1028,16 +3017,15 @@ ElasticFrameProtocolSender::packAndSendFromPtr(const uint8_t *rPacket, size_t lP
         pType3Frame->hSuperFrameNo = mSuperFrameNoGenerator;
         pType3Frame->hType1PacketSize = (uint16_t) (mCurrentMTU - sizeof(ElasticFrameType1));
         pType3Frame->hOfFragmentNo = lOfFragmentNo;
-        std::copy_n(rPacket + lDataPointer, lReminderData, mSendBufferEnd.data() + sizeof(ElasticFrameType3));
+        gatherCopy(mSendBufferEnd.data() + sizeof(ElasticFrameType3), lReminderData);
         lDataPointer += lReminderData;
         if (lDataPointer != lPacketSize) {
             return ElasticFrameMessages::internalCalculationError;
         }
 
-        if (rSendFunction) {
-            rSendFunction(mSendBufferEnd, lStreamID);
-        } else {
-            sendCallback(mSendBufferEnd, lStreamID, mCTX ? mCTX.get() : nullptr);
+        sendFragment(mSendBufferEnd, lStreamID, rSendFunction);
+        if (!mRetransmitCache.empty()) {
+            cacheFragment(mSendBufferEnd, mSuperFrameNoGenerator, lOfFragmentNo - 1, lStreamID);
         }
     }
 
@@ -1070,16 +3058,253 @@ ElasticFrameProtocolSender::packAndSendFromPtr(const uint8_t *rPacket, size_t lP
     pType2Frame->hPts = lPts;
     pType2Frame->hDtsPtsDiff = (uint32_t) lPtsDtsDiff;
     pType2Frame->hCode = lCode;
-    std::copy_n(rPacket + lDataPointer, lDataLeftToSend, mSendBufferEnd.data() + sizeof(ElasticFrameType2));
-    if (rSendFunction) {
-        rSendFunction(mSendBufferEnd, lStreamID);
-    } else {
-        sendCallback(mSendBufferEnd, lStreamID, mCTX ? mCTX.get() : nullptr);
+    gatherCopy(mSendBufferEnd.data() + sizeof(ElasticFrameType2), lDataLeftToSend);
+    sendFragment(mSendBufferEnd, lStreamID, rSendFunction);
+    if (!mRetransmitCache.empty()) {
+        cacheFragment(mSendBufferEnd, mSuperFrameNoGenerator, lOfFragmentNo, lStreamID);
     }
     mSuperFrameNoGenerator++;
     return ElasticFrameMessages::noError;
 }
 
+// Start a streamed superframe. The superframe number is taken now so that the fragments can be sent as soon as they are filled
+ElasticFrameMessages
+ElasticFrameProtocolSender::beginSuperFrame(ElasticFrameContent lDataContent, uint8_t lStreamID, uint8_t lFlags) {
+    std::lock_guard<std::mutex> lock(mSendMtx);
+
+    if (sizeof(ElasticFrameType1) != sizeof(ElasticFrameType7)) {
+        return ElasticFrameMessages::type1And3SizeError;
+    }
+
+    if (mStreamingActive) {
+        return ElasticFrameMessages::superFrameAlreadyStarted;
+    }
+
+    if (lStreamID == 0 && lDataContent != ElasticFrameContent::efpsig) {
+        return ElasticFrameMessages::reservedStreamValue;
+    }
+
+    mStreamingActive = true;
+    mStreamingDataContent = lDataContent;
+    mStreamingStreamID = lStreamID;
+    mStreamingFlags = lFlags & (uint8_t)0xf0;
+    mStreamingSuperFrameNo = mSuperFrameNoGenerator++;
+    mStreamingFragmentNo = 0;
+    mStreamingBufferFill = 0;
+    mStreamingBuffer.resize(mCurrentMTU);
+    auto *pType7Frame = (ElasticFrameType7*)mStreamingBuffer.data();
+    pType7Frame->hFrameType = Frametype::type7 | mStreamingFlags;
+    pType7Frame->hStreamID = lStreamID;
+    pType7Frame->hSuperFrameNo = mStreamingSuperFrameNo;
+    pType7Frame->hType1PacketSize = (uint16_t) (mCurrentMTU - sizeof(ElasticFrameType1));
+    return ElasticFrameMessages::noError;
+}
+
+// Add data to the streamed superframe. Every filled type7 fragment is sent directly
+ElasticFrameMessages
+ElasticFrameProtocolSender::appendData(const uint8_t *pData, size_t lSize,
+                                       const std::function<void(const std::vector<uint8_t> &rSubPacket,
+                                                                uint8_t streamID)>& rSendFunction) {
+    std::lock_guard<std::mutex> lock(mSendMtx);
+
+    if (!mStreamingActive) {
+        return ElasticFrameMessages::noSuperFrameStarted;
+    }
+
+    size_t lDataPayloadType7 = mCurrentMTU - sizeof(ElasticFrameType7);
+    // The type7 fragments, a possible type3 and the type2 must fit the same limit as packAndSend
+    // (USHRT_MAX - 1) fragments before the type2.
+    size_t lMaxData = (lDataPayloadType7 * (USHRT_MAX - 2)) + (lDataPayloadType7 - 1);
+    if (((size_t)mStreamingFragmentNo * lDataPayloadType7) + mStreamingBufferFill + lSize > lMaxData) {
+        return ElasticFrameMessages::tooLargeFrame;
+    }
+
+    auto *pType7Frame = (ElasticFrameType7*)mStreamingBuffer.data();
+    while (lSize) {
+        size_t lCopy = std::min(lSize, lDataPayloadType7 - mStreamingBufferFill);
+        copyData(mStreamingBuffer.data() + sizeof(ElasticFrameType7) + mStreamingBufferFill, pData, lCopy, false);
+        pData += lCopy;
+        lSize -= lCopy;
+        mStreamingBufferFill += lCopy;
+        if (mStreamingBufferFill == lDataPayloadType7) {
+            pType7Frame->hFragmentNo = mStreamingFragmentNo;
+            sendFragment(mStreamingBuffer, mStreamingStreamID, rSendFunction);
+            if (!mRetransmitCache.empty()) {
+                cacheFragment(mStreamingBuffer, mStreamingSuperFrameNo, mStreamingFragmentNo, mStreamingStreamID);
+            }
+            mStreamingFragmentNo++;
+            mStreamingBufferFill = 0;
+        }
+    }
+    return ElasticFrameMessages::noError;
+}
+
+// Close the streamed superframe. The remaining data is sent in a type2 (or a type3 followed by a empty type2 if it does not fit)
+ElasticFrameMessages
+ElasticFrameProtocolSender::endSuperFrame(uint64_t lPts, uint64_t lDts, uint32_t lCode,
+                                          const std::function<void(const std::vector<uint8_t> &rSubPacket,
+                                                                   uint8_t streamID)>& rSendFunction) {
+    std::lock_guard<std::mutex> lock(mSendMtx);
+
+    if (!mStreamingActive) {
+        return ElasticFrameMessages::noSuperFrameStarted;
+    }
+
+    if (lPts == UINT64_MAX) {
+        return ElasticFrameMessages::reservedPTSValue;
+    }
+
+    if (lDts == UINT64_MAX) {
+        return ElasticFrameMessages::reservedDTSValue;
+    }
+
+    if (lCode == UINT32_MAX) {
+        return ElasticFrameMessages::reservedCodeValue;
+    }
+
+    uint64_t lPtsDtsDiff = lPts - lDts;
+    if (lPtsDtsDiff >= UINT32_MAX) {
+        return ElasticFrameMessages::dtsptsDiffToLarge;
+    }
+
+    mStreamingActive = false;
+    uint16_t lOfFragmentNo = mStreamingFragmentNo;
+    const uint8_t *pReminderData = mStreamingBuffer.data() + sizeof(ElasticFrameType7);
+    size_t lDataLeftToSend = mStreamingBufferFill;
+
+    if (lDataLeftToSend + sizeof(ElasticFrameType2) > mCurrentMTU) {
+        lOfFragmentNo++;
+        mSendBufferEnd.resize(sizeof(ElasticFrameType3) + lDataLeftToSend);
+        auto *pType3Frame = (ElasticFrameType3*)mSendBufferEnd.data();
+        pType3Frame->hFrameType = Frametype::type3 | mStreamingFlags;
+        pType3Frame->hStreamID = mStreamingStreamID;
+        pType3Frame->hSuperFrameNo = mStreamingSuperFrameNo;
+        pType3Frame->hType1PacketSize = (uint16_t) (mCurrentMTU - sizeof(ElasticFrameType1));
+        pType3Frame->hOfFragmentNo = lOfFragmentNo;
+        std::copy_n(pReminderData, lDataLeftToSend, mSendBufferEnd.data() + sizeof(ElasticFrameType3));
+        sendFragment(mSendBufferEnd, mStreamingStreamID, rSendFunction);
+        if (!mRetransmitCache.empty()) {
+            cacheFragment(mSendBufferEnd, mStreamingSuperFrameNo, lOfFragmentNo - 1, mStreamingStreamID);
+        }
+        lDataLeftToSend = 0;
+    }
+
+    mSendBufferEnd.resize(sizeof(ElasticFrameType2) + lDataLeftToSend);
+    auto *pType2Frame = (ElasticFrameType2 *)mSendBufferEnd.data();
+    pType2Frame->hFrameType  = Frametype::type2 | mStreamingFlags;
+    pType2Frame->hStreamID = mStreamingStreamID;
+    pType2Frame->hDataContent = mStreamingDataContent;
+    pType2Frame->hSizeOfData = (uint16_t) lDataLeftToSend;
+    pType2Frame->hSuperFrameNo = mStreamingSuperFrameNo;
+    pType2Frame->hOfFragmentNo = lOfFragmentNo;
+    pType2Frame->hType1PacketSize = (uint16_t) (mCurrentMTU - sizeof(ElasticFrameType1));
+    pType2Frame->hPts = lPts;
+    pType2Frame->hDtsPtsDiff = (uint32_t) lPtsDtsDiff;
+    pType2Frame->hCode = lCode;
+    std::copy_n(pReminderData, lDataLeftToSend, mSendBufferEnd.data() + sizeof(ElasticFrameType2));
+    sendFragment(mSendBufferEnd, mStreamingStreamID, rSendFunction);
+    if (!mRetransmitCache.empty()) {
+        cacheFragment(mSendBufferEnd, mStreamingSuperFrameNo, lOfFragmentNo, mStreamingStreamID);
+    }
+    return ElasticFrameMessages::noError;
+}
+
+#ifdef EFP_COROUTINES
+void ElasticFrameProtocolSender::setBackpressure(bool lBackpressure) {
+    std::deque<std::coroutine_handle<>> lWaiters;
+    {
+        std::lock_guard<std::mutex> lock(mCoroutineMtx);
+        mBackpressure = lBackpressure;
+        if (!lBackpressure) {
+            lWaiters.swap(mSendWaiters);
+        }
+    }
+    // Resume outside the lock. The coroutines will send their data.
+    for (auto &rHandle: lWaiters) {
+        if (coroutineExecutor) {
+            coroutineExecutor(rHandle);
+        } else {
+            rHandle.resume();
+        }
+    }
+}
+
+bool ElasticFrameProtocolSender::SendAwaitable::await_ready() {
+    std::lock_guard<std::mutex> lock(pSender->mCoroutineMtx);
+    return !pSender->mBackpressure;
+}
+
+bool ElasticFrameProtocolSender::SendAwaitable::await_suspend(std::coroutine_handle<> lHandle) {
+    std::lock_guard<std::mutex> lock(pSender->mCoroutineMtx);
+    // The backpressure might have been cleared after await_ready
+    if (!pSender->mBackpressure) {
+        return false;
+    }
+    pSender->mSendWaiters.push_back(lHandle);
+    return true;
+}
+
+ElasticFrameMessages ElasticFrameProtocolSender::SendAwaitable::await_resume() {
+    return pSender->packAndSendFromPtr(pPacket, mPacketSize, mDataContent, mPts, mDts, mCode, mStreamID, mFlags);
+}
+#endif
+
+// Set the FEC group size for a EFP-stream. 0 disables FEC for the stream
+ElasticFrameMessages ElasticFrameProtocolSender::setFECGroupSize(uint8_t lStreamID, uint16_t lGroupSize) {
+    std::lock_guard<std::mutex> lock(mSendMtx);
+    mFECGroupSize[lStreamID] = lGroupSize;
+    return ElasticFrameMessages::noError;
+}
+
+ElasticFrameMessages ElasticFrameProtocolSender::setRetransmitCacheSize(size_t lNumberOfFragments) {
+    std::lock_guard<std::mutex> lock(mSendMtx);
+    mRetransmitCache.clear();
+    mRetransmitCache.resize(lNumberOfFragments);
+    mRetransmitCacheIndex.clear();
+    mRetransmitCachePosition = 0;
+    return ElasticFrameMessages::noError;
+}
+
+ElasticFrameMessages
+ElasticFrameProtocolSender::receiveNack(const std::vector<uint8_t> &rNack,
+                                        const std::function<void(const std::vector<uint8_t> &rSubPacket,
+                                                                 uint8_t streamID)>& rSendFunction) {
+    return receiveNackFromPtr(rNack.data(), rNack.size(), rSendFunction);
+}
+
+// Re-send the fragments in the NACK found in the retransmit cache
+ElasticFrameMessages
+ElasticFrameProtocolSender::receiveNackFromPtr(const uint8_t *pNack, size_t lNackSize,
+                                               const std::function<void(const std::vector<uint8_t> &rSubPacket,
+                                                                        uint8_t streamID)>& rSendFunction) {
+    std::lock_guard<std::mutex> lock(mSendMtx);
+    if (lNackSize < sizeof(ElasticFrameType6)) {
+        return ElasticFrameMessages::frameSizeMismatch;
+    }
+    auto *pType6Frame = (ElasticFrameType6 *) pNack;
+    if ((pType6Frame->hFrameType & (uint8_t)0x0f) != Frametype::type6) {
+        return ElasticFrameMessages::unknownFrameType;
+    }
+    if (lNackSize != sizeof(ElasticFrameType6) + (pType6Frame->hNumberOfRanges * sizeof(ElasticNackRange))) {
+        return ElasticFrameMessages::frameSizeMismatch;
+    }
+
+    ElasticFrameMessages lMessage = ElasticFrameMessages::noError;
+    auto *pRange = (ElasticNackRange *) (pNack + sizeof(ElasticFrameType6));
+    for (uint16_t lRange = 0; lRange < pType6Frame->hNumberOfRanges; lRange++) {
+        for (uint32_t lFragmentNo = pRange[lRange].hFirstFragmentNo; lFragmentNo <= pRange[lRange].hLastFragmentNo; lFragmentNo++) {
+            auto lEntry = mRetransmitCacheIndex.find(((uint32_t) pType6Frame->hSuperFrameNo << 16) | lFragmentNo);
+            if (lEntry == mRetransmitCacheIndex.end()) {
+                lMessage = ElasticFrameMessages::fragmentNotCached;
+                continue;
+            }
+            CachedFragment &rCachedFragment = mRetransmitCache[lEntry->second];
+            sendFragment(rCachedFragment.mData, rCachedFragment.mStreamID, rSendFunction);
+        }
+    }
+    return lMessage;
+}
+
 // Helper methods for embedding/extracting data in the payload part. It's not recommended to use these methods in production code as it's better to build the
 // frames externally to avoid insert and copy of data.
 ElasticFrameMessages ElasticFrameProtocolSender::addEmbeddedData(std::vector<uint8_t> *pPacket,
@@ -1215,8 +3440,42 @@ int16_t efp_send_data(uint64_t efp_object,
                                                   flags);
 }
 
+static_assert(sizeof(efp_embedded_section) == sizeof(ElasticFrameProtocolSender::EmbeddedSection) &&
+              offsetof(efp_embedded_section, size) == offsetof(ElasticFrameProtocolSender::EmbeddedSection, mSize) &&
+              offsetof(efp_embedded_section, type) == offsetof(ElasticFrameProtocolSender::EmbeddedSection, mContent),
+              "efp_embedded_section must have the layout of ElasticFrameProtocolSender::EmbeddedSection");
+
+int16_t efp_send_data_embedded(uint64_t efp_object,
+                               const efp_embedded_section *sections,
+                               size_t number_of_sections,
+                               const uint8_t *data,
+                               size_t size,
+                               uint8_t dataContent,
+                               uint64_t pts,
+                               uint64_t dts,
+                               uint32_t code,
+                               uint8_t streamID,
+                               uint8_t flags) {
+    std::lock_guard<std::mutex> lock(efp_send_mutex);
+    auto efp_base = efp_send_base_map.find(efp_object)->second;
+    if (efp_base == nullptr) {
+        return (int16_t) ElasticFrameMessages::efpCAPIfailure;
+    }
+    return (int16_t) efp_base->packAndSend((const ElasticFrameProtocolSender::EmbeddedSection *) sections,
+                                           number_of_sections,
+                                           data,
+                                           size,
+                                           (ElasticFrameContent) dataContent,
+                                           pts,
+                                           dts,
+                                           code,
+                                           streamID,
+                                           flags);
+}
+
 //This is a helper method for embedding data.
 //The preferred way of embedding data is to do that when assembling the frame to avoid memory copy
+//(or use efp_send_data_embedded)
 size_t efp_add_embedded_data(uint8_t *pDst, uint8_t *pESrc, uint8_t *pDSrc, size_t embeddedDatasize, size_t dataSize, uint8_t type, uint8_t isLast) {
     if (pDst == nullptr) {
         return (sizeof(ElasticFrameContentNamespace::ElasticEmbeddedHeader) + embeddedDatasize + dataSize);
@@ -1250,6 +3509,24 @@ int16_t efp_receive_fragment(uint64_t efp_object,
     return (int16_t) efp_base->receiveFragmentFromPtr(pSubPacket, packetSize, fromSource);
 }
 
+int16_t efp_process_timeouts(uint64_t efp_object) {
+    std::lock_guard<std::mutex> lock(efp_receive_mutex);
+    auto efp_base = efp_receive_base_map.find(efp_object)->second;
+    if (efp_base == nullptr) {
+        return (int16_t) ElasticFrameMessages::efpCAPIfailure;
+    }
+    return (int16_t) efp_base->processTimeouts();
+}
+
+int64_t efp_next_deadline(uint64_t efp_object) {
+    std::lock_guard<std::mutex> lock(efp_receive_mutex);
+    auto efp_base = efp_receive_base_map.find(efp_object)->second;
+    if (efp_base == nullptr) {
+        return -1;
+    }
+    return efp_base->nextDeadline();
+}
+
 int16_t efp_end_send(uint64_t efp_object) {
     std::lock_guard<std::mutex> lock(efp_send_mutex);
     auto efp_base = efp_send_base_map.find(efp_object)->second;
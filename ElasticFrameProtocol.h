@@ -36,12 +36,18 @@
 #include <cmath>
 #include <thread>
 #include <map>
+#include <array>
 #include <any>
 
 #ifndef _WIN64
 #include <unistd.h>
 #endif
 
+#ifdef __linux__
+#include <sys/mman.h>
+#include <sched.h>
+#endif
+
 #include <functional>
 #include <bitset>
 #include <mutex>
@@ -51,6 +57,10 @@
 #include <condition_variable>
 #include <chrono>
 
+#ifdef EFP_COROUTINES
+#include <coroutine>
+#endif
+
 //Generate the C - API
 #ifdef __cplusplus
 extern "C" {
@@ -66,13 +76,20 @@ extern "C" {
 ///The size of the circular buffer. Must be contiguous set bits defining the size  0b1111111111111 == 8191
 #define CIRCULAR_BUFFER_SIZE 0b1111111111111
 
+///Superframes from this size are received using non-temporal stores (see setNonTemporalCopyThreshold)
+#define EFP_NON_TEMPORAL_THRESHOLD (1024 * 1024)
+
+///Superframes from this size are placed on huge pages when enabled (see setHugePages)
+#define EFP_HUGE_PAGE_THRESHOLD (2 * 1024 * 1024)
+
 /// Flag defines used py EFP
 #define NO_FLAGS        0b00000000 // Normal operation
 #define INLINE_PAYLOAD  0b00010000 // If the frame contains inline payload the flag must be set
-#define PRIORITY_P0     0b00000000 // Low priority (not implemented)
-#define PRIORITY_P1     0b00100000 // Normal priority (not implemented)
-#define PRIORITY_P2     0b01000000 // High priority (not implemented)
-#define PRIORITY_P3     0b01100000 // God-mode priority (not implemented)
+#define PRIORITY_P0     0b00000000 // Low priority (see ElasticFrameProtocolReceiver::setPriorityDelivery)
+#define PRIORITY_P1     0b00100000 // Normal priority
+#define PRIORITY_P2     0b01000000 // High priority
+#define PRIORITY_P3     0b01100000 // God-mode priority
+#define PRIORITY_MASK   0b01100000 // The priority bits
 #define UNDEFINED_FLAG  0b10000000 // TBD
 
 #define EFP_MAJOR_VERSION 0
@@ -132,6 +149,11 @@ using ElasticEmbeddedFrameContent = ElasticFrameContentNamespace::ElasticFrameEm
 // Positive numbers are informative
 /// ElasticFrameMessages definitions
 enum class ElasticFrameMessages : int16_t {
+    threadConfigFailed          = -30, //The thread configuration could not be applied to all EFP threads (permissions or priority out of range)
+    numaNodeNotAvailable        = -29, //The NUMA node does not exist (or has no CPUs)
+    memoryBudgetExceeded        = -28, //The receiver was refused memory by the shared ElasticFrameProtocolMemoryBudget
+    superFrameAlreadyStarted    = -27, //beginSuperFrame was called while a streamed superframe is already open
+    noSuperFrameStarted         = -26, //appendData/endSuperFrame was called without beginSuperFrame
     dmsgSourceMissing           = -25, //The sender handle is missing DMSG can't control the sender
     versionNotSupported         = -24, //The received version is not supported
     tooHighversion              = -23, //The received version number is too high
@@ -172,7 +194,9 @@ enum class ElasticFrameMessages : int16_t {
     efpSignalDropped            = 8,  //EFPSignal did drop the content since it's not declared
     contentAlreadyListed        = 9,  //The content is already listed.
     contentNotListed            = 10, //The content is not listed.
-    deleteContentFail           = 11  //Failed finding the content to be deleted
+    deleteContentFail           = 11, //Failed finding the content to be deleted
+    fecFragmentDropped          = 12, //A FEC fragment arrived for a superframe not being assembled and was discarded
+    fragmentNotCached           = 13  //A NACK requested fragment(s) no longer (or never) present in the retransmit cache
 };
 
 //Optional context passed to the callbacks
@@ -183,6 +207,75 @@ public:
     uint64_t mValue = 0;                // Generic 64-bit variable
 };
 
+//---------------------------------------------------------------------------------------------------------------------
+//
+//
+// ElasticFrameProtocolMemoryBudget
+//
+//
+//---------------------------------------------------------------------------------------------------------------------
+
+/**
+ * \class ElasticFrameProtocolMemoryBudget
+ *
+ * \brief A memory budget shared by one or more ElasticFrameProtocolReceiver instances (see setMemoryBudget)
+ *
+ * Every superframe a receiver allocates is charged to the budget (to the receiver and to the source the superframe
+ * arrived on) until the superframe is destroyed. That includes superframes being assembled, superframes in the
+ * delivery queue and superframes held by the host.
+ * A receiver may always use its fair share (the budget divided by the number of attached receivers) as long as the
+ * budget is not exhausted. When more than 3/4 of the budget is used a receiver above its fair share is refused more
+ * memory, so one stalled or flooded receiver can't starve the others.
+ */
+class ElasticFrameProtocolMemoryBudget {
+public:
+    // The memory charged to a receiver
+    struct Usage {
+        size_t mBytes = 0;                      // Bytes currently charged
+        size_t mPeakBytes = 0;                  // The highest number of bytes charged
+        uint64_t mRefused = 0;                  // Number of refused allocations
+        std::array<size_t, 256> mSourceBytes{}; // Bytes currently charged per source (see receiveFragment lFromSource)
+    };
+
+    ///Constructor
+    explicit ElasticFrameProtocolMemoryBudget(size_t lMaxBytes);
+
+    ElasticFrameProtocolMemoryBudget(const ElasticFrameProtocolMemoryBudget &) = delete;
+
+    ElasticFrameProtocolMemoryBudget &operator=(const ElasticFrameProtocolMemoryBudget &) = delete;
+
+    ///Returns the size of the budget
+    size_t getMaxBytes() const { return mMaxBytes; }
+
+    ///Returns the bytes charged by all receivers
+    size_t getUsedBytes();
+
+    ///Returns the number of attached receivers
+    size_t getNumberOfReceivers();
+
+private:
+    friend class ElasticFrameProtocolReceiver;
+
+    struct ReceiverEntry {
+        Usage mUsage;
+        bool mAttached = true;
+    };
+
+    uint64_t attach();
+    void detach(uint64_t lReceiverId);
+    bool reserve(uint64_t lReceiverId, uint8_t lSource, size_t lBytes);
+    void release(uint64_t lReceiverId, uint8_t lSource, size_t lBytes);
+    Usage getUsage(uint64_t lReceiverId);
+    size_t getReceiverBytes(uint64_t lReceiverId);
+
+    std::mutex mBudgetMtx;
+    const size_t mMaxBytes;
+    size_t mUsedBytes = 0;
+    size_t mAttachedReceivers = 0;
+    uint64_t mNextReceiverId = 1;
+    std::map<uint64_t, ReceiverEntry> mReceivers;
+};
+
 //---------------------------------------------------------------------------------------------------------------------
 //
 //
@@ -257,6 +350,38 @@ public:
                        const std::function<void(const std::vector<uint8_t> &rSubPacket,
                                                 uint8_t streamID)>& rSendFunction = nullptr);
 
+    // An embedded data section. See packAndSend with embedded data
+    struct EmbeddedSection {
+        const uint8_t *pData = nullptr;
+        size_t mSize = 0;
+        ElasticEmbeddedFrameContent mContent = ElasticEmbeddedFrameContent::illegal; // The last flag is set by EFP
+    };
+
+    /**
+    * Converts embedded data and the payload to EFP packets/fragments
+    * The embedded data headers are generated and the sections and the payload are copied directly to the fragments.
+    * The INLINE_PAYLOAD flag is set if there are any sections. The receiver gets the same superframe as when the
+    * sections are added to the payload using addEmbeddedData.
+    *
+    * @param pEmbeddedData the embedded data sections in the order they are placed in the superframe
+    * @param lNumberOfSections number of sections (may be 0)
+    * @param pPayload pointer to the payload
+    * @param lPayloadSize size of the payload
+    * @param lDataContent ElasticFrameContent::x where x is the type of data to be sent.
+    * @param lPts the PTS value of the content
+    * @param lDts the DTS value of the content
+    * @param lCode if MSB (uint8_t) of ElasticFrameContent is set. Then code is used to further declare the content
+    * @param lStreamID The EFP-stream ID the data is associated with.
+    * @param lFlags signal what flags are used
+    * @param rSendFunction optional send function/lambda. Overrides the callback sendCallback
+    * @return ElasticFrameMessages
+    */
+    ElasticFrameMessages
+    packAndSend(const EmbeddedSection *pEmbeddedData, size_t lNumberOfSections, const uint8_t *pPayload,
+                size_t lPayloadSize, ElasticFrameContent lDataContent, uint64_t lPts, uint64_t lDts, uint32_t lCode,
+                uint8_t lStreamID, uint8_t lFlags,
+                const std::function<void(const std::vector<uint8_t> &rSubPacket, uint8_t streamID)>& rSendFunction = nullptr);
+
     /**
     * Send fragment callback
     *
@@ -294,6 +419,137 @@ public:
                                                 bool lIsLast = false);
     //Help methods ----------- END ----------
 
+    /**
+    * Start a superframe where the size is not known in advance (streaming)
+    * Add data using appendData. Fragments are sent as soon as they are filled. Close the superframe with endSuperFrame.
+    * Only one streamed superframe may be open at a time. packAndSend may be used while a streamed superframe is open.
+    *
+    * @param lDataContent ElasticFrameContent::x where x is the type of data to be sent.
+    * @param lStreamID The EFP-stream ID the data is associated with.
+    * @param lFlags signal what flags are used
+    * @return ElasticFrameMessages
+    */
+    ElasticFrameMessages beginSuperFrame(ElasticFrameContent lDataContent, uint8_t lStreamID, uint8_t lFlags);
+
+    /**
+    * Add data to the superframe started by beginSuperFrame
+    *
+    * @param pData pointer to the data
+    * @param lSize size of the data
+    * @param rSendFunction optional send function/lambda. Overrides the callback 'sendCallback'
+    * @return ElasticFrameMessages
+    */
+    ElasticFrameMessages appendData(const uint8_t *pData, size_t lSize,
+                                    const std::function<void(const std::vector<uint8_t> &rSubPacket,
+                                                             uint8_t streamID)>& rSendFunction = nullptr);
+
+    /**
+    * Send the remaining data and close the superframe started by beginSuperFrame
+    *
+    * @param lPts the PTS value of the content
+    * @param lDts the DTS value of the content
+    * @param lCode if MSB (uint8_t) of ElasticFrameContent is set. Then code is used to further declare the content
+    * @param rSendFunction optional send function/lambda. Overrides the callback 'sendCallback'
+    * @return ElasticFrameMessages
+    */
+    ElasticFrameMessages endSuperFrame(uint64_t lPts, uint64_t lDts, uint32_t lCode,
+                                       const std::function<void(const std::vector<uint8_t> &rSubPacket,
+                                                                uint8_t streamID)>& rSendFunction = nullptr);
+
+    /**
+    * Enable forward error correction for a EFP-stream
+    * A FEC fragment (XOR parity) is sent after every lGroupSize type1 fragments of a superframe.
+    * The receiver can rebuild one lost type1 fragment per group without waiting for the bucket timeout.
+    *
+    * @param lStreamID The EFP-stream ID to protect
+    * @param lGroupSize Number of type1 fragments protected by one FEC fragment. 0 == FEC disabled (default)
+    * @return ElasticFrameMessages
+    */
+    ElasticFrameMessages setFECGroupSize(uint8_t lStreamID, uint16_t lGroupSize);
+
+    /**
+    * Keep the last lNumberOfFragments sent fragments so they can be re-sent when a NACK is received
+    *
+    * @param lNumberOfFragments size of the retransmit cache. 0 == no cache (default)
+    * @return ElasticFrameMessages
+    */
+    ElasticFrameMessages setRetransmitCacheSize(size_t lNumberOfFragments);
+
+    /**
+    * Re-send the fragments listed in a NACK generated by ElasticFrameProtocolReceiver::nackCallback
+    * The fragments are sent using the 'sendCallback' or rSendFunction if provided
+    *
+    * @param pNack pointer to the NACK
+    * @param lNackSize size of the NACK
+    * @param rSendFunction optional send function/lambda. Overrides the callback 'sendCallback'
+    * @return ElasticFrameMessages
+    */
+    ElasticFrameMessages receiveNackFromPtr(const uint8_t *pNack, size_t lNackSize,
+                                            const std::function<void(const std::vector<uint8_t> &rSubPacket,
+                                                                     uint8_t streamID)>& rSendFunction = nullptr);
+
+    /**
+    * Re-send the fragments listed in a NACK generated by ElasticFrameProtocolReceiver::nackCallback
+    *
+    * @param rNack the NACK
+    * @param rSendFunction optional send function/lambda. Overrides the callback 'sendCallback'
+    * @return ElasticFrameMessages
+    */
+    ElasticFrameMessages receiveNack(const std::vector<uint8_t> &rNack,
+                                     const std::function<void(const std::vector<uint8_t> &rSubPacket,
+                                                              uint8_t streamID)>& rSendFunction = nullptr);
+
+#ifdef EFP_COROUTINES
+    /**
+    * Awaitable returned by send. Suspends the coroutine while there is backpressure then packs and sends the data.
+    */
+    class SendAwaitable {
+    public:
+        SendAwaitable(ElasticFrameProtocolSender *pSender, const uint8_t *pPacket, size_t lPacketSize, ElasticFrameContent lDataContent,
+                      uint64_t lPts, uint64_t lDts, uint32_t lCode, uint8_t lStreamID, uint8_t lFlags) :
+                pSender(pSender), pPacket(pPacket), mPacketSize(lPacketSize), mDataContent(lDataContent), mPts(lPts), mDts(lDts),
+                mCode(lCode), mStreamID(lStreamID), mFlags(lFlags) {}
+        bool await_ready();
+        bool await_suspend(std::coroutine_handle<> lHandle);
+        ElasticFrameMessages await_resume();
+    private:
+        ElasticFrameProtocolSender *pSender;
+        const uint8_t *pPacket;
+        size_t mPacketSize;
+        ElasticFrameContent mDataContent;
+        uint64_t mPts;
+        uint64_t mDts;
+        uint32_t mCode;
+        uint8_t mStreamID;
+        uint8_t mFlags;
+    };
+
+    /**
+    * co_await send(...) packs and sends the data when there is no backpressure (see setBackpressure).
+    * The parameters are the same as packAndSend. The data must be valid until the co_await returns.
+    *
+    * @return awaitable returning ElasticFrameMessages
+    */
+    SendAwaitable send(const std::vector<uint8_t> &rPacket, ElasticFrameContent lDataContent, uint64_t lPts, uint64_t lDts,
+                       uint32_t lCode, uint8_t lStreamID, uint8_t lFlags) {
+        return SendAwaitable(this, rPacket.data(), rPacket.size(), lDataContent, lPts, lDts, lCode, lStreamID, lFlags);
+    }
+
+    /**
+    * Signal transmit backpressure. While set, coroutines awaiting send are suspended.
+    * When cleared the suspended coroutines are resumed in order.
+    *
+    * @param lBackpressure true if the transport can't take more data
+    */
+    void setBackpressure(bool lBackpressure);
+
+    /**
+    * Executor hook. Suspended coroutines are passed here to be resumed. If not set they are resumed directly
+    * by the thread calling setBackpressure(false).
+    */
+    std::function<void(std::coroutine_handle<> lHandle)> coroutineExecutor = nullptr;
+#endif
+
     ///Delete copy and move constructors and assign operators
     ElasticFrameProtocolSender(ElasticFrameProtocolSender const &) = delete;              // Copy construct
     ElasticFrameProtocolSender(ElasticFrameProtocolSender &&) = delete;                   // Move construct
@@ -313,14 +569,61 @@ private:
     //Private methods ----- START ------
     // Used by the C - API
     void sendData(const std::vector<uint8_t> &rSubPacket, uint8_t lStreamID, ElasticFrameProtocolContext* pCTX);
+
+    // Send a fragment using rSendFunction if provided else the sendCallback
+    void sendFragment(const std::vector<uint8_t> &rFragment, uint8_t lStreamID,
+                      const std::function<void(const std::vector<uint8_t> &rSubPacket, uint8_t streamID)>& rSendFunction);
+
+    // Fragment and send the superframe described by mGatherSegments
+    ElasticFrameMessages packAndSendSegments(size_t lPacketSize, ElasticFrameContent lDataContent, uint64_t lPts,
+                                             uint64_t lDts, uint32_t lCode, uint8_t lStreamID, uint8_t lFlags,
+                                             const std::function<void(const std::vector<uint8_t> &rSubPacket, uint8_t streamID)>& rSendFunction);
+
+    // Copy the next part of the superframe from mGatherSegments
+    void gatherCopy(uint8_t *pDst, size_t lSize);
+
+    // Save a copy of a sent fragment in the retransmit cache
+    void cacheFragment(const std::vector<uint8_t> &rFragment, uint16_t lSuperFrameNo, uint16_t lFragmentNo, uint8_t lStreamID);
     //Private methods ----- END ------
 
+    // A sent fragment saved for retransmission
+    struct CachedFragment {
+        uint32_t mKey = UINT32_MAX; // (super frame number << 16) | fragment number
+        uint8_t mStreamID = 0;
+        std::vector<uint8_t> mData;
+    };
+
     // Internal lists and variables ----- START ------
     std::mutex mSendMtx; //Mutex protecting the send methods
     uint32_t mCurrentMTU = 0; //current MTU used by the sender
     uint16_t mSuperFrameNoGenerator = 0;
     std::vector<uint8_t> mSendBufferFixed; //Fragment buffer the size of MTU given
     std::vector<uint8_t> mSendBufferEnd; //Resized fragment buffer the size of the end fragment
+    std::vector<uint8_t> mSendBufferFEC; //Fragment buffer where the FEC parity is accumulated
+    uint16_t mFECGroupSize[UINT8_MAX + 1] = {0}; //FEC group size per EFP-stream (0 == no FEC)
+    std::vector<CachedFragment> mRetransmitCache; //Ring of the last sent fragments
+    size_t mRetransmitCachePosition = 0; //Next position to write in the ring
+    std::map<uint32_t, size_t> mRetransmitCacheIndex; //Key -> position in mRetransmitCache
+    std::vector<std::pair<const uint8_t *, size_t>> mGatherSegments; //The superframe being sent as (pointer, size) segments
+    std::vector<ElasticFrameContentNamespace::ElasticEmbeddedHeader> mGatherHeaders; //Embedded data headers referenced by mGatherSegments
+    size_t mGatherSegment = 0; //Segment to copy from next
+    size_t mGatherOffset = 0; //Offset in that segment
+
+    // The streamed superframe (beginSuperFrame/appendData/endSuperFrame)
+    bool mStreamingActive = false;
+    ElasticFrameContent mStreamingDataContent = ElasticFrameContent::unknown;
+    uint8_t mStreamingStreamID = 0;
+    uint8_t mStreamingFlags = NO_FLAGS;
+    uint16_t mStreamingSuperFrameNo = 0;
+    uint16_t mStreamingFragmentNo = 0; //Number of type7 fragments sent
+    size_t mStreamingBufferFill = 0; //Bytes in mStreamingBuffer not yet sent
+    std::vector<uint8_t> mStreamingBuffer; //type7 fragment being filled
+
+#ifdef EFP_COROUTINES
+    std::mutex mCoroutineMtx; //Mutex protecting the backpressure state
+    bool mBackpressure = false;
+    std::deque<std::coroutine_handle<>> mSendWaiters; //Coroutines waiting for the backpressure to clear
+#endif
 
     // Internal lists and variables ----- END -----
 };
@@ -365,6 +668,8 @@ public:
         uint8_t mStreamID = 0;           // A streamID used for stream separation of same content type (if you got more than one H264 streams for example)
         uint8_t mSource = 0;             // A transparent value 'passed by' the receivedFragment method to separate multiple parallel EFP streams
         uint8_t mFlags = NO_FLAGS;       // Flags used by the frame
+        std::vector<std::pair<size_t, size_t>> mMissingRanges; // If broken. The missing data as (byte offset, size) ranges
+        bool mView = false;              // pFrameData points into the received fragment and is only valid in the callback (see setSingleFragmentView)
 
         SuperFrame(const SuperFrame &) = delete;
 
@@ -382,22 +687,119 @@ public:
             if (pFrameData && !lResult) mFrameSize = lMemAllocSize;
         }
 
+        // A view of data owned by someone else. The data is not freed
+        SuperFrame(uint8_t *pData, size_t lSize) : mFrameSize(lSize), pFrameData(pData), mView(true) {
+        }
+
         virtual ~SuperFrame() {
+            //Return the memory to the budget if charged
+            if (mBudget) {
+                mBudget->release(mBudgetReceiverId, mBudgetSource, mBudgetBytes);
+            }
             //Free if allocated
-            if (pFrameData)
+            if (!pFrameData || mView) {
+                return;
+            }
+#ifdef __linux__
+            if (mMappedSize) {
+                munmap(pFrameData, mMappedSize);
+                return;
+            }
+#endif
 #ifdef _WIN64
-                _aligned_free(pFrameData);
+            _aligned_free(pFrameData);
 #else
-                free(pFrameData);
+            free(pFrameData);
 #endif
         }
+
+    private:
+        friend class ElasticFrameProtocolReceiver;
+        // Memory mapped by the receiver (huge pages). Unmapped when destroyed
+        SuperFrame(uint8_t *pData, size_t lSize, size_t lMappedSize) : mFrameSize(lSize), pFrameData(pData),
+                                                                       mMappedSize(lMappedSize) {
+        }
+
+        size_t mMappedSize = 0; // Size of the mapping if mapped
+        std::shared_ptr<ElasticFrameProtocolMemoryBudget> mBudget = nullptr; // The budget charged for this superframe
+        uint64_t mBudgetReceiverId = 0;
+        uint8_t mBudgetSource = 0;
+        size_t mBudgetBytes = 0;
     };
 
     using pFramePtr = std::unique_ptr<SuperFrame>;
 
+    // What to do when the delivery queue is full (see setDeliveryQueueLimit)
+    enum class EFPQueuePolicy : uint8_t {
+        BLOCK = 0,        // The receiver worker waits for the consumer (no superframes are lost)
+        DROP_OLDEST = 1,  // Drop the oldest superframe in the queue
+        DROP_NEWEST = 2,  // Drop the superframe to be queued
+        LATEST_ONLY = 3   // Keep only the latest superframe per EFP-stream in the queue (the limit is not used)
+    };
+
+    // What to do when a fragment maps to a bucket used by another superframe (see setEvictionPolicy)
+    enum class EFPEvictionPolicy : uint8_t {
+        REJECT = 0,         // Drop the new fragment (bufferOutOfResources)
+        DELIVER_BROKEN = 1, // Deliver the old superframe now (most likely broken) and reuse the bucket
+        DROP = 2            // Drop the old superframe and reuse the bucket
+    };
+
+    // Counters for the eviction policies
+    struct EvictionCounters {
+        uint64_t mRejected = 0;  // New fragments dropped since the bucket was not evicted
+        uint64_t mDelivered = 0; // Superframes delivered early by DELIVER_BROKEN
+        uint64_t mDropped = 0;   // Superframes dropped by DROP
+        uint64_t mBudgetDropped = 0; // Superframes dropped to return memory to the memory budget
+        uint64_t mBudgetRefused = 0; // New superframes dropped since the memory budget refused memory
+    };
+
+    // Counters for the delivery queue policies
+    struct DeliveryQueueCounters {
+        uint64_t mDroppedOldest = 0;    // Superframes dropped by DROP_OLDEST
+        uint64_t mDroppedNewest = 0;    // Superframes dropped by DROP_NEWEST
+        uint64_t mReplacedByLatest = 0; // Superframes replaced by a newer superframe of the same stream by LATEST_ONLY
+        uint64_t mBlocked = 0;          // Number of times the receiver worker waited for the consumer by BLOCK
+    };
+
+    // Counters for the playout mode (see setPlayoutMode)
+    struct PlayoutCounters {
+        uint64_t mDelivered = 0; // Superframes delivered by the playout
+        uint64_t mLate = 0;      // Superframes dropped since they arrived after their time was due
+        uint64_t mEarly = 0;     // Superframes arriving earlier than the recovered clock expected (the clock was adjusted)
+        int64_t mMaxLateUs = 0;  // Most late superframe
+        int64_t mMaxEarlyUs = 0; // Most early superframe
+    };
+
+    // Values learned by the adaptive timeout (see setAdaptiveTimeout)
+    struct LearnedTimeout {
+        uint8_t mSource = 0;           // The EFP source ID
+        uint8_t mStreamID = 0;         // The EFP-stream ID
+        uint64_t mSamples = 0;         // Number of gaps between fragments observed
+        int64_t mGapPercentileUs = 0;  // The gap at the target percentile
+        uint32_t mReorderDepth = 0;    // How many fragments out of order fragments may arrive
+        uint32_t mTimeoutms = 0;       // The timeout used for the buckets
+    };
+
+    // Scheduling policy of the EFP threads (see setThreadConfig)
+    enum class EFPThreadPolicy : uint8_t {
+        OTHER = 0, // The default time sharing scheduler. mNice is used
+        FIFO = 1,  // SCHED_FIFO real-time. mPriority is used
+        RR = 2     // SCHED_RR real-time. mPriority is used
+    };
+
+    // Configuration of the threads owned by the receiver (see setThreadConfig)
+    struct ThreadConfig {
+        std::string mName = "efp";   // Threads are named mName-rx (worker), mName-dlv (delivery) and mName-lnX (stream lanes)
+        std::vector<int> mCpus;      // CPUs the threads are pinned to. Empty == the NUMA node CPUs if set else not pinned
+        EFPThreadPolicy mPolicy = EFPThreadPolicy::OTHER;
+        int mPriority = 0;           // FIFO and RR priority (1-99)
+        int mNice = 0;               // OTHER nice value (-20 to 19)
+    };
+
     enum class EFPReceiverMode : uint32_t {
         THREADED = 1,
-        RUN_TO_COMPLETION = 2
+        RUN_TO_COMPLETION = 2,
+        PULL = 3 // Like THREADED but there is no delivery thread. Superframes are fetched using tryPopFrame/popFrames
     };
 
     ///Constructor (defaults to 100ms timeout of not 100% assembled super frames)
@@ -430,6 +832,227 @@ public:
     */
     ElasticFrameMessages receiveFragmentFromPtr(const uint8_t *pSubPacket, size_t lPacketSize, uint8_t lFromSource, const std::function<void(pFramePtr &rPacket, ElasticFrameProtocolContext* pCTX)>& rReceiveFunction = nullptr);
 
+    /**
+    * Deliver superframes that are complete or timed out (and send pending NACKs) without receiving a new fragment.
+    * Only used in run to completion mode, in threaded mode the worker thread does this.
+    * Call this method when the time returned by nextDeadline has passed.
+    *
+    * @param rReceiveFunction optional lambda may only be used in run to completion mode
+    * @return ElasticFrameMessages notImplemented if not in run to completion mode
+    */
+    ElasticFrameMessages processTimeouts(const std::function<void(pFramePtr &rPacket, ElasticFrameProtocolContext* pCTX)>& rReceiveFunction = nullptr);
+
+    /**
+    * The time until processTimeouts needs to be called. Only used in run to completion mode.
+    *
+    * @return microseconds until the next deadline, 0 if processTimeouts should be called now and -1 if nothing is pending
+    */
+    int64_t nextDeadline();
+
+    /**
+    * Fetch the next superframe. Only used in pull mode.
+    *
+    * @param rFrame the superframe (if any)
+    * @return true if a superframe was fetched
+    */
+    bool tryPopFrame(pFramePtr &rFrame);
+
+    /**
+    * Fetch up to lMaxFrames superframes. Only used in pull mode.
+    *
+    * @param rFrames the superframes are appended to this vector
+    * @param lMaxFrames the maximum number of superframes to fetch
+    * @return the number of superframes fetched
+    */
+    size_t popFrames(std::vector<pFramePtr> &rFrames, size_t lMaxFrames);
+
+    /**
+    * A file descriptor (eventfd) readable as long as there are superframes to fetch. Only used in pull mode (Linux only).
+    * The descriptor is owned by the receiver. Add it to epoll/poll and don't read from it.
+    *
+    * @return the file descriptor or -1 if not available
+    */
+    int getReadinessFd() { return mReadinessFd; }
+
+    /**
+    * Limit the number of superframes in the delivery queue (threaded and pull mode)
+    * The counters are reset.
+    *
+    * @param lMaxFrames maximum number of superframes in the queue. 0 == no limit (default)
+    * @param lPolicy what to do when the queue is full
+    * @return ElasticFrameMessages
+    */
+    ElasticFrameMessages setDeliveryQueueLimit(size_t lMaxFrames, EFPQueuePolicy lPolicy);
+
+    /**
+    * Get the delivery queue counters
+    *
+    * @return the counters
+    */
+    DeliveryQueueCounters getDeliveryQueueCounters();
+
+    /**
+    * Deliver superframes with higher priority (PRIORITY_P0..P3 flags) first (threaded and pull mode)
+    * Superframes ready for delivery are taken from the delivery queue highest priority first. The superframes of a
+    * EFP-stream are always delivered in order, a superframe waiting behind an older superframe of the same stream waits.
+    *
+    * @param lEnable true to enable. Default is false (delivery order).
+    * @return ElasticFrameMessages
+    */
+    ElasticFrameMessages setPriorityDelivery(bool lEnable);
+
+    /**
+    * Playout mode (threaded mode only). Superframes are delivered when their time stamp is due instead of when they are
+    * assembled, at a fixed latency. The time stamps of each EFP-stream are mapped to the local clock using the
+    * superframe with the shortest transfer time (and the drift of the sender clock).
+    * The DTS is used as time stamp (equals the PTS if not set), so superframes are delivered in decoding order.
+    * Superframes arriving after their time is due are dropped and counted as late. Superframes without time stamp
+    * are delivered at once. EFP-streams with their own lane (setStreamCallback) are not affected, nor is the
+    * delivery queue limit.
+    *
+    * @param lEnable true to enable. Default is false. When disabled superframes waiting are moved to the delivery queue
+    * @param lLatencyms the time from when a superframe is due until it's delivered
+    * @param lTimebaseHz the time base of the PTS/DTS (ticks per second)
+    * @return ElasticFrameMessages
+    */
+    ElasticFrameMessages setPlayoutMode(bool lEnable, uint32_t lLatencyms = 100, uint32_t lTimebaseHz = 90000);
+
+    /**
+    * Get the playout counters
+    *
+    * @return the counters
+    */
+    PlayoutCounters getPlayoutCounters();
+
+    /**
+    * Set the superframe size from where the received data is copied using non-temporal (streaming) stores
+    * The data of large superframes is written once and then handed to the application. Streaming stores keep it from
+    * evicting everything else from the CPU caches. Used on x86 (SSE2/AVX2/AVX-512 selected at runtime), else ignored.
+    *
+    * @param lBytes superframe size in bytes. SIZE_MAX disables. Default is EFP_NON_TEMPORAL_THRESHOLD
+    */
+    void setNonTemporalCopyThreshold(size_t lBytes);
+
+    /**
+    * Use huge pages for the bucket list and large superframes (Linux only)
+    * Superframes are written in fragment sized chunks all over the memory and the bucket list is large, using huge
+    * pages lowers the TLB misses. Memory is mapped using MAP_HUGETLB (the pool in /proc/sys/vm/nr_hugepages) and if
+    * the pool is empty transparent huge pages are requested using madvise. The bucket list is moved when enabled.
+    *
+    * @param lEnable true to enable. Default is false
+    * @param lThreshold superframe size in bytes from where huge pages (and the NUMA node, see setNumaNode) are used
+    * @param lPreFault fault in the memory when it's mapped instead of when the first fragment data is copied
+    * @return ElasticFrameMessages
+    */
+    ElasticFrameMessages setHugePages(bool lEnable, size_t lThreshold = EFP_HUGE_PAGE_THRESHOLD, bool lPreFault = true);
+
+    /**
+    * Place the receiver on a NUMA node (Linux only)
+    * The EFP threads (worker, delivery and stream lanes) are pinned to the CPUs of the node. The bucket list and
+    * superframes from the threshold set by setHugePages (default EFP_HUGE_PAGE_THRESHOLD) are allocated on the node.
+    * Superframes are written by the thread calling receiveFragment, place that thread on the same node.
+    *
+    * @param lNode the NUMA node. -1 removes the placement
+    * @return ElasticFrameMessages
+    */
+    ElasticFrameMessages setNumaNode(int32_t lNode);
+
+    /**
+    * Configure the threads owned by the receiver (Linux only)
+    * Names, pins and schedules the worker, delivery and stream lane threads. Running threads are changed and threads
+    * started later use the configuration. Pin the threads to isolated cores and use FIFO/RR to keep the 10ms tick
+    * of the worker when the CPUs are shared. Real-time policies and negative nice values need CAP_SYS_NICE.
+    * The CPUs set here are used instead of the NUMA node CPUs (see setNumaNode).
+    *
+    * @param rConfig the thread configuration
+    * @return ElasticFrameMessages threadConfigFailed if the priority is out of range (the configuration is not used) or
+    * a thread could not be configured (the configuration is kept)
+    */
+    ElasticFrameMessages setThreadConfig(const ThreadConfig &rConfig);
+
+    /**
+    * Deliver superframes carried by a single fragment as a view of the received fragment (run to completion mode only)
+    * Superframes in a single fragment are always delivered when received (in HOL mode if it's the next superframe
+    * expected). In view mode no memory is allocated and no data copied, pFrameData points into the buffer passed to
+    * receiveFragment and mView is set. The data is only valid in the callback and must not be modified.
+    *
+    * @param lEnable true to enable. Default is false
+    * @return ElasticFrameMessages
+    */
+    ElasticFrameMessages setSingleFragmentView(bool lEnable);
+
+    /**
+    * Set what to do when a fragment maps to a bucket still used by an other superframe (the circular buffer wrapped).
+    * A superframe with a higher priority (PRIORITY_P0..P3 flags) than the new fragment is never evicted, nor is a
+    * superframe newer than the fragment.
+    *
+    * @param lPolicy the policy. Default is EFPEvictionPolicy::REJECT
+    * @return ElasticFrameMessages
+    */
+    ElasticFrameMessages setEvictionPolicy(EFPEvictionPolicy lPolicy);
+
+    /**
+    * Get the eviction counters
+    *
+    * @return the counters
+    */
+    EvictionCounters getEvictionCounters();
+
+    /**
+    * Charge all superframes allocated by this receiver to a memory budget shared with other receivers.
+    * When the budget refuses memory the oldest superframes being assembled are dropped, also if the eviction policy
+    * is EFPEvictionPolicy::DELIVER_BROKEN (not if EFPEvictionPolicy::REJECT). Superframes newer than the new superframe
+    * or with higher priority are kept. If that does not help the fragment is dropped and memoryBudgetExceeded is
+    * returned by receiveFragment. See EvictionCounters mBudgetDropped and mBudgetRefused.
+    *
+    * @param pBudget the budget or nullptr to stop using a budget. Superframes already allocated stay charged until destroyed.
+    * @return ElasticFrameMessages
+    */
+    ElasticFrameMessages setMemoryBudget(std::shared_ptr<ElasticFrameProtocolMemoryBudget> pBudget);
+
+    /**
+    * Get the memory charged to the budget by this receiver
+    *
+    * @return the usage. All zero if no budget is used
+    */
+    ElasticFrameProtocolMemoryBudget::Usage getMemoryUsage();
+
+#ifdef EFP_COROUTINES
+    /**
+    * Awaitable returned by nextFrame.
+    */
+    class FrameAwaitable {
+    public:
+        explicit FrameAwaitable(ElasticFrameProtocolReceiver *pReceiver) : pReceiver(pReceiver) {}
+        bool await_ready();
+        bool await_suspend(std::coroutine_handle<> lHandle);
+        pFramePtr await_resume() { return std::move(mFrame); }
+    private:
+        friend class ElasticFrameProtocolReceiver;
+        ElasticFrameProtocolReceiver *pReceiver;
+        pFramePtr mFrame = nullptr;
+    };
+
+    /**
+    * co_await nextFrame() returns the next superframe. Only used in pull mode and by one coroutine at a time.
+    * The coroutine is resumed using the coroutineExecutor if set. If not set it's resumed directly by the thread
+    * handing it the superframe, the receiver worker thread or the thread calling receiveFragment (after the receiver
+    * is unlocked, so the coroutine may call the receiver).
+    * nullptr is returned if the receiver is not in pull mode or is stopped.
+    * Pull mode runs a worker thread per receiver, so every receiver awaited this way costs an OS thread. Run to
+    * completion mode is not supported, many receivers driven by a few threads should use run to completion mode and
+    * the receive callback instead.
+    *
+    * @return awaitable returning pFramePtr
+    */
+    FrameAwaitable nextFrame() { return FrameAwaitable(this); }
+
+    /**
+    * Executor hook. Suspended coroutines are passed here to be resumed.
+    */
+    std::function<void(std::coroutine_handle<> lHandle)> coroutineExecutor = nullptr;
+#endif
+
     /**
     * When the EFP receiver is done assembling a super frame or times out data this callback is used.
     *
@@ -444,10 +1067,131 @@ public:
     * -> mCcode if MSB (uint8_t) of ElasticFrameContent is set. Then code is used to further declare the content
     * -> mStreamID The EFP-stream ID the data is associated with.
     * -> mFlags signal what flags are used
+    * -> mMissingRanges if mBroken, the (byte offset, size) ranges of the data missing in the frame
     * @param pCTX Optional pointer to ElasticFrameProtocolContext may be nullptr
     */
     std::function<void(pFramePtr &rPacket, ElasticFrameProtocolContext* pCTX)> receiveCallback = nullptr;
 
+    /**
+    * If set, used instead of receiveCallback. All superframes ready for delivery at that moment are delivered in one call
+    * (in delivery order). The superframes are owned by the vector and released when the callback returns unless moved out.
+    * Used in threaded and run to completion mode (not if a rReceiveFunction is given to receiveFragment).
+    *
+    * @param rPackets the superframes
+    * @param pCTX Optional pointer to ElasticFrameProtocolContext may be nullptr
+    */
+    std::function<void(std::vector<pFramePtr> &rPackets, ElasticFrameProtocolContext* pCTX)> receiveBatchCallback = nullptr;
+
+    /**
+    * Deliver the superframes of a EFP-stream to its own callback using a separate delivery thread (lane).
+    * A slow consumer of one stream will then not stall the delivery of other streams.
+    * Used in threaded and pull mode. Superframes of the stream are no longer delivered by receiveCallback/receiveBatchCallback.
+    *
+    * @param lStreamID The EFP-stream ID
+    * @param rCallback the callback. nullptr removes the lane (superframes waiting in the lane are dropped)
+    * @return ElasticFrameMessages
+    */
+    ElasticFrameMessages setStreamCallback(uint8_t lStreamID, const std::function<void(pFramePtr &rPacket, ElasticFrameProtocolContext* pCTX)>& rCallback);
+
+    /**
+    * Cut-through callback. If set, the receiver delivers the superframe progressively as the contiguous prefix
+    * of the superframe grows. Each call covers the bytes [lOffset, lOffset + lSize) of the superframe.
+    * The superframe is then delivered as usual by the receiveCallback carrying PTS, DTS, code and the complete data.
+    * The callback is called on the thread calling receiveFragment and pData is only valid during the callback.
+    * Don't call the receiver from within the callback.
+    *
+    * @param pData pointer to the chunk
+    * @param lOffset position of the chunk in the superframe
+    * @param lSize size of the chunk
+    * @param lSuperFrameNo the superframe number the chunk belongs to
+    * @param lStreamID The EFP-stream ID the data is associated with
+    * @param lSource The EFP source ID
+    * @param pCTX Optional pointer to ElasticFrameProtocolContext may be nullptr
+    */
+    std::function<void(const uint8_t *pData, size_t lOffset, size_t lSize, uint16_t lSuperFrameNo, uint8_t lStreamID,
+                       uint8_t lSource, ElasticFrameProtocolContext* pCTX)> receiveChunkCallback = nullptr;
+
+    /**
+    * NACK callback. Called when fragments are missing in a superframe (see setNackMode)
+    * Transport the NACK back to the sender and pass it to ElasticFrameProtocolSender::receiveNack
+    * In THREADED mode the callback is called from the EFP worker thread. In RUN_TO_COMPLETION mode
+    * it's called from within receiveFragment and the NACK may not be looped back to this receiver on the same thread.
+    *
+    * @param rNack the NACK
+    * @param lSource The EFP source ID the superframe was received from
+    * @param pCTX Optional pointer to ElasticFrameProtocolContext may be nullptr
+    */
+    std::function<void(const std::vector<uint8_t> &rNack, uint8_t lSource, ElasticFrameProtocolContext* pCTX)> nackCallback = nullptr;
+
+    /**
+    * Discontinuity callback. Called when the superframe numbers of a source jump (see setDiscontinuityDetection)
+    * The callback is called by receiveFragment after the fragment is processed and the receiver is unlocked, the stale
+    * superframes may already be delivered. The receiver may be called from within the callback.
+    *
+    * @param lSource The EFP source ID
+    * @param lLastSuperFrameNo The superframe number before the jump
+    * @param lNewSuperFrameNo The superframe number after the jump
+    * @param pCTX Optional pointer to ElasticFrameProtocolContext may be nullptr
+    */
+    std::function<void(uint8_t lSource, uint16_t lLastSuperFrameNo, uint16_t lNewSuperFrameNo,
+                       ElasticFrameProtocolContext* pCTX)> discontinuityCallback = nullptr;
+
+    /**
+    * Detect discontinuities, a sender restarting or the superframe counter jumping.
+    * When the superframe number of a source jumps more than lThreshold (back or forth) the superframes of that source
+    * being assembled are delivered (broken if incomplete) or dropped, the delivery order continues after the last superframe (HOL mode
+    * expects the new superframe next) and the discontinuityCallback is called.
+    *
+    * @param lThreshold the largest jump that is not a discontinuity. 0 == disabled (default)
+    * @param lDeliverStaleBuckets true to deliver the superframes being assembled, false to drop them
+    * @return ElasticFrameMessages
+    */
+    ElasticFrameMessages setDiscontinuityDetection(uint16_t lThreshold, bool lDeliverStaleBuckets);
+
+    /**
+    * Enable NACK generation
+    *
+    * @param lNackDelayms time after the first fragment of a superframe before the first NACK may be sent
+    * @param lNackIntervalms minimum time between NACKs for the same superframe
+    * @param lMaxNacks maximum number of NACKs sent per superframe. 0 == NACK disabled (default)
+    * @return ElasticFrameMessages
+    */
+    ElasticFrameMessages setNackMode(uint32_t lNackDelayms, uint32_t lNackIntervalms, uint8_t lMaxNacks);
+
+    /**
+    * Enable adaptive bucket timeouts
+    * The gaps between the fragments of a superframe and how far fragments arrive out of order (reorder depth) are
+    * tracked per source and EFP-stream. Once learned the timeout of a bucket is
+    * 2 * (the gap at lPercentile) * (reorder depth + 1) limited to lFloorms..lCeilingms.
+    * Until enough fragments are observed the timeout passed to the constructor is used (also limited to lFloorms..lCeilingms).
+    *
+    * @param lEnable true to enable. Default is false (the timeout passed to the constructor is always used)
+    * @param lPercentile target percentile of the gaps 0.0 - 1.0
+    * @param lFloorms minimum timeout
+    * @param lCeilingms maximum timeout
+    * @return ElasticFrameMessages
+    */
+    ElasticFrameMessages setAdaptiveTimeout(bool lEnable, double lPercentile = 0.99, uint32_t lFloorms = 5, uint32_t lCeilingms = 1000);
+
+    /**
+    * Get the values learned by the adaptive timeout per source and EFP-stream
+    *
+    * @return the learned values
+    */
+    std::vector<LearnedTimeout> getLearnedTimeouts();
+
+    /**
+    * Set the max reorder distance. For networks where fragments are not reordered (or only a little).
+    * A superframe missing fragments is declared broken (delivered or skipped in HOL mode) as soon as fragments arrive
+    * that are more than lSuperFrames superframes or lFragments fragments after it, instead of waiting for the timeout.
+    * In HOL mode a superframe where all fragments are lost is skipped when a superframe more than lSuperFrames after it is received.
+    *
+    * @param lSuperFrames max distance in superframes. 0 == not used (default)
+    * @param lFragments max distance in fragments (received after the latest fragment of the superframe). 0 == not used (default)
+    * @return ElasticFrameMessages
+    */
+    ElasticFrameMessages setMaxReorderDistance(uint32_t lSuperFrames, uint32_t lFragments);
+
     /**
     * Recieve data callback (C-API version)
     *
@@ -517,6 +1261,25 @@ public:
     */
     static ElasticFrameMessages extractEmbeddedData(pFramePtr &rPacket, std::vector<std::vector<uint8_t>> *pEmbeddedDataList,
                                                     std::vector<uint8_t> *pDataContent, size_t *pPayloadDataPosition);
+
+    // An embedded data section. pData points into the superframe
+    struct EmbeddedData {
+        uint8_t mDataContent = ElasticEmbeddedFrameContent::illegal; // ElasticEmbeddedFrameContent without the last flag
+        const uint8_t *pData = nullptr;
+        size_t mSize = 0;
+        bool mLast = false;                                           // The payload follows this section
+    };
+
+    /**
+    * Read the embedded data section at a position in the superFrame without copying anything
+    * Start at position 0 and call again until mLast is set, the position is then the payload position.
+    *
+    * @param rPacket pointer to packet (superFrame)
+    * @param pPosition position of the section relative superFrame start. Moved to the next section (or the payload)
+    * @param pEmbeddedData the section read
+    * @return ElasticFrameMessages
+    */
+    static ElasticFrameMessages nextEmbeddedData(const pFramePtr &rPacket, size_t *pPosition, EmbeddedData *pEmbeddedData);
     //Help methods ----------- END ----------
 protected:
     std::shared_ptr<ElasticFrameProtocolContext> mCTX = nullptr;
@@ -526,6 +1289,38 @@ private:
     // a super frame. The bucket can also be delivered 'broken' if a time out is
     // triggered.
 
+    // FEC parity covering mGroupSize type1 fragments
+    struct FECParity {
+        uint16_t mGroupSize = 0;
+        std::vector<uint8_t> mData;
+    };
+
+    // A jump in the superframe numbers of a source to be reported by the discontinuityCallback
+    struct Discontinuity {
+        uint8_t mSource;
+        uint16_t mLastSuperFrameNo;
+        uint16_t mNewSuperFrameNo;
+    };
+
+    // A detached thread owned by the receiver. Set by the thread when started
+    struct EFPThread {
+        std::thread::native_handle_type mHandle{};
+        int64_t mTid = 0;  // Kernel thread ID. 0 == not started
+        std::string mRole; // Added to the thread name
+    };
+
+    // A per stream delivery queue and thread
+    struct DeliveryLane {
+        std::function<void(pFramePtr &rPacket, ElasticFrameProtocolContext* pCTX)> mCallback = nullptr;
+        std::deque<pFramePtr> mQueue;
+        std::mutex mMtx;
+        std::condition_variable mConditionVariable;
+        bool mReady = false;
+        std::atomic_bool mActive = {false};
+        std::atomic_bool mThreadActive = {false};
+        EFPThread mThread; // The lane thread (detached)
+    };
+
     //Bucket  ----- START ------
     class Bucket {
     public:
@@ -545,9 +1340,40 @@ private:
         uint8_t mFlags = NO_FLAGS; // Flags used
         std::bitset<UINT16_MAX> mHaveReceivedFragment; // Bit-mask representing the fragments received
         pFramePtr mBucketData = nullptr; //Pointer to the super frame data
+        std::map<uint16_t, FECParity> mFECParity; // FEC parity received but not yet used. Key is the first fragment in the group
+        int64_t mNextNackTime = 0; // Time when the next NACK may be sent
+        uint8_t mNackCounter = 0; // Number of NACKs sent for this bucket
+        uint32_t mContiguousFragments = 0; // Number of fragments from the start of the superframe passed to the receiveChunkCallback
+        size_t mBucketDataCapacity = 0; // Allocated size of mBucketData for streamed superframes (mOfFragmentNo == UINT16_MAX until the end is received)
+        int64_t mLastFragmentTime = 0; // Arrival time of the latest fragment
+        uint16_t mHighestFragmentNo = 0; // The highest fragment number received
+        uint64_t mLastFragmentSequence = 0; // Value of mFragmentSequence when the latest fragment was received
     };
     //Bucket ----- END ------
 
+    // Adaptive timeout state per source and EFP-stream
+    struct AdaptiveTimeout {
+        std::vector<int64_t> mGaps;       // The latest gaps between fragments (microseconds). Used as a ring buffer
+        size_t mNextGap = 0;              // Where to put the next gap in mGaps
+        uint64_t mSamples = 0;            // Number of gaps observed
+        uint32_t mReorderDepth = 0;       // Largest reorder depth of the previous window
+        uint32_t mWindowReorderDepth = 0; // Largest reorder depth of the current window
+        int64_t mGapPercentileUs = 0;     // The gap at the target percentile
+        int64_t mTimeoutUs = 0;           // The learned timeout. 0 until learned
+    };
+
+    // Clock recovery state per EFP-stream for the playout mode
+    struct PlayoutClock {
+        bool mLocked = false;                    // Has the clock seen a superframe?
+        int64_t mOffsetUs = 0;                   // Local time - time stamp at mOffsetTime
+        int64_t mOffsetTime = 0;                 // Local time when mOffsetUs was set
+        double mDrift = 0.0;                     // Drift of the offset (microseconds per microsecond)
+        int64_t mWindowStart = 0;                // Local time the current window started
+        int64_t mWindowMinOffset = 0;            // Smallest offset seen in the current window
+        int64_t mPreviousWindowMinOffset = 0;    // Smallest offset seen in the previous window
+        bool mHavePreviousWindow = false;
+    };
+
     //Stream list ----- START ------
     struct Stream {
         uint32_t mCode = UINT32_MAX;
@@ -572,14 +1398,132 @@ private:
     // Method unpacking Type3 fragments
     ElasticFrameMessages unpackType3(const uint8_t *pSubPacket, size_t lPacketSize, uint8_t lFromSource);
 
+    // Deliver the superframe in the bucket in run to completion mode
+    void deliverRunToCompletion(Bucket *pBucket, const std::function<void(pFramePtr &rPacket, ElasticFrameProtocolContext* pCTX)>& rReceiveFunction);
+
+    // Queue a superframe for delivery applying the queue policy. May block (EFPQueuePolicy::BLOCK) so mNetMtx and
+    // mSuperFrameMtx must NOT be held by the caller. Returns false if it would block and lMayBlock is false
+    bool pushSuperFrame(pFramePtr &rFrame, bool lMayBlock = true);
+
+    // Queue a superframe in the lane of the stream if it has one. mNetMtx must be held by the caller
+    bool pushToLane(pFramePtr &rFrame);
+
+    // Take the superframe from the bucket to be pushed by pushSuperFrames. mNetMtx must be held by the caller
+    void queueSuperFrame(Bucket *pBucket);
+
+    // Push the superframes taken from the buckets in order. mNetMtx must NOT be held by the caller
+    void pushSuperFrames(bool lMayBlock);
+
+    // The next superframe in the queue to deliver. mSuperFrameMtx must be held by the caller and the queue must not be empty
+    std::deque<pFramePtr>::iterator nextFrameToDeliver();
+
+    // Move up to lMaxFrames from the queue to rFrames. mSuperFrameMtx must be held by the caller
+    size_t popFramesLocked(std::vector<pFramePtr> &rFrames, size_t lMaxFrames);
+
+    // Put a superframe in the playout buffer or drop it if it's late. mSuperFrameMtx must be held
+    void schedulePlayout(pFramePtr &rFrame);
+
+    // Returns the offset (local time - time stamp) of a time stamp arriving now and updates the clock
+    int64_t recoverPlayoutClock(PlayoutClock &rClock, int64_t lTimestampUs, int64_t lTimeNow);
+
+    // Wait until the first superframe in the playout buffer is due and take all that are due
+    void waitForPlayout(std::unique_lock<std::mutex> &rLock, std::vector<pFramePtr> &rFrames);
+
+#ifdef EFP_COROUTINES
+    // Resume the coroutines given a superframe by pushSuperFrame. mReceiveMtx, mNetMtx and mSuperFrameMtx must NOT be held
+    void resumeCoroutines();
+#endif
+
+    // Allocate or move the bucket list. Mapped if huge pages or a NUMA node is used
+    void allocateBucketList();
+
+    // Destroy the bucket list
+    void freeBucketList();
+
+    // Start a detached EFP thread configured as set by setThreadConfig and setNumaNode
+    void startThread(EFPThread *pThread, const std::string &rRole, const std::function<void()> &rFunction);
+
+    // Apply the thread configuration to a EFP thread (mThreadConfigMtx must be held)
+    bool configureThread(const EFPThread &rThread);
+
+    // Apply the thread configuration to the running EFP threads (mThreadConfigMtx must be held)
+    bool configureThreads();
+
+    // The CPUs of the thread configuration else the NUMA node (mThreadConfigMtx must be held)
+    void updateThreadCpus();
+
+    // Copy fragment data to the superframe of a bucket
+    void copyToBucket(Bucket *pBucket, size_t lOffset, const uint8_t *pSrc, size_t lSize);
+
+    // Deliver a superframe carried by a single type2 fragment now
+    ElasticFrameMessages deliverSingleFragment(Bucket *pBucket, const uint8_t *pSubPacket, uint64_t lDeliveryOrder, uint8_t lFromSource);
+
+    // Deliver the superframe of a bucket now (complete or not)
+    void deliverBucketNow(Bucket *pBucket);
+
+    // Detect and handle a jump in the superframe numbers of a source (see setDiscontinuityDetection)
+    void checkDiscontinuity(uint16_t lSuperFrameNo, uint8_t lSource);
+
+    // Call the discontinuityCallback for the discontinuities found. mReceiveMtx and mNetMtx must NOT be held by the caller
+    void reportDiscontinuities();
+
+    // Free a bucket used by an other superframe according to the eviction policy. Returns false if not evicted
+    bool evictBucket(Bucket *pBucket, uint16_t lSuperFrameNo, uint8_t lFlags);
+
+    // Take a superframe being assembled out of the delivery order, delivered now or dropped. mNetMtx must be held
+    void removeBucket(Bucket *pBucket, bool lDeliver);
+
+    // Method unpacking Type7 (streaming) fragments
+    ElasticFrameMessages unpackType7(const uint8_t *pSubPacket, size_t lPacketSize, uint8_t lFromSource);
+
+    // Returns the time out for a bucket receiving fragment lFragmentNo now. Also feeds the adaptive timeout and
+    // times out older buckets beyond the max reorder distance
+    int64_t bucketDeadline(Bucket *pBucket, uint16_t lFragmentNo, bool lNewBucket);
+
+    // In HOL mode is the bucket allowed to be delivered before the expected superframe?
+    bool headOfLineExpired(Bucket *pBucket, int64_t lTimeNow);
+
+    // Allocate a superframe for the bucket charging the memory budget (if any)
+    ElasticFrameMessages allocateSuperFrame(pFramePtr &rFrame, size_t lSize, Bucket *pBucket);
+
+    // Make sure the bucket can hold lSize bytes. Used by streamed superframes where the size is unknown
+    ElasticFrameMessages growBucket(Bucket *pBucket, size_t lSize);
+
+    // Set the number of fragments and the size of a streamed superframe when the end is received
+    ElasticFrameMessages endStreamedBucket(Bucket *pBucket, uint16_t lOfFragmentNo, size_t lType1PacketSize, size_t lFrameSize);
+
+    // Method unpacking Type5 (FEC) fragments
+    ElasticFrameMessages unpackType5(const uint8_t *pSubPacket, size_t lPacketSize);
+
+    // Rebuild a missing type1 fragment in the FEC group covering lFragmentNo if possible
+    void recoverWithFEC(Bucket *pBucket, uint16_t lFragmentNo);
+
+    // Set the delivery information in the superframe from the bucket
+    void prepareSuperFrame(Bucket *pBucket);
+
+    // Pass newly completed data at the head of the superframe to the receiveChunkCallback
+    void deliverChunks(Bucket *pBucket);
+
+    // Generate NACKs for buckets missing fragments
+    void generateNacks(int64_t lTimeNow, std::vector<std::pair<uint8_t, std::vector<uint8_t>>> &rNacks);
+
+    // Generate NACKs and call the nackCallback
+    void sendNacks(int64_t lTimeNow);
+
     // The worker thread assembling unpacked fragments and delivering the superFrames to the deliveryWorker()
     void receiverWorker();
 
     // The worker thread acting as a bridge between EFP and the user
     void deliveryWorker();
 
+    // The worker thread delivering the superframes of one stream
+    void laneWorker(DeliveryLane *pLane);
+
+    // Stop the thread of a lane and delete the lane
+    ElasticFrameMessages stopLane(std::unique_ptr<DeliveryLane> pLane);
+
     // If EFP is put into 'run to completion' this is the method called to deal with all data in the buffers + new data
-    void runToCompletionMethod(const std::function<void(pFramePtr &rPacket, ElasticFrameProtocolContext* pCTX)>& rReceiveFunction);
+    void runToCompletionMethod(const std::function<void(pFramePtr &rPacket, ElasticFrameProtocolContext* pCTX)>& rReceiveFunction, int64_t lTimeNow);
 
     // Recalculate the 16-bit vector to a 64-bit vector
     uint64_t superFrameRecalculator(uint16_t lSuperFrame);
@@ -588,10 +1532,56 @@ private:
     // Internal lists and variables ----- START ------
     Stream mStreams[UINT8_MAX];                 // EFP-Stream information store
     std::map<uint64_t , Bucket*> mBucketMap;    // Sorted (super frame number) pointers to mBucketList items
-    Bucket *mBucketList;                        // Internal queue where all fragments are stored and super frames delivered from
+    Bucket *mBucketList = nullptr;              // Internal queue where all fragments are stored and super frames delivered from
     uint32_t mBucketTimeoutms = 0;              // Time out passed to receiver (in milliseconds)
+    bool mAdaptiveTimeout = false;              // Learn the bucket time out (see setAdaptiveTimeout)
+    double mAdaptivePercentile = 0.99;
+    int64_t mAdaptiveFloorUs = 0;
+    int64_t mAdaptiveCeilingUs = 0;
+    std::map<uint16_t, AdaptiveTimeout> mAdaptiveTimeouts; // Key is source << 8 | stream
+    uint32_t mMaxReorderSuperFrames = 0;        // See setMaxReorderDistance
+    uint32_t mMaxReorderFragments = 0;
+    uint64_t mFragmentSequence = 0;             // Number of fragments received by the buckets
+    uint16_t mDiscontinuityThreshold = 0;       // See setDiscontinuityDetection
+    bool mDeliverStaleBuckets = true;
+    uint16_t mLastSuperFrameNo[256] = {0};      // The latest superframe number per source
+    bool mHaveLastSuperFrameNo[256] = {false};
+    std::vector<Discontinuity> mDiscontinuities;        // Found under mNetMtx waiting for reportDiscontinuities
     uint32_t mHeadOfLineBlockingTimeoutms = 0;  // HOL time out passed to receiver (in milliseconds)
     std::mutex mNetMtx;                         // Mutex protecting the bucket queue
+    std::mutex mPushMtx;                        // Keeps the order of the superframes pushed (taken before mNetMtx)
+    std::vector<pFramePtr> mSuperFramesToPush;  // Superframes taken from the buckets waiting for pushSuperFrames (mNetMtx)
+    std::atomic_bool mHaveSuperFramesToPush = {false};
+
+    // NACK settings
+    uint32_t mNackDelayms = 0;
+    uint32_t mNackIntervalms = 0;
+    uint8_t mMaxNacks = 0;
+    std::vector<std::pair<uint8_t, std::vector<uint8_t>>> mNacks; // NACKs waiting to be passed to the nackCallback
+    std::vector<pFramePtr> mRunToCompletionBatch; // Superframes to be passed to the receiveBatchCallback in run to completion mode
+    std::vector<pFramePtr> mEvictedSuperFrames; // Superframes evicted, flushed or in a single fragment waiting to be delivered in run to completion mode
+    bool mSingleFragmentView = false;
+    size_t mNonTemporalThreshold = EFP_NON_TEMPORAL_THRESHOLD;
+    bool mHugePages = false;
+    size_t mMapThreshold = EFP_HUGE_PAGE_THRESHOLD; // Superframes from this size are mapped (huge pages and/or NUMA node)
+    bool mHugePagePreFault = true;
+    size_t mBucketListMappedSize = 0; // Size of the mapping if the bucket list is mapped
+    int32_t mNumaNode = -1;           // NUMA node of the threads and memory. -1 == not set
+    std::mutex mThreadConfigMtx;      // Protects the thread configuration and the EFPThread members
+    ThreadConfig mThreadConfig;
+    bool mThreadConfigSet = false;    // The scheduling is only changed if setThreadConfig was called
+    bool mThreadsPinned = false;      // The threads have been pinned (by setThreadConfig or setNumaNode)
+#ifdef __linux__
+    cpu_set_t mThreadCpus = {};       // CPUs the EFP threads are pinned to
+    cpu_set_t mNumaCpus = {};         // CPUs of the NUMA node
+#endif
+    bool mNumaPinned = false;         // The threads are pinned to the NUMA node CPUs
+    EFPThread mReceiverThread;        // receiverWorker
+    EFPThread mDeliveryThread;        // deliveryWorker
+    EFPEvictionPolicy mEvictionPolicy = EFPEvictionPolicy::REJECT;
+    EvictionCounters mEvictionCounters;
+    std::shared_ptr<ElasticFrameProtocolMemoryBudget> mMemoryBudget = nullptr;
+    uint64_t mMemoryBudgetId = 0;
 
     // Various counters to keep track of the different frames
     uint16_t mOldSuperFrameNumber = 0;
@@ -612,6 +1602,24 @@ private:
     std::mutex mSuperFrameMtx;
     std::condition_variable mSuperFrameDeliveryConditionVariable;
     bool mSuperFrameReady = false;
+    std::condition_variable mSuperFrameSpaceConditionVariable; //Signaled when superframes are taken from the queue (EFPQueuePolicy::BLOCK)
+    size_t mMaxQueueSize = 0;                   //0 == no limit
+    EFPQueuePolicy mQueuePolicy = EFPQueuePolicy::BLOCK;
+    DeliveryQueueCounters mQueueCounters;
+    bool mPriorityDelivery = false;
+    bool mPlayout = false;
+    int64_t mPlayoutLatencyUs = 0;
+    uint64_t mPlayoutTimebase = 90000;
+    std::multimap<int64_t, pFramePtr> mPlayoutBuffer; // Superframes waiting for playout. Key is the delivery time
+    PlayoutClock mPlayoutClocks[256];
+    PlayoutCounters mPlayoutCounters;
+    int mReadinessFd = -1;                      //eventfd signaling superframes in the queue (pull mode)
+    std::unique_ptr<DeliveryLane> mDeliveryLanes[UINT8_MAX + 1]; //Per stream delivery lanes (protected by mNetMtx)
+#ifdef EFP_COROUTINES
+    FrameAwaitable *pFrameWaiter = nullptr;     //The coroutine waiting for a superframe (protected by mSuperFrameMtx)
+    std::coroutine_handle<> mFrameWaiterHandle;
+    std::vector<std::coroutine_handle<>> mCoroutinesToResume; //(protected by mSuperFrameMtx)
+#endif
     EFPReceiverMode mCurrentMode;
     // Internal lists and variables ----- END ------
 };
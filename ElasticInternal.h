@@ -26,13 +26,19 @@
 // * - 0x02 frame is less than MTU or the tail of a larger superframe
 // * - 0x03 The reminder of the data does not fit a type2 packet but its the tail of the data.
 // * - 0x04 minimalistic type2-type frame used when static EFP stream and reciever signaled known stream.
+// * - 0x05 FEC fragment. XOR parity over a group of type1 fragments belonging to the same superframe
+// * - 0x06 NACK. Sent from the receiver back to the sender listing fragments missing in a superframe
+// * - 0x07 Like type1 but the number of fragments in the superframe is unknown (streaming). The end is signaled by type3/type2
 
 enum Frametype : uint8_t { //The 4 LSB are used! (The 4 MSB are the flags)
     type0 = 0,
     type1,
     type2,
     type3,
-    type4
+    type4,
+    type5,
+    type6,
+    type7
 };
 
 struct ElasticFrameType0 {
@@ -129,6 +135,77 @@ struct ElasticFrameType4 {
 __attribute__((packed))
 #endif
 ;
+//FEC fragment. The payload is the XOR of the payload of hGroupSize type1 fragments starting at hFragmentNo
+struct ElasticFrameType5 {
+#ifndef __ANDROID__
+#pragma pack(push, 1)
+#endif
+    uint8_t hFrameType = Frametype::type5;
+    uint8_t  hStreamID = 0;
+    uint16_t hSuperFrameNo = 0;
+    uint16_t hFragmentNo = 0;
+    uint16_t hGroupSize = 0;
+    uint16_t hOfFragmentNo = 0;
+    uint16_t hType1PacketSize = 0;
+#ifndef __ANDROID__
+#pragma pack(pop)
+#endif
+}
+#ifdef __ANDROID__
+__attribute__((packed))
+#endif
+;
+//NACK. The header is followed by hNumberOfRanges ElasticNackRange
+struct ElasticFrameType6 {
+#ifndef __ANDROID__
+#pragma pack(push, 1)
+#endif
+    uint8_t hFrameType = Frametype::type6;
+    uint8_t  hStreamID = 0;
+    uint16_t hSuperFrameNo = 0;
+    uint16_t hNumberOfRanges = 0;
+#ifndef __ANDROID__
+#pragma pack(pop)
+#endif
+}
+#ifdef __ANDROID__
+__attribute__((packed))
+#endif
+;
+
+//A range of missing fragments (both inclusive)
+struct ElasticNackRange {
+#ifndef __ANDROID__
+#pragma pack(push, 1)
+#endif
+    uint16_t hFirstFragmentNo = 0;
+    uint16_t hLastFragmentNo = 0;
+#ifndef __ANDROID__
+#pragma pack(pop)
+#endif
+}
+#ifdef __ANDROID__
+__attribute__((packed))
+#endif
+;
+//Streaming fragment. Same size as type1 since it's followed by a type3/type2 using the type1 fragment size
+struct ElasticFrameType7 {
+#ifndef __ANDROID__
+#pragma pack(push, 1)
+#endif
+    uint8_t hFrameType = Frametype::type7;
+    uint8_t  hStreamID = 0;
+    uint16_t hSuperFrameNo = 0;
+    uint16_t hFragmentNo = 0;
+    uint16_t hType1PacketSize = 0;
+#ifndef __ANDROID__
+#pragma pack(pop)
+#endif
+}
+#ifdef __ANDROID__
+__attribute__((packed))
+#endif
+;
 //Packet header part ----- END ------
 
 
@@ -102,6 +102,44 @@ int16_t efp_send_data(uint64_t efp_object,
                       uint8_t stream_id,
                       uint8_t flags);
 
+///Embedded data section used by efp_send_data_embedded
+typedef struct {
+    const uint8_t *data;
+    size_t size;
+    uint8_t type; //ElasticFrameEmbeddedContentDefines without the last flag
+} efp_embedded_section;
+
+/**
+* efp_send_data_embedded
+*
+* Send a superframe with embedded data without assembling it first (see efp_add_embedded_data).
+* The embedded data and the payload are copied straight to the fragments. INLINE_PAYLOAD is set if sections > 0
+*
+* @efp_object object ID to address
+* @param sections the embedded data sections in the order they are placed in the superframe
+* @param number_of_sections number of sections
+* @param pointer to the payload to be sent
+* @param size of the payload to be sent
+* @param data_content ElasticFrameContent::x where x is the type of data to be sent.
+* @param pts the pts value of the content
+* @param dts the dts value of the content
+* @param code if msb (uint8_t) of ElasticFrameContent is set. Then code is used to further declare the content
+* @param stream_id The EFP-stream ID the data is associated with.
+* @param flags signal what flags are used
+* @return ElasticFrameMessages cast to int16_t
+*/
+int16_t efp_send_data_embedded(uint64_t efp_object,
+                               const efp_embedded_section *sections,
+                               size_t number_of_sections,
+                               const uint8_t *data,
+                               size_t size,
+                               uint8_t data_content,
+                               uint64_t pts,
+                               uint64_t dts,
+                               uint32_t code,
+                               uint8_t stream_id,
+                               uint8_t flags);
+
 /**
 * efp_receive_fragment
 *
@@ -116,6 +154,24 @@ int16_t efp_receive_fragment(uint64_t efp_object,
                              size_t size,
                              uint8_t from_source);
 
+/**
+* efp_process_timeouts
+*
+* Deliver complete and timed out superframes without receiving a fragment (run to completion mode only)
+*
+* @efp_object object ID to address
+* @return ElasticFrameMessages cast to int16_t (notImplemented if not in run to completion mode)
+*/
+int16_t efp_process_timeouts(uint64_t efp_object);
+
+/**
+* efp_next_deadline
+*
+* @efp_object object ID to address
+* @return microseconds until efp_process_timeouts should be called, 0 now and -1 if nothing is pending
+*/
+int64_t efp_next_deadline(uint64_t efp_object);
+
 /**
 * efp_add_embedded_data
 *
@@ -20,6 +20,31 @@
 #include "unitTests/UnitTest18.h"
 #include "unitTests/UnitTest19.h"
 #include "unitTests/UnitTest20.h"
+#include "unitTests/UnitTest21.h"
+#include "unitTests/UnitTest22.h"
+#include "unitTests/UnitTest23.h"
+#include "unitTests/UnitTest24.h"
+#include "unitTests/UnitTest25.h"
+#include "unitTests/UnitTest26.h"
+#include "unitTests/UnitTest27.h"
+#include "unitTests/UnitTest28.h"
+#include "unitTests/UnitTest29.h"
+#include "unitTests/UnitTest30.h"
+#include "unitTests/UnitTest31.h"
+#include "unitTests/UnitTest32.h"
+#include "unitTests/UnitTest33.h"
+#include "unitTests/UnitTest34.h"
+#include "unitTests/UnitTest35.h"
+#include "unitTests/UnitTest36.h"
+#include "unitTests/UnitTest37.h"
+#include "unitTests/UnitTest38.h"
+#include "unitTests/UnitTest39.h"
+#include "unitTests/UnitTest40.h"
+#include "unitTests/UnitTest41.h"
+#include "unitTests/UnitTest42.h"
+#include "unitTests/UnitTest43.h"
+#include "unitTests/UnitTest44.h"
+#include "unitTests/UnitTest45.h"
 #include "unitTests/PerformanceLab.h"
 
 #include <iostream>
@@ -30,6 +55,22 @@ int main() {
     //myPerformanceLab.startUnitTest();
     //code will never get to here
 
+    //Compare normal and non-temporal copies of received data (cycles per byte and the effect on a co-running workload)
+    //PerformanceLab myPerformanceLab;
+    //myPerformanceLab.copyBenchmark();
+
+    //Compare the default allocator and huge pages for received superframes (throughput and dTLB misses)
+    //PerformanceLab myPerformanceLab;
+    //myPerformanceLab.hugePageBenchmark();
+
+    //Compare the throughput of a threaded receiver placed on the different NUMA nodes (setNumaNode)
+    //PerformanceLab myPerformanceLab;
+    //myPerformanceLab.numaBenchmark();
+
+    //Sweep the fragment loss and the FEC group size (intact superframes and latency against the FEC overhead)
+    //PerformanceLab myPerformanceLab;
+    //myPerformanceLab.fecLossSweep();
+
     int returnCode = EXIT_SUCCESS;
 
     //Test sending a packet less than MTU + header - > Expected result is one type2 frame only sent
@@ -189,5 +230,182 @@ int main() {
         returnCode = EXIT_FAILURE;
     }
 
+    //Test FEC. Drop one type1 fragment in two FEC groups. The superframe should be rebuilt and delivered intact without waiting for the timeout.
+    UnitTest21 unitTest21;
+    if (!unitTest21.startUnitTest()) {
+        std::cout << "Unit test 21 failed" << std::endl;
+        returnCode = EXIT_FAILURE;
+    }
+
+    //Test NACK. Drop a fragment, the receiver NACKs it and the sender re-sends it from the retransmit cache.
+    UnitTest22 unitTest22;
+    if (!unitTest22.startUnitTest()) {
+        std::cout << "Unit test 22 failed" << std::endl;
+        returnCode = EXIT_FAILURE;
+    }
+
+    //Test cut-through delivery. Fragments are delivered slightly out of order, the chunks must be delivered in order before the superframe.
+    UnitTest23 unitTest23;
+    if (!unitTest23.startUnitTest()) {
+        std::cout << "Unit test 23 failed" << std::endl;
+        returnCode = EXIT_FAILURE;
+    }
+
+    //Test the missing ranges. A intact superframe has none, a broken superframe describes the data missing.
+    UnitTest24 unitTest24;
+    if (!unitTest24.startUnitTest()) {
+        std::cout << "Unit test 24 failed" << std::endl;
+        returnCode = EXIT_FAILURE;
+    }
+
+    //Test the streaming sender. Superframes of unknown size are sent while the data is produced.
+    UnitTest25 unitTest25;
+    if (!unitTest25.startUnitTest()) {
+        std::cout << "Unit test 25 failed" << std::endl;
+        returnCode = EXIT_FAILURE;
+    }
+
+    //Test processTimeouts/nextDeadline. A broken superframe is delivered in run to completion mode without new fragments.
+    UnitTest26 unitTest26;
+    if (!unitTest26.startUnitTest()) {
+        std::cout << "Unit test 26 failed" << std::endl;
+        returnCode = EXIT_FAILURE;
+    }
+
+    //Test the pull mode receiver. Superframes are pulled when the readiness file descriptor is readable.
+    UnitTest27 unitTest27;
+    if (!unitTest27.startUnitTest()) {
+        std::cout << "Unit test 27 failed" << std::endl;
+        returnCode = EXIT_FAILURE;
+    }
+
+#ifdef EFP_COROUTINES
+    //Test the coroutine API. Send with backpressure and receive using co_await.
+    UnitTest28 unitTest28;
+    if (!unitTest28.startUnitTest()) {
+        std::cout << "Unit test 28 failed" << std::endl;
+        returnCode = EXIT_FAILURE;
+    }
+#endif
+
+    //Test the batch delivery callback. Superframes queued up are delivered in one call.
+    UnitTest29 unitTest29;
+    if (!unitTest29.startUnitTest()) {
+        std::cout << "Unit test 29 failed" << std::endl;
+        returnCode = EXIT_FAILURE;
+    }
+
+    //Test per stream delivery lanes. A blocked consumer of one stream must not stall other streams.
+    UnitTest30 unitTest30;
+    if (!unitTest30.startUnitTest()) {
+        std::cout << "Unit test 30 failed" << std::endl;
+        returnCode = EXIT_FAILURE;
+    }
+
+    //Test the delivery queue limit and the policies when the queue is full.
+    UnitTest31 unitTest31;
+    if (!unitTest31.startUnitTest()) {
+        std::cout << "Unit test 31 failed" << std::endl;
+        returnCode = EXIT_FAILURE;
+    }
+
+    //Test priority delivery. Higher priority superframes first but in order within a stream.
+    UnitTest32 unitTest32;
+    if (!unitTest32.startUnitTest()) {
+        std::cout << "Unit test 32 failed" << std::endl;
+        returnCode = EXIT_FAILURE;
+    }
+
+    //Test the eviction policies when a fragment maps to a bucket used by an other superframe.
+    UnitTest33 unitTest33;
+    if (!unitTest33.startUnitTest()) {
+        std::cout << "Unit test 33 failed" << std::endl;
+        returnCode = EXIT_FAILURE;
+    }
+
+    //Test the memory budget shared by two receivers.
+    UnitTest34 unitTest34;
+    if (!unitTest34.startUnitTest()) {
+        std::cout << "Unit test 34 failed" << std::endl;
+        returnCode = EXIT_FAILURE;
+    }
+
+    //Test the adaptive bucket timeout under jitter.
+    UnitTest35 unitTest35;
+    if (!unitTest35.startUnitTest()) {
+        std::cout << "Unit test 35 failed" << std::endl;
+        returnCode = EXIT_FAILURE;
+    }
+
+    //Test the playout mode.
+    UnitTest36 unitTest36;
+    if (!unitTest36.startUnitTest()) {
+        std::cout << "Unit test 36 failed" << std::endl;
+        returnCode = EXIT_FAILURE;
+    }
+
+    //Test the max reorder distance.
+    UnitTest37 unitTest37;
+    if (!unitTest37.startUnitTest()) {
+        std::cout << "Unit test 37 failed" << std::endl;
+        returnCode = EXIT_FAILURE;
+    }
+
+    //Test the discontinuity detection when a sender restarts.
+    UnitTest38 unitTest38;
+    if (!unitTest38.startUnitTest()) {
+        std::cout << "Unit test 38 failed" << std::endl;
+        returnCode = EXIT_FAILURE;
+    }
+
+    //Test the fast path for superframes in a single fragment.
+    UnitTest39 unitTest39;
+    if (!unitTest39.startUnitTest()) {
+        std::cout << "Unit test 39 failed" << std::endl;
+        returnCode = EXIT_FAILURE;
+    }
+
+    //Test reading embedded data without copying it.
+    UnitTest40 unitTest40;
+    if (!unitTest40.startUnitTest()) {
+        std::cout << "Unit test 40 failed" << std::endl;
+        returnCode = EXIT_FAILURE;
+    }
+
+    //Test sending embedded data and the payload from separate buffers.
+    UnitTest41 unitTest41;
+    if (!unitTest41.startUnitTest()) {
+        std::cout << "Unit test 41 failed" << std::endl;
+        returnCode = EXIT_FAILURE;
+    }
+
+    //Test the non-temporal copy of received data.
+    UnitTest42 unitTest42;
+    if (!unitTest42.startUnitTest()) {
+        std::cout << "Unit test 42 failed" << std::endl;
+        returnCode = EXIT_FAILURE;
+    }
+
+    //Test huge pages for the bucket list and large superframes.
+    UnitTest43 unitTest43;
+    if (!unitTest43.startUnitTest()) {
+        std::cout << "Unit test 43 failed" << std::endl;
+        returnCode = EXIT_FAILURE;
+    }
+
+    //Test placing the receiver on a NUMA node.
+    UnitTest44 unitTest44;
+    if (!unitTest44.startUnitTest()) {
+        std::cout << "Unit test 44 failed" << std::endl;
+        returnCode = EXIT_FAILURE;
+    }
+
+    //Test configuring the receiver threads.
+    UnitTest45 unitTest45;
+    if (!unitTest45.startUnitTest()) {
+        std::cout << "Unit test 45 failed" << std::endl;
+        returnCode = EXIT_FAILURE;
+    }
+
     return returnCode;
 }
@@ -6,6 +6,20 @@
 
 #include "PerformanceLab.h"
 
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#include <sched.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define READ_CYCLES() __rdtsc()
+#else
+#define READ_CYCLES() (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count()
+#endif
+
 void PerformanceLab::sendData(const std::vector<uint8_t> &subPacket) {
     ElasticFrameMessages info = myEFPReciever->receiveFragment(subPacket, 0);
     if (info != ElasticFrameMessages::noError) {
@@ -49,4 +63,315 @@ bool PerformanceLab::startUnitTest() {
             return false;
         }
     }
-}
\ No newline at end of file
+}
+// Random walk over a working set. Simulates a co-running workload sharing the caches with the receiver
+uint64_t PerformanceLab::walkWorkload(const std::vector<uint64_t> &rWorkload, size_t lSteps) {
+    uint64_t lIndex = 0;
+    for (size_t x = 0; x < lSteps; x++) {
+        lIndex = rWorkload[lIndex];
+    }
+    return lIndex;
+}
+
+//Receive large superframes (raw video sized) using normal and non-temporal copies (setNonTemporalCopyThreshold)
+//Prints the receive cycles per byte and the cycles per step of a workload running between the superframes.
+//(Cycles are nanoseconds on targets without a time stamp counter)
+bool PerformanceLab::copyBenchmark() {
+    const size_t lFrameSize = 8 * 1024 * 1024;
+    const size_t lFrames = 200;
+    const size_t lSteps = 1 << 20;
+
+    //1 MB working set linked in a random order
+    std::vector<uint64_t> lWorkload(128 * 1024);
+    std::vector<uint64_t> lOrder(lWorkload.size());
+    for (size_t x = 0; x < lOrder.size(); x++) {
+        lOrder[x] = x;
+    }
+    std::shuffle(lOrder.begin() + 1, lOrder.end(), std::mt19937(1));
+    for (size_t x = 0; x < lOrder.size(); x++) {
+        lWorkload[lOrder[x]] = lOrder[(x + 1) % lOrder.size()];
+    }
+
+    std::vector<uint8_t> mydata(lFrameSize, 0xaa);
+    for (size_t lThreshold: {(size_t) SIZE_MAX, (size_t) 0}) {
+        myEFPReciever = new(std::nothrow) ElasticFrameProtocolReceiver(50, 0, nullptr, ElasticFrameProtocolReceiver::EFPReceiverMode::RUN_TO_COMPLETION);
+        myEFPPacker = new(std::nothrow) ElasticFrameProtocolSender(MTU);
+        if (myEFPReciever == nullptr || myEFPPacker == nullptr) {
+            if (myEFPReciever) delete myEFPReciever;
+            if (myEFPPacker) delete myEFPPacker;
+            return false;
+        }
+        myEFPReciever->setNonTemporalCopyThreshold(lThreshold);
+        myEFPReciever->receiveCallback = [](ElasticFrameProtocolReceiver::pFramePtr &rPacket, ElasticFrameProtocolContext *pCTX) {};
+        std::vector<std::vector<uint8_t>> lFragments;
+        myEFPPacker->sendCallback = [&](const std::vector<uint8_t> &rSubPacket, uint8_t lStreamID, ElasticFrameProtocolContext *pCTX) {
+            lFragments.push_back(rSubPacket);
+        };
+
+        uint64_t lReceiveCycles = 0;
+        uint64_t lWorkloadCycles = 0;
+        uint64_t lSink = 0;
+        for (uint64_t lPts = 1; lPts <= lFrames; lPts++) {
+            lFragments.clear();
+            myEFPPacker->packAndSend(mydata, ElasticFrameContent::h264, lPts, lPts, EFP_CODE('A', 'N', 'X', 'B'), 1, NO_FLAGS);
+            lSink += walkWorkload(lWorkload, lSteps); //Warm the working set
+            uint64_t lStart = READ_CYCLES();
+            for (auto &rFragment: lFragments) {
+                myEFPReciever->receiveFragment(rFragment, 0);
+            }
+            uint64_t lReceived = READ_CYCLES();
+            lSink += walkWorkload(lWorkload, lSteps);
+            lReceiveCycles += lReceived - lStart;
+            lWorkloadCycles += READ_CYCLES() - lReceived;
+        }
+        std::cout << (lThreshold ? "Normal copy" : "Non-temporal copy") << " receive cycles/byte: "
+                  << (double) lReceiveCycles / (double) (lFrameSize * lFrames) << " workload cycles/step: "
+                  << (double) lWorkloadCycles / (double) (lSteps * lFrames) << " (" << lSink % 2 << ")" << std::endl;
+        delete myEFPPacker;
+        delete myEFPReciever;
+    }
+    return true;
+}
+
+#ifdef __linux__
+// Open a counter of the dTLB load misses of this thread. -1 if not available (no PMU access in VMs/containers)
+static int openDTLBMissCounter() {
+    perf_event_attr lAttr = {};
+    lAttr.type = PERF_TYPE_HW_CACHE;
+    lAttr.size = sizeof(lAttr);
+    lAttr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+    lAttr.disabled = 1;
+    lAttr.exclude_kernel = 1;
+    return (int) syscall(SYS_perf_event_open, &lAttr, 0, -1, -1, 0);
+}
+#endif
+
+//Receive 8 MB superframes with the fragments of four superframes at a time arriving in random order, using the
+//default allocator and huge pages (setHugePages). Prints the throughput and the dTLB load misses per superframe.
+bool PerformanceLab::hugePageBenchmark() {
+    const size_t lFrameSize = 8 * 1024 * 1024;
+    const size_t lFrames = 200;
+    const size_t lInterleave = 4;
+
+    std::vector<uint8_t> mydata(lFrameSize, 0xaa);
+    for (bool lHugePages: {false, true}) {
+        myEFPReciever = new(std::nothrow) ElasticFrameProtocolReceiver(1000, 0, nullptr, ElasticFrameProtocolReceiver::EFPReceiverMode::RUN_TO_COMPLETION);
+        myEFPPacker = new(std::nothrow) ElasticFrameProtocolSender(MTU);
+        if (myEFPReciever == nullptr || myEFPPacker == nullptr) {
+            if (myEFPReciever) delete myEFPReciever;
+            if (myEFPPacker) delete myEFPPacker;
+            return false;
+        }
+        if (lHugePages && myEFPReciever->setHugePages(true) != ElasticFrameMessages::noError) {
+            std::cout << "Huge pages not supported" << std::endl;
+            delete myEFPPacker;
+            delete myEFPReciever;
+            return false;
+        }
+        size_t lDelivered = 0;
+        myEFPReciever->receiveCallback = [&](ElasticFrameProtocolReceiver::pFramePtr &rPacket, ElasticFrameProtocolContext *pCTX) {
+            lDelivered++;
+        };
+        std::vector<std::vector<uint8_t>> lFragments;
+        myEFPPacker->sendCallback = [&](const std::vector<uint8_t> &rSubPacket, uint8_t lStreamID, ElasticFrameProtocolContext *pCTX) {
+            lFragments.push_back(rSubPacket);
+        };
+        std::mt19937 lRandom(1);
+
+#ifdef __linux__
+        int lCounter = openDTLBMissCounter();
+#endif
+        std::chrono::nanoseconds lTime(0);
+        for (uint64_t lPts = 1; lPts <= lFrames; lPts += lInterleave) {
+            lFragments.clear();
+            for (size_t x = 0; x < lInterleave; x++) {
+                myEFPPacker->packAndSend(mydata, ElasticFrameContent::h264, lPts + x, lPts + x, EFP_CODE('A', 'N', 'X', 'B'), 1, NO_FLAGS);
+            }
+            std::shuffle(lFragments.begin(), lFragments.end(), lRandom);
+#ifdef __linux__
+            if (lCounter >= 0) {
+                ioctl(lCounter, PERF_EVENT_IOC_ENABLE, 0);
+            }
+#endif
+            auto lStart = std::chrono::steady_clock::now();
+            for (auto &rFragment: lFragments) {
+                myEFPReciever->receiveFragment(rFragment, 0);
+            }
+            lTime += std::chrono::steady_clock::now() - lStart;
+#ifdef __linux__
+            if (lCounter >= 0) {
+                ioctl(lCounter, PERF_EVENT_IOC_DISABLE, 0);
+            }
+#endif
+        }
+        std::cout << (lHugePages ? "Huge pages" : "Default allocator") << " MB/s: "
+                  << (double) (lFrameSize * lDelivered) / (double) std::chrono::duration_cast<std::chrono::microseconds>(lTime).count();
+#ifdef __linux__
+        uint64_t lMisses = 0;
+        if (lCounter >= 0 && read(lCounter, &lMisses, sizeof(lMisses)) == sizeof(lMisses)) {
+            std::cout << " dTLB load misses/superframe: " << (double) lMisses / (double) lDelivered;
+        } else {
+            std::cout << " dTLB load misses/superframe: n/a";
+        }
+        if (lCounter >= 0) {
+            close(lCounter);
+        }
+#endif
+        std::cout << std::endl;
+        delete myEFPPacker;
+        delete myEFPReciever;
+    }
+    return true;
+}
+
+//Receive 8 MB superframes in a threaded receiver where the delivery callback reads all data. The thread calling
+//receiveFragment is pinned to the CPU it runs on. Runs without placement and with the receiver placed (setNumaNode)
+//on every NUMA node, the node of the calling thread gives the local numbers the other nodes the cross-socket penalty.
+bool PerformanceLab::numaBenchmark() {
+#ifdef __linux__
+    const size_t lFrameSize = 8 * 1024 * 1024;
+    const size_t lFrames = 100;
+
+    unsigned lCpu = 0;
+    unsigned lNode = 0;
+    if (syscall(SYS_getcpu, &lCpu, &lNode, nullptr)) {
+        return false;
+    }
+    cpu_set_t lCpus;
+    CPU_ZERO(&lCpus);
+    CPU_SET(lCpu, &lCpus);
+    sched_setaffinity(0, sizeof(lCpus), &lCpus);
+    std::cout << "Sending from CPU " << lCpu << " on node " << lNode << std::endl;
+
+    std::vector<uint8_t> mydata(lFrameSize, 0xaa);
+    for (int32_t lReceiverNode = -1; lReceiverNode < 1024; lReceiverNode++) {
+        myEFPReciever = new(std::nothrow) ElasticFrameProtocolReceiver(1000, 0);
+        myEFPPacker = new(std::nothrow) ElasticFrameProtocolSender(MTU);
+        if (myEFPReciever == nullptr || myEFPPacker == nullptr) {
+            if (myEFPReciever) delete myEFPReciever;
+            if (myEFPPacker) delete myEFPPacker;
+            return false;
+        }
+        if (myEFPReciever->setNumaNode(lReceiverNode) != ElasticFrameMessages::noError) {
+            delete myEFPPacker;
+            delete myEFPReciever;
+            break; //No more nodes
+        }
+        myEFPReciever->setNonTemporalCopyThreshold(SIZE_MAX);
+        std::mutex lDeliveredMtx;
+        std::condition_variable lDeliveredCondition;
+        size_t lDelivered = 0;
+        uint64_t lSink = 0;
+        myEFPReciever->receiveCallback = [&](ElasticFrameProtocolReceiver::pFramePtr &rPacket, ElasticFrameProtocolContext *pCTX) {
+            uint64_t lSum = 0;
+            for (size_t x = 0; x < rPacket->mFrameSize; x += 64) {
+                lSum += rPacket->pFrameData[x];
+            }
+            std::lock_guard<std::mutex> lock(lDeliveredMtx);
+            lSink += lSum;
+            lDelivered++;
+            lDeliveredCondition.notify_one();
+        };
+        myEFPPacker->sendCallback = [&](const std::vector<uint8_t> &rSubPacket, uint8_t lStreamID, ElasticFrameProtocolContext *pCTX) {
+            myEFPReciever->receiveFragment(rSubPacket, 0);
+        };
+
+        auto lStart = std::chrono::steady_clock::now();
+        for (uint64_t lPts = 1; lPts <= lFrames; lPts++) {
+            myEFPPacker->packAndSend(mydata, ElasticFrameContent::h264, lPts, lPts, EFP_CODE('A', 'N', 'X', 'B'), 1, NO_FLAGS);
+        }
+        {
+            std::unique_lock<std::mutex> lock(lDeliveredMtx);
+            lDeliveredCondition.wait_for(lock, std::chrono::seconds(30), [&] { return lDelivered == lFrames; });
+        }
+        auto lTime = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - lStart);
+        if (lReceiverNode < 0) {
+            std::cout << "No placement";
+        } else {
+            std::cout << "Receiver on node " << lReceiverNode;
+        }
+        std::cout << " MB/s: " << (double) (lFrameSize * lDelivered) / (double) lTime.count() << " (" << lSink % 2 << ")" << std::endl;
+        delete myEFPPacker;
+        delete myEFPReciever;
+    }
+    return true;
+#else
+    return false;
+#endif
+}
+
+//Send 100 KB superframes every 2 ms over a channel dropping fragments at random to a run to completion receiver.
+//Sweeps the loss rate and the FEC group size (setFECGroupSize, 0 == no FEC). Prints the bytes sent over the payload
+//(overhead), the share of superframes delivered intact and the latency from packAndSend to delivery. Superframes
+//not recovered are delivered broken when the 20 ms bucket timeout expires.
+bool PerformanceLab::fecLossSweep() {
+    const size_t lFrameSize = 100 * 1024;
+    const size_t lFrames = 250;
+    const auto lFrameInterval = std::chrono::milliseconds(2);
+
+    std::vector<uint8_t> mydata(lFrameSize, 0xaa);
+    for (double lLoss: {0.0, 0.01, 0.02, 0.05, 0.1}) {
+        for (uint16_t lGroupSize: {(uint16_t) 0, (uint16_t) 20, (uint16_t) 10, (uint16_t) 5}) {
+            myEFPReciever = new(std::nothrow) ElasticFrameProtocolReceiver(20, 0, nullptr, ElasticFrameProtocolReceiver::EFPReceiverMode::RUN_TO_COMPLETION);
+            myEFPPacker = new(std::nothrow) ElasticFrameProtocolSender(MTU);
+            if (myEFPReciever == nullptr || myEFPPacker == nullptr) {
+                if (myEFPReciever) delete myEFPReciever;
+                if (myEFPPacker) delete myEFPPacker;
+                return false;
+            }
+            myEFPPacker->setFECGroupSize(1, lGroupSize);
+            std::map<uint64_t, std::chrono::steady_clock::time_point> lSendTimes;
+            size_t lIntact = 0;
+            size_t lDelivered = 0;
+            int64_t lLatencySumUs = 0;
+            int64_t lMaxLatencyUs = 0;
+            myEFPReciever->receiveCallback = [&](ElasticFrameProtocolReceiver::pFramePtr &rPacket, ElasticFrameProtocolContext *pCTX) {
+                if (!rPacket->mBroken) {
+                    lIntact++;
+                }
+                //The pts is lost with the type2 fragment
+                auto lSendTime = lSendTimes.find(rPacket->mPts);
+                if (lSendTime == lSendTimes.end()) {
+                    return;
+                }
+                auto lLatencyUs = std::chrono::duration_cast<std::chrono::microseconds>(
+                        std::chrono::steady_clock::now() - lSendTime->second).count();
+                lLatencySumUs += lLatencyUs;
+                lMaxLatencyUs = std::max(lMaxLatencyUs, (int64_t) lLatencyUs);
+                lDelivered++;
+            };
+            std::mt19937 lRandom(1);
+            std::bernoulli_distribution lDrop(lLoss);
+            size_t lBytesSent = 0;
+            myEFPPacker->sendCallback = [&](const std::vector<uint8_t> &rSubPacket, uint8_t lStreamID, ElasticFrameProtocolContext *pCTX) {
+                lBytesSent += rSubPacket.size();
+                if (!lDrop(lRandom)) {
+                    myEFPReciever->receiveFragment(rSubPacket, 0);
+                }
+            };
+
+            auto lNextFrame = std::chrono::steady_clock::now();
+            for (uint64_t lPts = 1; lPts <= lFrames; lPts++) {
+                std::this_thread::sleep_until(lNextFrame);
+                lNextFrame += lFrameInterval;
+                lSendTimes[lPts] = std::chrono::steady_clock::now();
+                myEFPPacker->packAndSend(mydata, ElasticFrameContent::h264, lPts, lPts, EFP_CODE('A', 'N', 'X', 'B'), 1, NO_FLAGS);
+                myEFPReciever->processTimeouts();
+            }
+            //Let the superframes not recovered time out
+            for (int x = 0; x < 10; x++) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+                myEFPReciever->processTimeouts();
+            }
+
+            std::cout << "Loss " << lLoss * 100.0 << "% FEC group " << lGroupSize << " overhead "
+                      << ((double) lBytesSent / (double) (lFrameSize * lFrames) - 1.0) * 100.0 << "% intact "
+                      << (double) lIntact * 100.0 / (double) lFrames << "% latency ms mean "
+                      << (lDelivered ? (double) lLatencySumUs / (double) lDelivered / 1000.0 : 0.0) << " max "
+                      << (double) lMaxLatencyUs / 1000.0 << std::endl;
+            delete myEFPPacker;
+            delete myEFPReciever;
+        }
+    }
+    return true;
+}
@@ -13,7 +13,12 @@
 class PerformanceLab {
 public:
     bool startUnitTest();
+    bool copyBenchmark();
+    bool hugePageBenchmark();
+    bool numaBenchmark();
+    bool fecLossSweep();
 private:
+    uint64_t walkWorkload(const std::vector<uint64_t> &rWorkload, size_t lSteps);
     void sendData(const std::vector<uint8_t> &subPacket);
     void gotData(ElasticFrameProtocolReceiver::pFramePtr &packet);
     ElasticFrameProtocolReceiver *myEFPReciever = nullptr;
@@ -0,0 +1,118 @@
+//UnitTest21
+//Test FEC. Send a superframe of 10 type1 fragments + a type2 fragment with a FEC group size of 4 (3 FEC fragments).
+//Drop type1 fragment 2 and 7 (one in each of the two first groups). The receiver (run to completion) must rebuild
+//the fragments and deliver a intact superframe as soon as the type2 fragment arrives. No timeout should be needed.
+
+#include "UnitTest21.h"
+
+void UnitTest21::sendData(const std::vector<uint8_t> &subPacket) {
+    //The fragments are sent in this order -> 0 1 2 3 FEC 4 5 6 7 FEC 8 9 FEC type2
+    int packetNumber = unitTestPacketNumberSender++;
+    if ((subPacket[0] & 0x0f) == 5) {
+        unitTestFECFragments++;
+    }
+    if (packetNumber == 2 || packetNumber == 8) {
+        return;
+    }
+    ElasticFrameMessages info = myEFPReciever->receiveFragment(subPacket, 0);
+    if (info != ElasticFrameMessages::noError) {
+        std::cout << "Error-> " << signed(info) << std::endl;
+        unitTestFailed = true;
+        unitTestActive = false;
+    }
+}
+
+void UnitTest21::gotData(ElasticFrameProtocolReceiver::pFramePtr &packet) {
+    if (packet->mPts != 1001 || packet->mCode != 2) {
+        unitTestFailed = true;
+        unitTestActive = false;
+        return;
+    }
+    if (packet->mBroken) {
+        std::cout << "The superframe is broken. FEC failed." << std::endl;
+        unitTestFailed = true;
+        unitTestActive = false;
+        return;
+    }
+    if (packet->mFrameSize != ((MTU - myEFPPacker->geType1Size()) * 10) + 12) {
+        unitTestFailed = true;
+        unitTestActive = false;
+        return;
+    }
+    uint8_t vectorChecker = 0;
+    for (size_t x = 0; x < packet->mFrameSize; x++) {
+        if (packet->pFrameData[x] != vectorChecker++) {
+            unitTestFailed = true;
+            unitTestActive = false;
+            return;
+        }
+    }
+    if (unitTestFECFragments != 3) {
+        std::cout << "Expected 3 FEC fragments got " << signed(unitTestFECFragments) << std::endl;
+        unitTestFailed = true;
+        unitTestActive = false;
+        return;
+    }
+    unitTestActive = false;
+    std::cout << "UnitTest " << unsigned(activeUnitTest) << " done." << std::endl;
+}
+
+bool UnitTest21::waitForCompletion() {
+    int breakOut = 0;
+    while (unitTestActive) {
+        //quarter of a second
+        std::this_thread::sleep_for(std::chrono::microseconds(1000 * 250));
+        if (breakOut++ == 10) {
+            std::cout << "waitForCompletion did wait for 5 seconds. fail the test." << std::endl;
+            unitTestFailed = true;
+            unitTestActive = false;
+        }
+    }
+    if (unitTestFailed) {
+        std::cout << "Unit test number: " << unsigned(activeUnitTest) << " Failed." << std::endl;
+        return true;
+    }
+    return false;
+}
+
+bool UnitTest21::startUnitTest() {
+    unitTestFailed = false;
+    unitTestActive = false;
+    ElasticFrameMessages result;
+    std::vector<uint8_t> mydata;
+    uint8_t streamID = 1;
+    //Long bucket timeout. If the FEC does not work the superframe is not delivered in time
+    myEFPReciever = new (std::nothrow) ElasticFrameProtocolReceiver(10000, 0, nullptr, ElasticFrameProtocolReceiver::EFPReceiverMode::RUN_TO_COMPLETION);
+    myEFPPacker = new (std::nothrow) ElasticFrameProtocolSender(MTU);
+    if (myEFPReciever == nullptr || myEFPPacker == nullptr) {
+        if (myEFPReciever) delete myEFPReciever;
+        if (myEFPPacker) delete myEFPPacker;
+        return false;
+    }
+    myEFPPacker->sendCallback = std::bind(&UnitTest21::sendData, this, std::placeholders::_1);
+    myEFPReciever->receiveCallback = std::bind(&UnitTest21::gotData, this, std::placeholders::_1);
+    myEFPPacker->setFECGroupSize(streamID, 4);
+    unitTestPacketNumberSender = 0;
+    unitTestFECFragments = 0;
+    mydata.resize(((MTU - myEFPPacker->geType1Size()) * 10) + 12);
+    std::generate(mydata.begin(), mydata.end(), [n = 0]() mutable { return n++; });
+    unitTestActive = true;
+    result = myEFPPacker->packAndSend(mydata, ElasticFrameContent::adts, 1001, 1, 2, streamID, NO_FLAGS);
+    if (result != ElasticFrameMessages::noError) {
+        std::cout << "Unit test number: " << unsigned(activeUnitTest) << " Failed in the packAndSend method. Error-> " << signed(result)
+                  << std::endl;
+        delete myEFPPacker;
+        delete myEFPReciever;
+        return false;
+    }
+
+    if (waitForCompletion()) {
+        delete myEFPPacker;
+        delete myEFPReciever;
+        return false;
+    } else {
+        delete myEFPPacker;
+        delete myEFPReciever;
+        return true;
+    }
+}
@@ -0,0 +1,123 @@
+//UnitTest22
+//Test NACK and retransmission. Send a superframe of 10 type1 fragments + a type2 fragment and drop type1 fragment 3 the first time it's sent.
+//The receiver NACKs the missing fragment, the NACK is looped back to the sender that re-sends the fragment from the retransmit cache.
+//The superframe must be delivered intact long before the bucket timeout.
+
+#include "UnitTest22.h"
+
+void UnitTest22::sendData(const std::vector<uint8_t> &subPacket) {
+    //Type1 fragment number is found at byte 4 and 5 in the type1 header
+    if ((subPacket[0] & 0x0f) == 1 && *(uint16_t *) (subPacket.data() + 4) == 3 && !unitTestDropped) {
+        unitTestDropped = true;
+        return;
+    }
+    ElasticFrameMessages info = myEFPReciever->receiveFragment(subPacket, 0);
+    if (info != ElasticFrameMessages::noError) {
+        std::cout << "Error-> " << signed(info) << std::endl;
+        unitTestFailed = true;
+        unitTestActive = false;
+    }
+}
+
+void UnitTest22::gotNack(const std::vector<uint8_t> &nack, uint8_t source) {
+    unitTestNacks++;
+    ElasticFrameMessages info = myEFPPacker->receiveNack(nack);
+    if (info != ElasticFrameMessages::noError) {
+        std::cout << "Error-> " << signed(info) << std::endl;
+        unitTestFailed = true;
+        unitTestActive = false;
+    }
+}
+
+void UnitTest22::gotData(ElasticFrameProtocolReceiver::pFramePtr &packet) {
+    if (packet->mPts != 1001 || packet->mCode != 2) {
+        unitTestFailed = true;
+        unitTestActive = false;
+        return;
+    }
+    if (packet->mBroken) {
+        std::cout << "The superframe is broken. Retransmission failed." << std::endl;
+        unitTestFailed = true;
+        unitTestActive = false;
+        return;
+    }
+    auto lDeliveryTime = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - unitTestSendTime).count();
+    if (lDeliveryTime > 500 || unitTestNacks != 1) {
+        std::cout << "Delivery time " << signed(lDeliveryTime) << " ms NACKs " << signed(unitTestNacks) << std::endl;
+        unitTestFailed = true;
+        unitTestActive = false;
+        return;
+    }
+    uint8_t vectorChecker = 0;
+    for (size_t x = 0; x < packet->mFrameSize; x++) {
+        if (packet->pFrameData[x] != vectorChecker++) {
+            unitTestFailed = true;
+            unitTestActive = false;
+            return;
+        }
+    }
+    unitTestActive = false;
+    std::cout << "UnitTest " << unsigned(activeUnitTest) << " done." << std::endl;
+}
+
+bool UnitTest22::waitForCompletion() {
+    int breakOut = 0;
+    while (unitTestActive) {
+        //quarter of a second
+        std::this_thread::sleep_for(std::chrono::microseconds(1000 * 250));
+        if (breakOut++ == 10) {
+            std::cout << "waitForCompletion did wait for 5 seconds. fail the test." << std::endl;
+            unitTestFailed = true;
+            unitTestActive = false;
+        }
+    }
+    if (unitTestFailed) {
+        std::cout << "Unit test number: " << unsigned(activeUnitTest) << " Failed." << std::endl;
+        return true;
+    }
+    return false;
+}
+
+bool UnitTest22::startUnitTest() {
+    unitTestFailed = false;
+    unitTestActive = false;
+    ElasticFrameMessages result;
+    std::vector<uint8_t> mydata;
+    uint8_t streamID = 1;
+    myEFPReciever = new (std::nothrow) ElasticFrameProtocolReceiver(2000, 0);
+    myEFPPacker = new (std::nothrow) ElasticFrameProtocolSender(MTU);
+    if (myEFPReciever == nullptr || myEFPPacker == nullptr) {
+        if (myEFPReciever) delete myEFPReciever;
+        if (myEFPPacker) delete myEFPPacker;
+        return false;
+    }
+    myEFPPacker->sendCallback = std::bind(&UnitTest22::sendData, this, std::placeholders::_1);
+    myEFPPacker->setRetransmitCacheSize(100);
+    myEFPReciever->receiveCallback = std::bind(&UnitTest22::gotData, this, std::placeholders::_1);
+    myEFPReciever->nackCallback = std::bind(&UnitTest22::gotNack, this, std::placeholders::_1, std::placeholders::_2);
+    myEFPReciever->setNackMode(20, 50, 3);
+    unitTestDropped = false;
+    unitTestNacks = 0;
+    mydata.resize(((MTU - myEFPPacker->geType1Size()) * 10) + 12);
+    std::generate(mydata.begin(), mydata.end(), [n = 0]() mutable { return n++; });
+    unitTestActive = true;
+    unitTestSendTime = std::chrono::steady_clock::now();
+    result = myEFPPacker->packAndSend(mydata, ElasticFrameContent::adts, 1001, 1, 2, streamID, NO_FLAGS);
+    if (result != ElasticFrameMessages::noError) {
+        std::cout << "Unit test number: " << unsigned(activeUnitTest) << " Failed in the packAndSend method. Error-> " << signed(result)
+                  << std::endl;
+        delete myEFPPacker;
+        delete myEFPReciever;
+        return false;
+    }
+
+    if (waitForCompletion()) {
+        delete myEFPReciever;
+        delete myEFPPacker;
+        return false;
+    } else {
+        delete myEFPReciever;
+        delete myEFPPacker;
+        return true;
+    }
+}
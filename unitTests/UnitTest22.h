@@ -0,0 +1,26 @@
+#ifndef EFP_UNITTEST22_H
+#define EFP_UNITTEST22_H
+
+#include "../ElasticFrameProtocol.h"
+
+#define MTU 1456 //SRT-max
+
+class UnitTest22 {
+public:
+    bool startUnitTest();
+private:
+    void sendData(const std::vector<uint8_t> &subPacket);
+    void gotData(ElasticFrameProtocolReceiver::pFramePtr &packet);
+    void gotNack(const std::vector<uint8_t> &nack, uint8_t source);
+    bool waitForCompletion();
+    ElasticFrameProtocolReceiver *myEFPReciever = nullptr;
+    ElasticFrameProtocolSender *myEFPPacker = nullptr;
+    std::atomic_bool unitTestActive;
+    std::atomic_bool unitTestFailed;
+    int activeUnitTest = 22;
+    std::atomic_bool unitTestDropped;
+    std::atomic_int unitTestNacks;
+    std::chrono::steady_clock::time_point unitTestSendTime;
+};
+
+#endif //EFP_UNITTEST22_H
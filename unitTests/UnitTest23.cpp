@@ -0,0 +1,114 @@
+//UnitTest23
+//Test cut-through delivery. Send a superframe of 10 type1 fragments + a type2 fragment to a run to completion receiver
+//in the order 0 1 2 4 3 5 6 7 8 9 type2. The chunks must be contiguous starting at offset 0, fragment 3 and 4 must be delivered
+//as one chunk (10 chunks in total) and all chunks must be delivered before the complete superframe.
+
+#include "UnitTest23.h"
+
+void UnitTest23::sendData(const std::vector<uint8_t> &subPacket) {
+    unitTestFragments.push_back(subPacket);
+}
+
+void UnitTest23::gotChunk(const uint8_t *pData, size_t offset, size_t size) {
+    if (offset != unitTestChunkEnd || !size) {
+        std::cout << "Chunk offset " << unsigned(offset) << " expected " << unsigned(unitTestChunkEnd) << std::endl;
+        unitTestFailed = true;
+        unitTestActive = false;
+        return;
+    }
+    for (size_t x = 0; x < size; x++) {
+        if (pData[x] != (uint8_t) (offset + x)) {
+            unitTestFailed = true;
+            unitTestActive = false;
+            return;
+        }
+    }
+    unitTestChunkEnd += size;
+    unitTestChunks++;
+}
+
+void UnitTest23::gotData(ElasticFrameProtocolReceiver::pFramePtr &packet) {
+    if (packet->mPts != 1001 || packet->mCode != 2 || packet->mBroken) {
+        unitTestFailed = true;
+        unitTestActive = false;
+        return;
+    }
+    if (unitTestChunkEnd != packet->mFrameSize || unitTestChunks != 10) {
+        std::cout << "Got " << signed(unitTestChunks) << " chunks covering " << unsigned(unitTestChunkEnd) << " bytes" << std::endl;
+        unitTestFailed = true;
+        unitTestActive = false;
+        return;
+    }
+    unitTestActive = false;
+    std::cout << "UnitTest " << unsigned(activeUnitTest) << " done." << std::endl;
+}
+
+bool UnitTest23::waitForCompletion() {
+    int breakOut = 0;
+    while (unitTestActive) {
+        //quarter of a second
+        std::this_thread::sleep_for(std::chrono::microseconds(1000 * 250));
+        if (breakOut++ == 10) {
+            std::cout << "waitForCompletion did wait for 5 seconds. fail the test." << std::endl;
+            unitTestFailed = true;
+            unitTestActive = false;
+        }
+    }
+    if (unitTestFailed) {
+        std::cout << "Unit test number: " << unsigned(activeUnitTest) << " Failed." << std::endl;
+        return true;
+    }
+    return false;
+}
+
+bool UnitTest23::startUnitTest() {
+    unitTestFailed = false;
+    unitTestActive = false;
+    ElasticFrameMessages result;
+    std::vector<uint8_t> mydata;
+    uint8_t streamID = 1;
+    myEFPReciever = new (std::nothrow) ElasticFrameProtocolReceiver(50, 0, nullptr, ElasticFrameProtocolReceiver::EFPReceiverMode::RUN_TO_COMPLETION);
+    myEFPPacker = new (std::nothrow) ElasticFrameProtocolSender(MTU);
+    if (myEFPReciever == nullptr || myEFPPacker == nullptr) {
+        if (myEFPReciever) delete myEFPReciever;
+        if (myEFPPacker) delete myEFPPacker;
+        return false;
+    }
+    myEFPPacker->sendCallback = std::bind(&UnitTest23::sendData, this, std::placeholders::_1);
+    myEFPReciever->receiveCallback = std::bind(&UnitTest23::gotData, this, std::placeholders::_1);
+    myEFPReciever->receiveChunkCallback = [this](const uint8_t *pData, size_t offset, size_t size, uint16_t superFrameNo,
+                                                 uint8_t streamID, uint8_t source, ElasticFrameProtocolContext *pCTX) {
+        gotChunk(pData, offset, size);
+    };
+    mydata.resize(((MTU - myEFPPacker->geType1Size()) * 10) + 12);
+    std::generate(mydata.begin(), mydata.end(), [n = 0]() mutable { return n++; });
+    unitTestActive = true;
+    result = myEFPPacker->packAndSend(mydata, ElasticFrameContent::adts, 1001, 1, 2, streamID, NO_FLAGS);
+    if (result != ElasticFrameMessages::noError || unitTestFragments.size() != 11) {
+        std::cout << "Unit test number: " << unsigned(activeUnitTest) << " Failed in the packAndSend method. Error-> " << signed(result)
+                  << std::endl;
+        delete myEFPPacker;
+        delete myEFPReciever;
+        return false;
+    }
+
+    std::swap(unitTestFragments[3], unitTestFragments[4]);
+    for (auto &rFragment: unitTestFragments) {
+        ElasticFrameMessages info = myEFPReciever->receiveFragment(rFragment, 0);
+        if (info != ElasticFrameMessages::noError) {
+            std::cout << "Error-> " << signed(info) << std::endl;
+            unitTestFailed = true;
+            unitTestActive = false;
+        }
+    }
+
+    if (waitForCompletion()) {
+        delete myEFPPacker;
+        delete myEFPReciever;
+        return false;
+    } else {
+        delete myEFPPacker;
+        delete myEFPReciever;
+        return true;
+    }
+}
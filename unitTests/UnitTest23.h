@@ -0,0 +1,26 @@
+#ifndef EFP_UNITTEST23_H
+#define EFP_UNITTEST23_H
+
+#include "../ElasticFrameProtocol.h"
+
+#define MTU 1456 //SRT-max
+
+class UnitTest23 {
+public:
+    bool startUnitTest();
+private:
+    void sendData(const std::vector<uint8_t> &subPacket);
+    void gotData(ElasticFrameProtocolReceiver::pFramePtr &packet);
+    void gotChunk(const uint8_t *pData, size_t offset, size_t size);
+    bool waitForCompletion();
+    ElasticFrameProtocolReceiver *myEFPReciever = nullptr;
+    ElasticFrameProtocolSender *myEFPPacker = nullptr;
+    std::atomic_bool unitTestActive;
+    std::atomic_bool unitTestFailed;
+    int activeUnitTest = 23;
+    std::vector<std::vector<uint8_t>> unitTestFragments;
+    size_t unitTestChunkEnd = 0;
+    int unitTestChunks = 0;
+};
+
+#endif //EFP_UNITTEST23_H
@@ -0,0 +1,124 @@
+//UnitTest24
+//Test the missing ranges of broken superframes.
+//First send a intact superframe. It should have no missing ranges.
+//Then send a superframe of 10 type1 fragments + a type2 fragment and drop type1 fragment 1, 2 and 5.
+//The superframe should be broken and have the missing ranges (1 * fragment size, 2 * fragment size) and (5 * fragment size, fragment size)
+
+#include "UnitTest24.h"
+
+void UnitTest24::sendData(const std::vector<uint8_t> &subPacket) {
+    int packetNumber = unitTestPacketNumberSender++;
+    //The first superframe is only a type2 fragment. Then drop 1, 2 and 5 of the second superframe
+    if (packetNumber == 2 || packetNumber == 3 || packetNumber == 6) {
+        return;
+    }
+    ElasticFrameMessages info = myEFPReciever->receiveFragment(subPacket, 0);
+    if (info != ElasticFrameMessages::noError) {
+        std::cout << "Error-> " << signed(info) << std::endl;
+        unitTestFailed = true;
+        unitTestActive = false;
+    }
+}
+
+void UnitTest24::gotData(ElasticFrameProtocolReceiver::pFramePtr &packet) {
+    size_t lFragmentSize = MTU - myEFPPacker->geType1Size();
+    if (!unitTestPacketNumberReciever++) {
+        if (packet->mBroken || !packet->mMissingRanges.empty()) {
+            unitTestFailed = true;
+            unitTestActive = false;
+        }
+        return;
+    }
+
+    if (!packet->mBroken || packet->mMissingRanges.size() != 2) {
+        unitTestFailed = true;
+        unitTestActive = false;
+        return;
+    }
+    if (packet->mMissingRanges[0].first != lFragmentSize || packet->mMissingRanges[0].second != lFragmentSize * 2 ||
+        packet->mMissingRanges[1].first != lFragmentSize * 5 || packet->mMissingRanges[1].second != lFragmentSize) {
+        std::cout << "Wrong missing ranges" << std::endl;
+        unitTestFailed = true;
+        unitTestActive = false;
+        return;
+    }
+    //All data outside the missing ranges should be intact
+    for (size_t x = 0; x < packet->mFrameSize; x++) {
+        if ((x >= lFragmentSize && x < lFragmentSize * 3) || (x >= lFragmentSize * 5 && x < lFragmentSize * 6)) {
+            continue;
+        }
+        if (packet->pFrameData[x] != (uint8_t) x) {
+            unitTestFailed = true;
+            unitTestActive = false;
+            return;
+        }
+    }
+    unitTestActive = false;
+    std::cout << "UnitTest " << unsigned(activeUnitTest) << " done." << std::endl;
+}
+
+bool UnitTest24::waitForCompletion() {
+    int breakOut = 0;
+    while (unitTestActive) {
+        //quarter of a second
+        std::this_thread::sleep_for(std::chrono::microseconds(1000 * 250));
+        if (breakOut++ == 10) {
+            std::cout << "waitForCompletion did wait for 5 seconds. fail the test." << std::endl;
+            unitTestFailed = true;
+            unitTestActive = false;
+        }
+    }
+    if (unitTestFailed) {
+        std::cout << "Unit test number: " << unsigned(activeUnitTest) << " Failed." << std::endl;
+        return true;
+    }
+    return false;
+}
+
+bool UnitTest24::startUnitTest() {
+    unitTestFailed = false;
+    unitTestActive = false;
+    ElasticFrameMessages result;
+    std::vector<uint8_t> mydata;
+    uint8_t streamID = 1;
+    myEFPReciever = new (std::nothrow) ElasticFrameProtocolReceiver(50, 0);
+    myEFPPacker = new (std::nothrow) ElasticFrameProtocolSender(MTU);
+    if (myEFPReciever == nullptr || myEFPPacker == nullptr) {
+        if (myEFPReciever) delete myEFPReciever;
+        if (myEFPPacker) delete myEFPPacker;
+        return false;
+    }
+    myEFPPacker->sendCallback = std::bind(&UnitTest24::sendData, this, std::placeholders::_1);
+    myEFPReciever->receiveCallback = std::bind(&UnitTest24::gotData, this, std::placeholders::_1);
+    unitTestPacketNumberSender = 0;
+    unitTestPacketNumberReciever = 0;
+    unitTestActive = true;
+
+    mydata.resize(100);
+    std::generate(mydata.begin(), mydata.end(), [n = 0]() mutable { return n++; });
+    result = myEFPPacker->packAndSend(mydata, ElasticFrameContent::adts, 1001, 1, 2, streamID, NO_FLAGS);
+    if (result == ElasticFrameMessages::noError) {
+        //Make sure the first superframe is delivered first
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        mydata.resize(((MTU - myEFPPacker->geType1Size()) * 10) + 12);
+        std::generate(mydata.begin(), mydata.end(), [n = 0]() mutable { return n++; });
+        result = myEFPPacker->packAndSend(mydata, ElasticFrameContent::adts, 1002, 2, 2, streamID, NO_FLAGS);
+    }
+    if (result != ElasticFrameMessages::noError) {
+        std::cout << "Unit test number: " << unsigned(activeUnitTest) << " Failed in the packAndSend method. Error-> " << signed(result)
+                  << std::endl;
+        delete myEFPPacker;
+        delete myEFPReciever;
+        return false;
+    }
+
+    if (waitForCompletion()) {
+        delete myEFPPacker;
+        delete myEFPReciever;
+        return false;
+    } else {
+        delete myEFPPacker;
+        delete myEFPReciever;
+        return true;
+    }
+}
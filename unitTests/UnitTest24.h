@@ -0,0 +1,24 @@
+#ifndef EFP_UNITTEST24_H
+#define EFP_UNITTEST24_H
+
+#include "../ElasticFrameProtocol.h"
+
+#define MTU 1456 //SRT-max
+
+class UnitTest24 {
+public:
+    bool startUnitTest();
+private:
+    void sendData(const std::vector<uint8_t> &subPacket);
+    void gotData(ElasticFrameProtocolReceiver::pFramePtr &packet);
+    bool waitForCompletion();
+    ElasticFrameProtocolReceiver *myEFPReciever = nullptr;
+    ElasticFrameProtocolSender *myEFPPacker = nullptr;
+    std::atomic_bool unitTestActive;
+    std::atomic_bool unitTestFailed;
+    int activeUnitTest = 24;
+    std::atomic_int unitTestPacketNumberSender;
+    std::atomic_int unitTestPacketNumberReciever;
+};
+
+#endif //EFP_UNITTEST24_H
@@ -0,0 +1,134 @@
+//UnitTest25
+//Test the streaming sender (beginSuperFrame/appendData/endSuperFrame).
+//Three superframes are streamed in pieces of 1000 bytes.
+//1. 40 type7 fragments + 100 bytes. Ends with a type2 carrying data. The receiver must grow the superframe.
+//2. 5 type7 fragments + 1440 bytes. The reminder does not fit a type2 so it ends with a type3 and a empty type2.
+//3. Exactly 3 type7 fragments ending with a empty type2. Fed to the receiver out of order.
+//Fragments must be sent before the superframe is ended. All superframes must be delivered intact.
+
+#include "UnitTest25.h"
+
+void UnitTest25::sendData(const std::vector<uint8_t> &subPacket) {
+    unitTestPacketNumberSender++;
+    fragments.push_back(subPacket);
+}
+
+void UnitTest25::gotData(ElasticFrameProtocolReceiver::pFramePtr &packet) {
+    int frameNumber = unitTestPacketNumberReciever++;
+    if (frameNumber >= (int) frameSizes.size() || packet->mBroken || packet->mFrameSize != frameSizes[frameNumber] ||
+        packet->mPts != (uint64_t) 1000 + frameNumber || packet->mCode != 2 || packet->mDataContent != ElasticFrameContent::h264) {
+        std::cout << "Wrong superframe delivered" << std::endl;
+        unitTestFailed = true;
+        unitTestActive = false;
+        return;
+    }
+    for (size_t x = 0; x < packet->mFrameSize; x++) {
+        if (packet->pFrameData[x] != (uint8_t) (x + frameNumber)) {
+            std::cout << "Data mismatch" << std::endl;
+            unitTestFailed = true;
+            unitTestActive = false;
+            return;
+        }
+    }
+    if (frameNumber == 2) {
+        unitTestActive = false;
+        std::cout << "UnitTest " << unsigned(activeUnitTest) << " done." << std::endl;
+    }
+}
+
+bool UnitTest25::waitForCompletion() {
+    int breakOut = 0;
+    while (unitTestActive) {
+        //quarter of a second
+        std::this_thread::sleep_for(std::chrono::microseconds(1000 * 250));
+        if (breakOut++ == 10) {
+            std::cout << "waitForCompletion did wait for 5 seconds. fail the test." << std::endl;
+            unitTestFailed = true;
+            unitTestActive = false;
+        }
+    }
+    if (unitTestFailed) {
+        std::cout << "Unit test number: " << unsigned(activeUnitTest) << " Failed." << std::endl;
+        return true;
+    }
+    return false;
+}
+
+bool UnitTest25::startUnitTest() {
+    unitTestFailed = false;
+    unitTestActive = false;
+    ElasticFrameMessages result = ElasticFrameMessages::noError;
+    std::vector<uint8_t> mydata;
+    uint8_t streamID = 1;
+    myEFPReciever = new (std::nothrow) ElasticFrameProtocolReceiver(50, 0, nullptr, ElasticFrameProtocolReceiver::EFPReceiverMode::RUN_TO_COMPLETION);
+    myEFPPacker = new (std::nothrow) ElasticFrameProtocolSender(MTU);
+    if (myEFPReciever == nullptr || myEFPPacker == nullptr) {
+        if (myEFPReciever) delete myEFPReciever;
+        if (myEFPPacker) delete myEFPPacker;
+        return false;
+    }
+    myEFPPacker->sendCallback = std::bind(&UnitTest25::sendData, this, std::placeholders::_1);
+    myEFPReciever->receiveCallback = std::bind(&UnitTest25::gotData, this, std::placeholders::_1);
+    unitTestPacketNumberSender = 0;
+    unitTestPacketNumberReciever = 0;
+    unitTestActive = true;
+
+    size_t fragmentSize = MTU - myEFPPacker->geType1Size();
+    frameSizes = {fragmentSize * 40 + 100, fragmentSize * 5 + 1440, fragmentSize * 3};
+
+    //appendData without beginSuperFrame must fail
+    if (myEFPPacker->appendData(mydata.data(), 0) != ElasticFrameMessages::noSuperFrameStarted) {
+        std::cout << "appendData without beginSuperFrame did not fail" << std::endl;
+        delete myEFPPacker;
+        delete myEFPReciever;
+        return false;
+    }
+
+    for (int frame = 0; frame < 3 && result == ElasticFrameMessages::noError; frame++) {
+        mydata.resize(frameSizes[frame]);
+        std::generate(mydata.begin(), mydata.end(), [n = frame]() mutable { return n++; });
+        fragments.clear();
+        result = myEFPPacker->beginSuperFrame(ElasticFrameContent::h264, streamID, NO_FLAGS);
+        for (size_t pos = 0; pos < mydata.size() && result == ElasticFrameMessages::noError; pos += 1000) {
+            result = myEFPPacker->appendData(mydata.data() + pos, std::min((size_t) 1000, mydata.size() - pos));
+            //After two appends the first fragment must be sent
+            if (pos == 1000 && fragments.size() != 1) {
+                std::cout << "Fragment not sent before the end of the superframe" << std::endl;
+                unitTestFailed = true;
+            }
+        }
+        if (result == ElasticFrameMessages::noError) {
+            result = myEFPPacker->endSuperFrame(1000 + frame, 1000 + frame, 2);
+        }
+        if (frame == 2) {
+            //Feed type7 fragment 2 first then 1, the type2 and last type7 fragment 0
+            std::swap(fragments[0], fragments[2]);
+            std::swap(fragments[2], fragments[3]);
+        }
+        for (auto &rFragment: fragments) {
+            ElasticFrameMessages info = myEFPReciever->receiveFragment(rFragment, 0);
+            if (info != ElasticFrameMessages::noError) {
+                std::cout << "Error-> " << signed(info) << std::endl;
+                unitTestFailed = true;
+                unitTestActive = false;
+            }
+        }
+    }
+    if (result != ElasticFrameMessages::noError) {
+        std::cout << "Unit test number: " << unsigned(activeUnitTest) << " Failed in the streaming sender. Error-> " << signed(result)
+                  << std::endl;
+        delete myEFPPacker;
+        delete myEFPReciever;
+        return false;
+    }
+
+    if (waitForCompletion()) {
+        delete myEFPPacker;
+        delete myEFPReciever;
+        return false;
+    } else {
+        delete myEFPPacker;
+        delete myEFPReciever;
+        return true;
+    }
+}
@@ -0,0 +1,26 @@
+#ifndef EFP_UNITTEST25_H
+#define EFP_UNITTEST25_H
+
+#include "../ElasticFrameProtocol.h"
+
+#define MTU 1456 //SRT-max
+
+class UnitTest25 {
+public:
+    bool startUnitTest();
+private:
+    void sendData(const std::vector<uint8_t> &subPacket);
+    void gotData(ElasticFrameProtocolReceiver::pFramePtr &packet);
+    bool waitForCompletion();
+    ElasticFrameProtocolReceiver *myEFPReciever = nullptr;
+    ElasticFrameProtocolSender *myEFPPacker = nullptr;
+    std::atomic_bool unitTestActive;
+    std::atomic_bool unitTestFailed;
+    int activeUnitTest = 25;
+    std::atomic_int unitTestPacketNumberSender;
+    std::atomic_int unitTestPacketNumberReciever;
+    std::vector<std::vector<uint8_t>> fragments;
+    std::vector<size_t> frameSizes;
+};
+
+#endif //EFP_UNITTEST25_H
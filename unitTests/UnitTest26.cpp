@@ -0,0 +1,124 @@
+//UnitTest26
+//Test timeout processing in run to completion mode.
+//Send a superframe and drop the last fragment. No more fragments are received.
+//nextDeadline should tell when to call processTimeouts and then the broken superframe should be delivered.
+//When nothing is pending nextDeadline should return -1. processTimeouts must be refused by a threaded receiver.
+
+#include "UnitTest26.h"
+
+void UnitTest26::sendData(const std::vector<uint8_t> &subPacket) {
+    //Drop the type2 fragment
+    if ((subPacket[0] & 0x0f) == 2) {
+        return;
+    }
+    unitTestPacketNumberSender++;
+    ElasticFrameMessages info = myEFPReciever->receiveFragment(subPacket, 0);
+    if (info != ElasticFrameMessages::noError) {
+        std::cout << "Error-> " << signed(info) << std::endl;
+        unitTestFailed = true;
+        unitTestActive = false;
+    }
+}
+
+void UnitTest26::gotData(ElasticFrameProtocolReceiver::pFramePtr &packet) {
+    unitTestPacketNumberReciever++;
+    if (!packet->mBroken) {
+        unitTestFailed = true;
+        unitTestActive = false;
+        return;
+    }
+    for (size_t x = 0; x < packet->mFrameSize; x++) {
+        if (packet->pFrameData[x] != (uint8_t) x) {
+            unitTestFailed = true;
+            unitTestActive = false;
+            return;
+        }
+    }
+    unitTestActive = false;
+}
+
+bool UnitTest26::waitForCompletion() {
+    int breakOut = 0;
+    while (unitTestActive) {
+        //Arm a 'timer' using the deadline from the receiver
+        int64_t deadline = myEFPReciever->nextDeadline();
+        if (deadline < 0 || deadline > 50 * 1000) {
+            std::cout << "Unexpected deadline " << deadline << std::endl;
+            unitTestFailed = true;
+            unitTestActive = false;
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(deadline));
+        myEFPReciever->processTimeouts();
+        if (breakOut++ == 10) {
+            std::cout << "processTimeouts did not deliver the superframe. fail the test." << std::endl;
+            unitTestFailed = true;
+            unitTestActive = false;
+        }
+    }
+    if (!unitTestFailed && myEFPReciever->nextDeadline() != -1) {
+        std::cout << "Deadline when nothing is pending" << std::endl;
+        unitTestFailed = true;
+    }
+    if (unitTestFailed) {
+        std::cout << "Unit test number: " << unsigned(activeUnitTest) << " Failed." << std::endl;
+        return true;
+    }
+    std::cout << "UnitTest " << unsigned(activeUnitTest) << " done." << std::endl;
+    return false;
+}
+
+bool UnitTest26::startUnitTest() {
+    unitTestFailed = false;
+    unitTestActive = false;
+    ElasticFrameMessages result;
+
+    ElasticFrameProtocolReceiver threadedReceiver(50, 0);
+    if (threadedReceiver.processTimeouts() != ElasticFrameMessages::notImplemented) {
+        std::cout << "processTimeouts accepted in threaded mode" << std::endl;
+        return false;
+    }
+
+    std::vector<uint8_t> mydata;
+    uint8_t streamID = 1;
+    myEFPReciever = new (std::nothrow) ElasticFrameProtocolReceiver(50, 0, nullptr, ElasticFrameProtocolReceiver::EFPReceiverMode::RUN_TO_COMPLETION);
+    myEFPPacker = new (std::nothrow) ElasticFrameProtocolSender(MTU);
+    if (myEFPReciever == nullptr || myEFPPacker == nullptr) {
+        if (myEFPReciever) delete myEFPReciever;
+        if (myEFPPacker) delete myEFPPacker;
+        return false;
+    }
+    myEFPPacker->sendCallback = std::bind(&UnitTest26::sendData, this, std::placeholders::_1);
+    myEFPReciever->receiveCallback = std::bind(&UnitTest26::gotData, this, std::placeholders::_1);
+    unitTestPacketNumberSender = 0;
+    unitTestPacketNumberReciever = 0;
+    unitTestActive = true;
+
+    if (myEFPReciever->nextDeadline() != -1) {
+        std::cout << "Deadline when nothing is pending" << std::endl;
+        delete myEFPPacker;
+        delete myEFPReciever;
+        return false;
+    }
+
+    mydata.resize(((MTU - myEFPPacker->geType1Size()) * 3) + 100);
+    std::generate(mydata.begin(), mydata.end(), [n = 0]() mutable { return n++; });
+    result = myEFPPacker->packAndSend(mydata, ElasticFrameContent::adts, 1001, 1, 2, streamID, NO_FLAGS);
+    if (result != ElasticFrameMessages::noError) {
+        std::cout << "Unit test number: " << unsigned(activeUnitTest) << " Failed in the packAndSend method. Error-> " << signed(result)
+                  << std::endl;
+        delete myEFPPacker;
+        delete myEFPReciever;
+        return false;
+    }
+
+    if (waitForCompletion()) {
+        delete myEFPPacker;
+        delete myEFPReciever;
+        return false;
+    } else {
+        delete myEFPPacker;
+        delete myEFPReciever;
+        return true;
+    }
+}
@@ -0,0 +1,120 @@
+//UnitTest27
+//Test the pull mode receiver.
+//Send 5 superframes. Wait for the readiness file descriptor and pull the superframes in batches.
+//The superframes should be pulled in order and intact. When all superframes are pulled the descriptor should not be readable.
+
+#include "UnitTest27.h"
+
+#ifdef __linux__
+#include <poll.h>
+#endif
+
+void UnitTest27::sendData(const std::vector<uint8_t> &subPacket) {
+    unitTestPacketNumberSender++;
+    ElasticFrameMessages info = myEFPReciever->receiveFragment(subPacket, 0);
+    if (info != ElasticFrameMessages::noError) {
+        std::cout << "Error-> " << signed(info) << std::endl;
+        unitTestFailed = true;
+    }
+}
+
+bool UnitTest27::checkFrame(ElasticFrameProtocolReceiver::pFramePtr &packet) {
+    int frameNumber = unitTestPacketNumberReciever++;
+    if (packet->mBroken || packet->mPts != (uint64_t) 1000 + frameNumber || packet->mFrameSize != (size_t) 1000 + frameNumber * 1000) {
+        return false;
+    }
+    for (size_t x = 0; x < packet->mFrameSize; x++) {
+        if (packet->pFrameData[x] != (uint8_t) x) {
+            return false;
+        }
+    }
+    return true;
+}
+
+//Wait for superframes to pull. Returns false if the wait timed out
+bool UnitTest27::waitForReadiness() {
+#ifdef __linux__
+    struct pollfd lPollFd = {myEFPReciever->getReadinessFd(), POLLIN, 0};
+    return poll(&lPollFd, 1, 2000) == 1;
+#else
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    return true;
+#endif
+}
+
+bool UnitTest27::startUnitTest() {
+    unitTestFailed = false;
+    ElasticFrameMessages result;
+    std::vector<uint8_t> mydata;
+    uint8_t streamID = 1;
+    myEFPReciever = new (std::nothrow) ElasticFrameProtocolReceiver(50, 0, nullptr, ElasticFrameProtocolReceiver::EFPReceiverMode::PULL);
+    myEFPPacker = new (std::nothrow) ElasticFrameProtocolSender(MTU);
+    if (myEFPReciever == nullptr || myEFPPacker == nullptr) {
+        if (myEFPReciever) delete myEFPReciever;
+        if (myEFPPacker) delete myEFPPacker;
+        return false;
+    }
+#ifdef __linux__
+    if (myEFPReciever->getReadinessFd() < 0) {
+        std::cout << "No readiness file descriptor" << std::endl;
+        delete myEFPPacker;
+        delete myEFPReciever;
+        return false;
+    }
+#endif
+    myEFPPacker->sendCallback = std::bind(&UnitTest27::sendData, this, std::placeholders::_1);
+    unitTestPacketNumberSender = 0;
+    unitTestPacketNumberReciever = 0;
+
+    for (int frame = 0; frame < 5; frame++) {
+        mydata.resize(1000 + frame * 1000);
+        std::generate(mydata.begin(), mydata.end(), [n = 0]() mutable { return n++; });
+        result = myEFPPacker->packAndSend(mydata, ElasticFrameContent::adts, 1000 + frame, 1000 + frame, 2, streamID, NO_FLAGS);
+        if (result != ElasticFrameMessages::noError) {
+            std::cout << "Unit test number: " << unsigned(activeUnitTest) << " Failed in the packAndSend method. Error-> " << signed(result)
+                      << std::endl;
+            delete myEFPPacker;
+            delete myEFPReciever;
+            return false;
+        }
+    }
+
+    std::vector<ElasticFrameProtocolReceiver::pFramePtr> frames;
+    while (!unitTestFailed && unitTestPacketNumberReciever < 5) {
+        if (!waitForReadiness()) {
+            std::cout << "The readiness file descriptor was never readable" << std::endl;
+            unitTestFailed = true;
+            break;
+        }
+        frames.clear();
+        myEFPReciever->popFrames(frames, 2);
+        for (auto &rFrame: frames) {
+            if (!checkFrame(rFrame)) {
+                std::cout << "Wrong superframe pulled" << std::endl;
+                unitTestFailed = true;
+            }
+        }
+    }
+
+#ifdef __linux__
+    struct pollfd lPollFd = {myEFPReciever->getReadinessFd(), POLLIN, 0};
+    if (!unitTestFailed && poll(&lPollFd, 1, 0) != 0) {
+        std::cout << "The readiness file descriptor is readable when there is nothing to pull" << std::endl;
+        unitTestFailed = true;
+    }
+#endif
+    ElasticFrameProtocolReceiver::pFramePtr frame;
+    if (!unitTestFailed && myEFPReciever->tryPopFrame(frame)) {
+        std::cout << "Pulled a superframe that was never sent" << std::endl;
+        unitTestFailed = true;
+    }
+
+    delete myEFPPacker;
+    delete myEFPReciever;
+    if (unitTestFailed) {
+        std::cout << "Unit test number: " << unsigned(activeUnitTest) << " Failed." << std::endl;
+        return false;
+    }
+    std::cout << "UnitTest " << unsigned(activeUnitTest) << " done." << std::endl;
+    return true;
+}
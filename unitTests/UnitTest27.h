@@ -0,0 +1,24 @@
+#ifndef EFP_UNITTEST27_H
+#define EFP_UNITTEST27_H
+
+#include "../ElasticFrameProtocol.h"
+
+#define MTU 1456 //SRT-max
+
+class UnitTest27 {
+public:
+    bool startUnitTest();
+private:
+    void sendData(const std::vector<uint8_t> &subPacket);
+    bool checkFrame(ElasticFrameProtocolReceiver::pFramePtr &packet);
+    bool waitForReadiness();
+    ElasticFrameProtocolReceiver *myEFPReciever = nullptr;
+    ElasticFrameProtocolSender *myEFPPacker = nullptr;
+    std::atomic_bool unitTestActive;
+    std::atomic_bool unitTestFailed;
+    int activeUnitTest = 27;
+    std::atomic_int unitTestPacketNumberSender;
+    std::atomic_int unitTestPacketNumberReciever;
+};
+
+#endif //EFP_UNITTEST27_H
@@ -0,0 +1,183 @@
+//UnitTest28
+//Test the coroutine API (Only built if EFP_COROUTINES is defined).
+//A producer coroutine sends 10 superframes using co_await send while there is backpressure. Nothing should be sent
+//until the backpressure is cleared. The last 5 superframes are small and carried by a single fragment.
+//The consumer waiting when the backpressure is cleared must be handed to the executor by receiveFragment.
+//Without an executor a consumer is resumed directly by receiveFragment. The consumer receives a superframe and sends
+//the next one to the same receiver from within the coroutine. Must not deadlock.
+//A consumer coroutine receives the superframes using co_await nextFrame from a pull mode receiver.
+//The consumer is resumed by a executor run by the test thread. All superframes should arrive in order and intact.
+
+#include "UnitTest28.h"
+
+#ifdef EFP_COROUTINES
+
+void UnitTest28::sendData(const std::vector<uint8_t> &subPacket) {
+    unitTestPacketNumberSender++;
+    ElasticFrameMessages info = myEFPReciever->receiveFragment(subPacket, 0);
+    if (info != ElasticFrameMessages::noError) {
+        std::cout << "Error-> " << signed(info) << std::endl;
+        unitTestFailed = true;
+    }
+}
+
+size_t UnitTest28::frameSize(int frameNumber) {
+    if (frameNumber < 5) {
+        return 1000 + frameNumber * 1000;
+    }
+    return 100 + frameNumber;
+}
+
+UnitTest28::Task UnitTest28::consumer() {
+    for (int frameNumber = 0; frameNumber < 10; frameNumber++) {
+        ElasticFrameProtocolReceiver::pFramePtr packet = co_await myEFPReciever->nextFrame();
+        if (!packet || packet->mBroken || packet->mPts != (uint64_t) 1000 + frameNumber ||
+            packet->mFrameSize != frameSize(frameNumber)) {
+            unitTestFailed = true;
+            co_return;
+        }
+        for (size_t x = 0; x < packet->mFrameSize; x++) {
+            if (packet->pFrameData[x] != (uint8_t) x) {
+                unitTestFailed = true;
+                co_return;
+            }
+        }
+        unitTestPacketNumberReciever++;
+    }
+}
+
+UnitTest28::Task UnitTest28::producer() {
+    std::vector<uint8_t> mydata;
+    for (int frame = 0; frame < 10; frame++) {
+        mydata.resize(frameSize(frame));
+        std::generate(mydata.begin(), mydata.end(), [n = 0]() mutable { return n++; });
+        ElasticFrameMessages result = co_await myEFPPacker->send(mydata, ElasticFrameContent::adts, 1000 + frame, 1000 + frame, 2, 1, NO_FLAGS);
+        if (result != ElasticFrameMessages::noError) {
+            unitTestFailed = true;
+        }
+    }
+    producerDone = true;
+}
+
+UnitTest28::Task UnitTest28::echoConsumer() {
+    for (int frameNumber = 0; frameNumber < 10; frameNumber++) {
+        ElasticFrameProtocolReceiver::pFramePtr packet = co_await myEFPReciever->nextFrame();
+        if (!packet || packet->mBroken || packet->mPts != (uint64_t) 2000 + frameNumber ||
+            myEFPReciever->nextDeadline() != -1) {
+            unitTestFailed = true;
+            break;
+        }
+        unitTestPacketNumberReciever++;
+        if (frameNumber < 9 &&
+            myEFPReciever->receiveFragment(echoFragments[frameNumber + 1], 0) != ElasticFrameMessages::noError) {
+            unitTestFailed = true;
+            break;
+        }
+    }
+    echoDone = true;
+}
+
+bool UnitTest28::echoTest() {
+    echoDone = false;
+    unitTestPacketNumberReciever = 0;
+    myEFPReciever = new (std::nothrow) ElasticFrameProtocolReceiver(50, 0, nullptr, ElasticFrameProtocolReceiver::EFPReceiverMode::PULL);
+    myEFPPacker = new (std::nothrow) ElasticFrameProtocolSender(MTU);
+    if (myEFPReciever == nullptr || myEFPPacker == nullptr) {
+        if (myEFPReciever) delete myEFPReciever;
+        if (myEFPPacker) delete myEFPPacker;
+        return false;
+    }
+    //Single fragment superframes fed to the receiver by the consumer
+    echoFragments.clear();
+    myEFPPacker->sendCallback = [this](const std::vector<uint8_t> &rSubPacket, uint8_t, ElasticFrameProtocolContext *) {
+        echoFragments.push_back(rSubPacket);
+    };
+    std::vector<uint8_t> mydata(100);
+    for (uint64_t pts = 2000; pts < 2010; pts++) {
+        myEFPPacker->packAndSend(mydata, ElasticFrameContent::adts, pts, pts, 2, 1, NO_FLAGS);
+    }
+
+    echoConsumer();
+    if (myEFPReciever->receiveFragment(echoFragments[0], 0) != ElasticFrameMessages::noError) {
+        unitTestFailed = true;
+    }
+    for (int x = 0; x < 200 && !echoDone; x++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    bool passed = echoDone && !unitTestFailed && unitTestPacketNumberReciever == 10;
+    if (!echoDone) {
+        //Can't delete the receiver the coroutine is waiting for
+        return false;
+    }
+    delete myEFPPacker;
+    delete myEFPReciever;
+    if (!passed) {
+        std::cout << "The consumer calling the receiver failed" << std::endl;
+    }
+    return passed;
+}
+
+bool UnitTest28::startUnitTest() {
+    unitTestFailed = false;
+    producerDone = false;
+    myEFPReciever = new (std::nothrow) ElasticFrameProtocolReceiver(50, 0, nullptr, ElasticFrameProtocolReceiver::EFPReceiverMode::PULL);
+    myEFPPacker = new (std::nothrow) ElasticFrameProtocolSender(MTU);
+    if (myEFPReciever == nullptr || myEFPPacker == nullptr) {
+        if (myEFPReciever) delete myEFPReciever;
+        if (myEFPPacker) delete myEFPPacker;
+        return false;
+    }
+    myEFPPacker->sendCallback = std::bind(&UnitTest28::sendData, this, std::placeholders::_1);
+    myEFPReciever->coroutineExecutor = [this](std::coroutine_handle<> handle) {
+        std::lock_guard<std::mutex> lock(executorMtx);
+        executorQueue.push_back(handle);
+    };
+    unitTestPacketNumberSender = 0;
+    unitTestPacketNumberReciever = 0;
+
+    consumer();
+    myEFPPacker->setBackpressure(true);
+    producer();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    if (unitTestPacketNumberSender || producerDone) {
+        std::cout << "Data sent while there is backpressure" << std::endl;
+        unitTestFailed = true;
+    }
+    myEFPPacker->setBackpressure(false);
+    if (!producerDone) {
+        std::cout << "The producer was not resumed" << std::endl;
+        unitTestFailed = true;
+    }
+    {
+        std::lock_guard<std::mutex> lock(executorMtx);
+        if (executorQueue.empty()) {
+            std::cout << "The consumer was not resumed by receiveFragment" << std::endl;
+            unitTestFailed = true;
+        }
+    }
+
+    //Run the executor for max 2 seconds
+    for (int x = 0; x < 200 && !unitTestFailed && unitTestPacketNumberReciever < 10; x++) {
+        std::deque<std::coroutine_handle<>> handles;
+        {
+            std::lock_guard<std::mutex> lock(executorMtx);
+            handles.swap(executorQueue);
+        }
+        for (auto &rHandle: handles) {
+            rHandle.resume();
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    //Make sure nothing references the coroutines when the receiver is deleted
+    delete myEFPPacker;
+    delete myEFPReciever;
+    if (unitTestFailed || unitTestPacketNumberReciever != 10 || !echoTest()) {
+        std::cout << "Unit test number: " << unsigned(activeUnitTest) << " Failed." << std::endl;
+        return false;
+    }
+    std::cout << "UnitTest " << unsigned(activeUnitTest) << " done." << std::endl;
+    return true;
+}
+
+#endif
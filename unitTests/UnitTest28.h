@@ -0,0 +1,45 @@
+#ifndef EFP_UNITTEST28_H
+#define EFP_UNITTEST28_H
+
+#ifdef EFP_COROUTINES
+
+#include "../ElasticFrameProtocol.h"
+
+#define MTU 1456 //SRT-max
+
+class UnitTest28 {
+public:
+    bool startUnitTest();
+private:
+    //Fire and forget coroutine
+    struct Task {
+        struct promise_type {
+            Task get_return_object() { return {}; }
+            std::suspend_never initial_suspend() { return {}; }
+            std::suspend_never final_suspend() noexcept { return {}; }
+            void return_void() {}
+            void unhandled_exception() { std::terminate(); }
+        };
+    };
+    size_t frameSize(int frameNumber);
+    Task consumer();
+    Task producer();
+    Task echoConsumer();
+    bool echoTest();
+    void sendData(const std::vector<uint8_t> &subPacket);
+    ElasticFrameProtocolReceiver *myEFPReciever = nullptr;
+    ElasticFrameProtocolSender *myEFPPacker = nullptr;
+    std::atomic_bool unitTestFailed;
+    int activeUnitTest = 28;
+    std::atomic_int unitTestPacketNumberSender;
+    std::atomic_int unitTestPacketNumberReciever;
+    std::atomic_bool producerDone;
+    std::atomic_bool echoDone;
+    std::vector<std::vector<uint8_t>> echoFragments;
+    std::mutex executorMtx;
+    std::deque<std::coroutine_handle<>> executorQueue;
+};
+
+#endif
+
+#endif //EFP_UNITTEST28_H
@@ -0,0 +1,113 @@
+//UnitTest29
+//Test the batch delivery callback.
+//Send 20 superframes as fast as possible. The first batch callback is blocking for a while so the superframes
+//queue up and the next callback should get more than one superframe.
+//All superframes should be delivered in order and intact.
+
+#include "UnitTest29.h"
+
+void UnitTest29::sendData(const std::vector<uint8_t> &subPacket) {
+    ElasticFrameMessages info = myEFPReciever->receiveFragment(subPacket, 0);
+    if (info != ElasticFrameMessages::noError) {
+        std::cout << "Error-> " << signed(info) << std::endl;
+        unitTestFailed = true;
+        unitTestActive = false;
+    }
+}
+
+void UnitTest29::gotData(std::vector<ElasticFrameProtocolReceiver::pFramePtr> &packets) {
+    if (!batches++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+    if ((int) packets.size() > largestBatch) {
+        largestBatch = (int) packets.size();
+    }
+    for (auto &rPacket: packets) {
+        int frameNumber = unitTestPacketNumberReciever++;
+        if (rPacket->mBroken || rPacket->mPts != (uint64_t) 1000 + frameNumber || rPacket->mFrameSize != (size_t) 100 + frameNumber) {
+            std::cout << "Wrong superframe delivered" << std::endl;
+            unitTestFailed = true;
+            unitTestActive = false;
+            return;
+        }
+        for (size_t x = 0; x < rPacket->mFrameSize; x++) {
+            if (rPacket->pFrameData[x] != (uint8_t) x) {
+                unitTestFailed = true;
+                unitTestActive = false;
+                return;
+            }
+        }
+    }
+    if (unitTestPacketNumberReciever == 20) {
+        if (largestBatch < 2) {
+            std::cout << "Superframes not delivered in batches" << std::endl;
+            unitTestFailed = true;
+        } else {
+            std::cout << "UnitTest " << unsigned(activeUnitTest) << " done." << std::endl;
+        }
+        unitTestActive = false;
+    }
+}
+
+bool UnitTest29::waitForCompletion() {
+    int breakOut = 0;
+    while (unitTestActive) {
+        //quarter of a second
+        std::this_thread::sleep_for(std::chrono::microseconds(1000 * 250));
+        if (breakOut++ == 10) {
+            std::cout << "waitForCompletion did wait for 5 seconds. fail the test." << std::endl;
+            unitTestFailed = true;
+            unitTestActive = false;
+        }
+    }
+    if (unitTestFailed) {
+        std::cout << "Unit test number: " << unsigned(activeUnitTest) << " Failed." << std::endl;
+        return true;
+    }
+    return false;
+}
+
+bool UnitTest29::startUnitTest() {
+    unitTestFailed = false;
+    unitTestActive = false;
+    ElasticFrameMessages result = ElasticFrameMessages::noError;
+    std::vector<uint8_t> mydata;
+    uint8_t streamID = 1;
+    myEFPReciever = new (std::nothrow) ElasticFrameProtocolReceiver(50, 0);
+    myEFPPacker = new (std::nothrow) ElasticFrameProtocolSender(MTU);
+    if (myEFPReciever == nullptr || myEFPPacker == nullptr) {
+        if (myEFPReciever) delete myEFPReciever;
+        if (myEFPPacker) delete myEFPPacker;
+        return false;
+    }
+    myEFPPacker->sendCallback = std::bind(&UnitTest29::sendData, this, std::placeholders::_1);
+    myEFPReciever->receiveBatchCallback = std::bind(&UnitTest29::gotData, this, std::placeholders::_1);
+    unitTestPacketNumberSender = 0;
+    unitTestPacketNumberReciever = 0;
+    batches = 0;
+    largestBatch = 0;
+    unitTestActive = true;
+
+    for (int frame = 0; frame < 20 && result == ElasticFrameMessages::noError; frame++) {
+        mydata.resize(100 + frame);
+        std::generate(mydata.begin(), mydata.end(), [n = 0]() mutable { return n++; });
+        result = myEFPPacker->packAndSend(mydata, ElasticFrameContent::adts, 1000 + frame, 1000 + frame, 2, streamID, NO_FLAGS);
+    }
+    if (result != ElasticFrameMessages::noError) {
+        std::cout << "Unit test number: " << unsigned(activeUnitTest) << " Failed in the packAndSend method. Error-> " << signed(result)
+                  << std::endl;
+        delete myEFPPacker;
+        delete myEFPReciever;
+        return false;
+    }
+
+    if (waitForCompletion()) {
+        delete myEFPPacker;
+        delete myEFPReciever;
+        return false;
+    } else {
+        delete myEFPPacker;
+        delete myEFPReciever;
+        return true;
+    }
+}
@@ -0,0 +1,26 @@
+#ifndef EFP_UNITTEST29_H
+#define EFP_UNITTEST29_H
+
+#include "../ElasticFrameProtocol.h"
+
+#define MTU 1456 //SRT-max
+
+class UnitTest29 {
+public:
+    bool startUnitTest();
+private:
+    void sendData(const std::vector<uint8_t> &subPacket);
+    void gotData(std::vector<ElasticFrameProtocolReceiver::pFramePtr> &packets);
+    bool waitForCompletion();
+    ElasticFrameProtocolReceiver *myEFPReciever = nullptr;
+    ElasticFrameProtocolSender *myEFPPacker = nullptr;
+    std::atomic_bool unitTestActive;
+    std::atomic_bool unitTestFailed;
+    int activeUnitTest = 29;
+    std::atomic_int unitTestPacketNumberSender;
+    std::atomic_int unitTestPacketNumberReciever;
+    std::atomic_int batches;
+    std::atomic_int largestBatch;
+};
+
+#endif //EFP_UNITTEST29_H
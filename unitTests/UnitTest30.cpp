@@ -0,0 +1,121 @@
+//UnitTest30
+//Test per stream delivery lanes.
+//Stream 1 has its own lane where the consumer blocks for 500ms on the first superframe.
+//Stream 2 is delivered by the receiveCallback. All 5 superframes of stream 2 must be delivered while the consumer
+//of stream 1 is blocked. Then both superframes of stream 1 must be delivered in order.
+
+#include "UnitTest30.h"
+
+void UnitTest30::sendData(const std::vector<uint8_t> &subPacket) {
+    ElasticFrameMessages info = myEFPReciever->receiveFragment(subPacket, 0);
+    if (info != ElasticFrameMessages::noError) {
+        std::cout << "Error-> " << signed(info) << std::endl;
+        unitTestFailed = true;
+        unitTestActive = false;
+    }
+}
+
+void UnitTest30::gotSlowStreamData(ElasticFrameProtocolReceiver::pFramePtr &packet) {
+    int frameNumber = slowStreamPackets++;
+    if (packet->mStreamID != 1 || packet->mPts != (uint64_t) 1000 + frameNumber) {
+        std::cout << "Wrong superframe in the lane" << std::endl;
+        unitTestFailed = true;
+        unitTestActive = false;
+        return;
+    }
+    if (!frameNumber) {
+        slowStreamBlocked = true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        slowStreamBlocked = false;
+        if (unitTestPacketNumberReciever != 5) {
+            std::cout << "Stream 2 was stalled by stream 1" << std::endl;
+            unitTestFailed = true;
+            unitTestActive = false;
+        }
+        return;
+    }
+    unitTestActive = false;
+    std::cout << "UnitTest " << unsigned(activeUnitTest) << " done." << std::endl;
+}
+
+void UnitTest30::gotData(ElasticFrameProtocolReceiver::pFramePtr &packet) {
+    int frameNumber = unitTestPacketNumberReciever++;
+    if (packet->mStreamID != 2 || packet->mPts != (uint64_t) 2000 + frameNumber) {
+        std::cout << "Wrong superframe delivered" << std::endl;
+        unitTestFailed = true;
+        unitTestActive = false;
+    }
+}
+
+bool UnitTest30::waitForCompletion() {
+    int breakOut = 0;
+    while (unitTestActive) {
+        //quarter of a second
+        std::this_thread::sleep_for(std::chrono::microseconds(1000 * 250));
+        if (breakOut++ == 10) {
+            std::cout << "waitForCompletion did wait for 5 seconds. fail the test." << std::endl;
+            unitTestFailed = true;
+            unitTestActive = false;
+        }
+    }
+    if (unitTestFailed) {
+        std::cout << "Unit test number: " << unsigned(activeUnitTest) << " Failed." << std::endl;
+        return true;
+    }
+    return false;
+}
+
+bool UnitTest30::startUnitTest() {
+    unitTestFailed = false;
+    unitTestActive = false;
+    ElasticFrameMessages result;
+    std::vector<uint8_t> mydata;
+    myEFPReciever = new (std::nothrow) ElasticFrameProtocolReceiver(50, 0);
+    myEFPPacker = new (std::nothrow) ElasticFrameProtocolSender(MTU);
+    if (myEFPReciever == nullptr || myEFPPacker == nullptr) {
+        if (myEFPReciever) delete myEFPReciever;
+        if (myEFPPacker) delete myEFPPacker;
+        return false;
+    }
+    myEFPPacker->sendCallback = std::bind(&UnitTest30::sendData, this, std::placeholders::_1);
+    myEFPReciever->receiveCallback = std::bind(&UnitTest30::gotData, this, std::placeholders::_1);
+    result = myEFPReciever->setStreamCallback(1, std::bind(&UnitTest30::gotSlowStreamData, this, std::placeholders::_1));
+    unitTestPacketNumberSender = 0;
+    unitTestPacketNumberReciever = 0;
+    slowStreamPackets = 0;
+    slowStreamBlocked = false;
+    unitTestActive = true;
+
+    mydata.resize(1000);
+    std::generate(mydata.begin(), mydata.end(), [n = 0]() mutable { return n++; });
+    if (result == ElasticFrameMessages::noError) {
+        result = myEFPPacker->packAndSend(mydata, ElasticFrameContent::adts, 1000, 1000, 2, 1, NO_FLAGS);
+    }
+    //Make sure the lane is blocked before sending stream 2
+    for (int x = 0; x < 100 && !slowStreamBlocked; x++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    for (int frame = 0; frame < 5 && result == ElasticFrameMessages::noError; frame++) {
+        result = myEFPPacker->packAndSend(mydata, ElasticFrameContent::adts, 2000 + frame, 2000 + frame, 2, 2, NO_FLAGS);
+    }
+    if (result == ElasticFrameMessages::noError) {
+        result = myEFPPacker->packAndSend(mydata, ElasticFrameContent::adts, 1001, 1001, 2, 1, NO_FLAGS);
+    }
+    if (result != ElasticFrameMessages::noError) {
+        std::cout << "Unit test number: " << unsigned(activeUnitTest) << " Failed in the packAndSend method. Error-> " << signed(result)
+                  << std::endl;
+        delete myEFPPacker;
+        delete myEFPReciever;
+        return false;
+    }
+
+    if (waitForCompletion()) {
+        delete myEFPPacker;
+        delete myEFPReciever;
+        return false;
+    } else {
+        delete myEFPPacker;
+        delete myEFPReciever;
+        return true;
+    }
+}
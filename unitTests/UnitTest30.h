@@ -0,0 +1,27 @@
+#ifndef EFP_UNITTEST30_H
+#define EFP_UNITTEST30_H
+
+#include "../ElasticFrameProtocol.h"
+
+#define MTU 1456 //SRT-max
+
+class UnitTest30 {
+public:
+    bool startUnitTest();
+private:
+    void sendData(const std::vector<uint8_t> &subPacket);
+    void gotData(ElasticFrameProtocolReceiver::pFramePtr &packet);
+    void gotSlowStreamData(ElasticFrameProtocolReceiver::pFramePtr &packet);
+    bool waitForCompletion();
+    ElasticFrameProtocolReceiver *myEFPReciever = nullptr;
+    ElasticFrameProtocolSender *myEFPPacker = nullptr;
+    std::atomic_bool unitTestActive;
+    std::atomic_bool unitTestFailed;
+    int activeUnitTest = 30;
+    std::atomic_int unitTestPacketNumberSender;
+    std::atomic_int unitTestPacketNumberReciever;
+    std::atomic_int slowStreamPackets;
+    std::atomic_bool slowStreamBlocked;
+};
+
+#endif //EFP_UNITTEST30_H
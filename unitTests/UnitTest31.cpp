@@ -0,0 +1,106 @@
+//UnitTest31
+//Test the delivery queue policies using a pull mode receiver.
+//DROP_OLDEST limit 3, send 6 superframes -> the last 3 are pulled and 3 are counted as dropped.
+//DROP_NEWEST limit 3, send 6 superframes -> the first 3 are pulled and 3 are counted as dropped.
+//LATEST_ONLY, send 3 superframes on stream 1 and 3 on stream 2 -> the last superframe of each stream is pulled.
+//BLOCK limit 2, send 4 superframes -> 2 are queued and the worker blocks. When pulled the next 2 are queued. Nothing is lost.
+//BLOCK limit 1 used like a single threaded reactor. 6 superframes of 4 fragments are received, then pulled. Receiving
+//must not wait for the blocked worker. All superframes are pulled in order.
+
+#include "UnitTest31.h"
+
+void UnitTest31::sendData(const std::vector<uint8_t> &subPacket) {
+    ElasticFrameMessages info = myEFPReciever->receiveFragment(subPacket, 0);
+    if (info != ElasticFrameMessages::noError) {
+        std::cout << "Error-> " << signed(info) << std::endl;
+        unitTestFailed = true;
+    }
+}
+
+bool UnitTest31::sendFrames(int lFrames, uint8_t lStreamID, uint64_t lFirstPts) {
+    std::vector<uint8_t> mydata(500);
+    for (int frame = 0; frame < lFrames; frame++) {
+        if (myEFPPacker->packAndSend(mydata, ElasticFrameContent::adts, lFirstPts + frame, lFirstPts + frame, 2, lStreamID, NO_FLAGS)
+            != ElasticFrameMessages::noError) {
+            return false;
+        }
+    }
+    //Let the receiver worker queue the superframes
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    return true;
+}
+
+bool UnitTest31::pullFrames(const std::vector<uint64_t> &rExpectedPts) {
+    std::vector<ElasticFrameProtocolReceiver::pFramePtr> frames;
+    myEFPReciever->popFrames(frames, SIZE_MAX);
+    if (frames.size() != rExpectedPts.size()) {
+        std::cout << "Pulled " << frames.size() << " superframes expected " << rExpectedPts.size() << std::endl;
+        return false;
+    }
+    for (size_t x = 0; x < frames.size(); x++) {
+        if (frames[x]->mPts != rExpectedPts[x]) {
+            std::cout << "Wrong superframe pulled" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool UnitTest31::startUnitTest() {
+    unitTestFailed = false;
+    myEFPReciever = new (std::nothrow) ElasticFrameProtocolReceiver(50, 0, nullptr, ElasticFrameProtocolReceiver::EFPReceiverMode::PULL);
+    myEFPPacker = new (std::nothrow) ElasticFrameProtocolSender(MTU);
+    if (myEFPReciever == nullptr || myEFPPacker == nullptr) {
+        if (myEFPReciever) delete myEFPReciever;
+        if (myEFPPacker) delete myEFPPacker;
+        return false;
+    }
+    myEFPPacker->sendCallback = std::bind(&UnitTest31::sendData, this, std::placeholders::_1);
+
+    bool passed = true;
+
+    myEFPReciever->setDeliveryQueueLimit(3, ElasticFrameProtocolReceiver::EFPQueuePolicy::DROP_OLDEST);
+    passed = passed && sendFrames(6, 1, 100) && pullFrames({103, 104, 105}) &&
+             myEFPReciever->getDeliveryQueueCounters().mDroppedOldest == 3;
+
+    myEFPReciever->setDeliveryQueueLimit(3, ElasticFrameProtocolReceiver::EFPQueuePolicy::DROP_NEWEST);
+    passed = passed && sendFrames(6, 1, 200) && pullFrames({200, 201, 202}) &&
+             myEFPReciever->getDeliveryQueueCounters().mDroppedNewest == 3;
+
+    myEFPReciever->setDeliveryQueueLimit(0, ElasticFrameProtocolReceiver::EFPQueuePolicy::LATEST_ONLY);
+    passed = passed && sendFrames(3, 1, 300) && sendFrames(3, 2, 400) && pullFrames({302, 402}) &&
+             myEFPReciever->getDeliveryQueueCounters().mReplacedByLatest == 4;
+
+    myEFPReciever->setDeliveryQueueLimit(2, ElasticFrameProtocolReceiver::EFPQueuePolicy::BLOCK);
+    passed = passed && sendFrames(4, 1, 500) && pullFrames({500, 501});
+    //The worker is released when the queue is drained
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    passed = passed && pullFrames({502, 503}) && myEFPReciever->getDeliveryQueueCounters().mBlocked >= 1;
+
+    myEFPReciever->setDeliveryQueueLimit(1, ElasticFrameProtocolReceiver::EFPQueuePolicy::BLOCK);
+    std::vector<uint8_t> largeData((MTU - myEFPPacker->geType1Size()) * 3 + 100);
+    std::vector<ElasticFrameProtocolReceiver::pFramePtr> frames;
+    for (uint64_t pts = 600; pts < 606 && passed; pts++) {
+        passed = myEFPPacker->packAndSend(largeData, ElasticFrameContent::adts, pts, pts, 2, 1, NO_FLAGS) ==
+                 ElasticFrameMessages::noError;
+        //Let the worker queue the superframe (or block)
+        std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    }
+    for (int x = 0; x < 100 && frames.size() < 6; x++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        myEFPReciever->popFrames(frames, 1);
+    }
+    passed = passed && frames.size() == 6;
+    for (size_t x = 0; x < frames.size() && passed; x++) {
+        passed = frames[x]->mPts == 600 + x;
+    }
+
+    delete myEFPPacker;
+    delete myEFPReciever;
+    if (!passed || unitTestFailed) {
+        std::cout << "Unit test number: " << unsigned(activeUnitTest) << " Failed." << std::endl;
+        return false;
+    }
+    std::cout << "UnitTest " << unsigned(activeUnitTest) << " done." << std::endl;
+    return true;
+}
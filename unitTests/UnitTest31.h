@@ -0,0 +1,24 @@
+#ifndef EFP_UNITTEST31_H
+#define EFP_UNITTEST31_H
+
+#include "../ElasticFrameProtocol.h"
+
+#define MTU 1456 //SRT-max
+
+class UnitTest31 {
+public:
+    bool startUnitTest();
+private:
+    void sendData(const std::vector<uint8_t> &subPacket);
+    bool sendFrames(int lFrames, uint8_t lStreamID, uint64_t lFirstPts);
+    bool pullFrames(const std::vector<uint64_t> &rExpectedPts);
+    ElasticFrameProtocolReceiver *myEFPReciever = nullptr;
+    ElasticFrameProtocolSender *myEFPPacker = nullptr;
+    std::atomic_bool unitTestActive;
+    std::atomic_bool unitTestFailed;
+    int activeUnitTest = 31;
+    std::atomic_int unitTestPacketNumberSender;
+    std::atomic_int unitTestPacketNumberReciever;
+};
+
+#endif //EFP_UNITTEST31_H
@@ -0,0 +1,71 @@
+//UnitTest32
+//Test priority delivery using a pull mode receiver.
+//Send (stream/priority/pts) 1/P0/1, 1/P3/2, 2/P1/3, 3/P3/4, 2/P2/5
+//Without priority delivery the order is 1,2,3,4,5
+//With priority delivery the order is 4 (P3), 3 (P1, 5 is behind 3), 5 (P2), 1 (P0, 2 is behind 1), 2
+
+#include "UnitTest32.h"
+
+void UnitTest32::sendData(const std::vector<uint8_t> &subPacket) {
+    ElasticFrameMessages info = myEFPReciever->receiveFragment(subPacket, 0);
+    if (info != ElasticFrameMessages::noError) {
+        std::cout << "Error-> " << signed(info) << std::endl;
+        unitTestFailed = true;
+    }
+}
+
+bool UnitTest32::sendFrames() {
+    std::vector<uint8_t> mydata(500);
+    uint8_t streams[5] = {1, 1, 2, 3, 2};
+    uint8_t priorities[5] = {PRIORITY_P0, PRIORITY_P3, PRIORITY_P1, PRIORITY_P3, PRIORITY_P2};
+    for (int frame = 0; frame < 5; frame++) {
+        if (myEFPPacker->packAndSend(mydata, ElasticFrameContent::adts, frame + 1, frame + 1, 2, streams[frame], priorities[frame])
+            != ElasticFrameMessages::noError) {
+            return false;
+        }
+    }
+    //Let the receiver worker queue the superframes
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    return true;
+}
+
+bool UnitTest32::pullFrames(const std::vector<uint64_t> &rExpectedPts) {
+    std::vector<ElasticFrameProtocolReceiver::pFramePtr> frames;
+    myEFPReciever->popFrames(frames, SIZE_MAX);
+    if (frames.size() != rExpectedPts.size()) {
+        std::cout << "Pulled " << frames.size() << " superframes expected " << rExpectedPts.size() << std::endl;
+        return false;
+    }
+    for (size_t x = 0; x < frames.size(); x++) {
+        if (frames[x]->mPts != rExpectedPts[x]) {
+            std::cout << "Wrong superframe pulled" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool UnitTest32::startUnitTest() {
+    unitTestFailed = false;
+    myEFPReciever = new (std::nothrow) ElasticFrameProtocolReceiver(50, 0, nullptr, ElasticFrameProtocolReceiver::EFPReceiverMode::PULL);
+    myEFPPacker = new (std::nothrow) ElasticFrameProtocolSender(MTU);
+    if (myEFPReciever == nullptr || myEFPPacker == nullptr) {
+        if (myEFPReciever) delete myEFPReciever;
+        if (myEFPPacker) delete myEFPPacker;
+        return false;
+    }
+    myEFPPacker->sendCallback = std::bind(&UnitTest32::sendData, this, std::placeholders::_1);
+
+    bool passed = sendFrames() && pullFrames({1, 2, 3, 4, 5});
+    myEFPReciever->setPriorityDelivery(true);
+    passed = passed && sendFrames() && pullFrames({4, 3, 5, 1, 2});
+
+    delete myEFPPacker;
+    delete myEFPReciever;
+    if (!passed || unitTestFailed) {
+        std::cout << "Unit test number: " << unsigned(activeUnitTest) << " Failed." << std::endl;
+        return false;
+    }
+    std::cout << "UnitTest " << unsigned(activeUnitTest) << " done." << std::endl;
+    return true;
+}
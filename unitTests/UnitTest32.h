@@ -0,0 +1,24 @@
+#ifndef EFP_UNITTEST32_H
+#define EFP_UNITTEST32_H
+
+#include "../ElasticFrameProtocol.h"
+
+#define MTU 1456 //SRT-max
+
+class UnitTest32 {
+public:
+    bool startUnitTest();
+private:
+    void sendData(const std::vector<uint8_t> &subPacket);
+    bool sendFrames();
+    bool pullFrames(const std::vector<uint64_t> &rExpectedPts);
+    ElasticFrameProtocolReceiver *myEFPReciever = nullptr;
+    ElasticFrameProtocolSender *myEFPPacker = nullptr;
+    std::atomic_bool unitTestActive;
+    std::atomic_bool unitTestFailed;
+    int activeUnitTest = 32;
+    std::atomic_int unitTestPacketNumberSender;
+    std::atomic_int unitTestPacketNumberReciever;
+};
+
+#endif //EFP_UNITTEST32_H
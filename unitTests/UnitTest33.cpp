@@ -0,0 +1,186 @@
+//UnitTest33
+//Test the eviction policies when the circular buffer wraps.
+//Superframe 0 (PTS 1) is sent without one of the type1 fragments so it's never complete. Then superframe 8192 (PTS 2) is sent.
+//They map to the same bucket.
+//REJECT -> superframe 8192 is rejected. Nothing is delivered.
+//DELIVER_BROKEN -> superframe 0 is delivered broken then superframe 8192 is delivered.
+//DROP -> only superframe 8192 is delivered.
+//DELIVER_BROKEN where superframe 0 has higher priority -> superframe 8192 is rejected.
+//Stress -> 2000 broken superframes in the same bucket. All but the last are evicted and delivered.
+//DELIVER_BROKEN in pull mode with a full BLOCK delivery queue -> receiveFragment evicting superframe 0 must not wait for
+//the consumer. The queued superframe, superframe 0 (broken) and superframe 8192 are pulled in that order.
+//DROP in HOL mode -> superframe 0 is incomplete and superframes 1-8191 wait for it. Superframe 8192 drops superframe 0
+//and superframes 1-8192 must be delivered at once, not when the HOL timeout expires.
+
+#include "UnitTest33.h"
+
+void UnitTest33::sendData(const std::vector<uint8_t> &subPacket) {
+    //Drop the second type1 fragment to make the superframe incomplete
+    if (dropFragment && (subPacket[0] & 0x0f) == 1 && subPacket[4] == 1 && subPacket[5] == 0) {
+        return;
+    }
+    ElasticFrameMessages info = myEFPReciever->receiveFragment(subPacket, 0);
+    if (info == ElasticFrameMessages::bufferOutOfResources) {
+        outOfResources++;
+    } else if (info != ElasticFrameMessages::noError) {
+        std::cout << "Error-> " << signed(info) << std::endl;
+        otherErrors++;
+    }
+}
+
+void UnitTest33::gotData(ElasticFrameProtocolReceiver::pFramePtr &packet) {
+    delivered.emplace_back(packet->mPts, packet->mBroken);
+}
+
+bool UnitTest33::sendFrame(uint16_t lSuperFrameNo, uint64_t lPts, bool lComplete, uint8_t lFlags) {
+    std::vector<uint8_t> mydata(((MTU - myEFPPacker->geType1Size()) * 3) + 100);
+    myEFPPacker->setSuperFrameNo(lSuperFrameNo);
+    dropFragment = !lComplete;
+    return myEFPPacker->packAndSend(mydata, ElasticFrameContent::adts, lPts, lPts, 2, 1, lFlags) == ElasticFrameMessages::noError;
+}
+
+bool UnitTest33::testPolicy(ElasticFrameProtocolReceiver::EFPEvictionPolicy lPolicy, uint8_t lOldFlags,
+                            const std::vector<std::pair<uint64_t, bool>> &rExpected, uint64_t lRejected, uint64_t lDelivered,
+                            uint64_t lDropped) {
+    myEFPReciever = new (std::nothrow) ElasticFrameProtocolReceiver(10000, 0, nullptr, ElasticFrameProtocolReceiver::EFPReceiverMode::RUN_TO_COMPLETION);
+    if (myEFPReciever == nullptr) {
+        return false;
+    }
+    myEFPReciever->receiveCallback = std::bind(&UnitTest33::gotData, this, std::placeholders::_1);
+    myEFPReciever->setEvictionPolicy(lPolicy);
+    delivered.clear();
+    outOfResources = 0;
+    otherErrors = 0;
+    bool passed = sendFrame(0, 1, false, lOldFlags) && sendFrame(8192, 2, true, PRIORITY_P0);
+    ElasticFrameProtocolReceiver::EvictionCounters counters = myEFPReciever->getEvictionCounters();
+    delete myEFPReciever;
+    if (!passed || otherErrors || delivered != rExpected || counters.mRejected != lRejected ||
+        counters.mDelivered != lDelivered || counters.mDropped != lDropped || (lRejected != 0) != (outOfResources != 0)) {
+        std::cout << "Eviction policy " << unsigned(lPolicy) << " failed" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool UnitTest33::stressTest() {
+    myEFPReciever = new (std::nothrow) ElasticFrameProtocolReceiver(10000, 0, nullptr, ElasticFrameProtocolReceiver::EFPReceiverMode::RUN_TO_COMPLETION);
+    if (myEFPReciever == nullptr) {
+        return false;
+    }
+    myEFPReciever->receiveCallback = std::bind(&UnitTest33::gotData, this, std::placeholders::_1);
+    myEFPReciever->setEvictionPolicy(ElasticFrameProtocolReceiver::EFPEvictionPolicy::DELIVER_BROKEN);
+    delivered.clear();
+    outOfResources = 0;
+    otherErrors = 0;
+    bool passed = true;
+    uint16_t superFrameNo = 0;
+    for (int frame = 0; frame < 2000 && passed; frame++) {
+        passed = sendFrame(superFrameNo, frame + 1, false, PRIORITY_P0);
+        superFrameNo += 8192;
+    }
+    ElasticFrameProtocolReceiver::EvictionCounters counters = myEFPReciever->getEvictionCounters();
+    delete myEFPReciever;
+    if (!passed || otherErrors || outOfResources || delivered.size() != 1999 || counters.mDelivered != 1999) {
+        std::cout << "Eviction stress test failed" << std::endl;
+        return false;
+    }
+    for (size_t x = 0; x < delivered.size(); x++) {
+        if (delivered[x].first != x + 1 || !delivered[x].second) {
+            std::cout << "Eviction stress test delivered the wrong superframe" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool UnitTest33::pullBlockTest() {
+    myEFPReciever = new (std::nothrow) ElasticFrameProtocolReceiver(10000, 0, nullptr, ElasticFrameProtocolReceiver::EFPReceiverMode::PULL);
+    if (myEFPReciever == nullptr) {
+        return false;
+    }
+    myEFPReciever->setEvictionPolicy(ElasticFrameProtocolReceiver::EFPEvictionPolicy::DELIVER_BROKEN);
+    myEFPReciever->setDeliveryQueueLimit(1, ElasticFrameProtocolReceiver::EFPQueuePolicy::BLOCK);
+    outOfResources = 0;
+    otherErrors = 0;
+    //Fill the queue
+    bool passed = sendFrame(100, 10, true, PRIORITY_P0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    passed = passed && sendFrame(0, 1, false, PRIORITY_P0) && sendFrame(8192, 2, true, PRIORITY_P0);
+    std::vector<ElasticFrameProtocolReceiver::pFramePtr> frames;
+    for (int x = 0; x < 100 && frames.size() < 3; x++) {
+        myEFPReciever->popFrames(frames, 1);
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    ElasticFrameProtocolReceiver::EvictionCounters counters = myEFPReciever->getEvictionCounters();
+    delete myEFPReciever;
+    if (!passed || otherErrors || outOfResources || counters.mDelivered != 1 || frames.size() != 3 ||
+        frames[0]->mPts != 10 || frames[0]->mBroken || frames[1]->mPts != 1 || !frames[1]->mBroken ||
+        frames[2]->mPts != 2 || frames[2]->mBroken) {
+        std::cout << "Eviction with a blocking delivery queue failed" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool UnitTest33::holDropTest() {
+    myEFPReciever = new (std::nothrow) ElasticFrameProtocolReceiver(10000, 500, nullptr, ElasticFrameProtocolReceiver::EFPReceiverMode::RUN_TO_COMPLETION);
+    if (myEFPReciever == nullptr) {
+        return false;
+    }
+    myEFPReciever->receiveCallback = std::bind(&UnitTest33::gotData, this, std::placeholders::_1);
+    myEFPReciever->setEvictionPolicy(ElasticFrameProtocolReceiver::EFPEvictionPolicy::DROP);
+    delivered.clear();
+    outOfResources = 0;
+    otherErrors = 0;
+    //Delivered, superframe 0 is expected next
+    bool passed = sendFrame(UINT16_MAX, 1000, true, PRIORITY_P0);
+    passed = passed && sendFrame(0, 1, false, PRIORITY_P0);
+    //Single fragment superframes
+    std::vector<uint8_t> mydata(100);
+    dropFragment = false;
+    for (uint16_t superFrameNo = 1; superFrameNo < 8192 && passed; superFrameNo++) {
+        myEFPPacker->setSuperFrameNo(superFrameNo);
+        passed = myEFPPacker->packAndSend(mydata, ElasticFrameContent::adts, superFrameNo + 1, superFrameNo + 1, 2, 1,
+                                          PRIORITY_P0) == ElasticFrameMessages::noError;
+    }
+    bool waiting = delivered.size() == 1;
+    passed = passed && sendFrame(8192, 8193, true, PRIORITY_P0);
+    ElasticFrameProtocolReceiver::EvictionCounters counters = myEFPReciever->getEvictionCounters();
+    delete myEFPReciever;
+    if (!passed || !waiting || otherErrors || outOfResources || counters.mDropped != 1 || delivered.size() != 8193) {
+        std::cout << "Eviction dropping the HOL superframe failed" << std::endl;
+        return false;
+    }
+    for (size_t x = 1; x < delivered.size(); x++) {
+        if (delivered[x].first != x + 1 || delivered[x].second) {
+            std::cout << "Eviction dropping the HOL superframe delivered the wrong superframe" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool UnitTest33::startUnitTest() {
+    myEFPPacker = new (std::nothrow) ElasticFrameProtocolSender(MTU);
+    if (myEFPPacker == nullptr) {
+        return false;
+    }
+    myEFPPacker->sendCallback = std::bind(&UnitTest33::sendData, this, std::placeholders::_1);
+
+    bool passed = testPolicy(ElasticFrameProtocolReceiver::EFPEvictionPolicy::REJECT, PRIORITY_P0, {}, 4, 0, 0);
+    passed = passed && testPolicy(ElasticFrameProtocolReceiver::EFPEvictionPolicy::DELIVER_BROKEN, PRIORITY_P0,
+                                  {{1, true}, {2, false}}, 0, 1, 0);
+    passed = passed && testPolicy(ElasticFrameProtocolReceiver::EFPEvictionPolicy::DROP, PRIORITY_P0, {{2, false}}, 0, 0, 1);
+    passed = passed && testPolicy(ElasticFrameProtocolReceiver::EFPEvictionPolicy::DELIVER_BROKEN, PRIORITY_P3, {}, 4, 0, 0);
+    passed = passed && stressTest();
+    passed = passed && pullBlockTest();
+    passed = passed && holDropTest();
+
+    delete myEFPPacker;
+    if (!passed) {
+        std::cout << "Unit test number: " << unsigned(activeUnitTest) << " Failed." << std::endl;
+        return false;
+    }
+    std::cout << "UnitTest " << unsigned(activeUnitTest) << " done." << std::endl;
+    return true;
+}
@@ -0,0 +1,29 @@
+#ifndef EFP_UNITTEST33_H
+#define EFP_UNITTEST33_H
+
+#include "../ElasticFrameProtocol.h"
+
+#define MTU 1456 //SRT-max
+
+class UnitTest33 {
+public:
+    bool startUnitTest();
+private:
+    void sendData(const std::vector<uint8_t> &subPacket);
+    void gotData(ElasticFrameProtocolReceiver::pFramePtr &packet);
+    bool sendFrame(uint16_t lSuperFrameNo, uint64_t lPts, bool lComplete, uint8_t lFlags);
+    bool testPolicy(ElasticFrameProtocolReceiver::EFPEvictionPolicy lPolicy, uint8_t lOldFlags,
+                    const std::vector<std::pair<uint64_t, bool>> &rExpected, uint64_t lRejected, uint64_t lDelivered, uint64_t lDropped);
+    bool stressTest();
+    bool pullBlockTest();
+    bool holDropTest();
+    ElasticFrameProtocolReceiver *myEFPReciever = nullptr;
+    ElasticFrameProtocolSender *myEFPPacker = nullptr;
+    int activeUnitTest = 33;
+    bool dropFragment = false;
+    int outOfResources = 0;
+    int otherErrors = 0;
+    std::vector<std::pair<uint64_t, bool>> delivered; //PTS and broken
+};
+
+#endif //EFP_UNITTEST33_H
@@ -0,0 +1,150 @@
+//UnitTest34
+//Test the memory budget shared by two receivers.
+//The flooded receiver gets superframes that are never complete (one fragment is dropped) so they are kept in the buckets.
+//When the budget is under pressure the flooded receiver is refused memory (memoryBudgetExceeded, the following fragments
+//of that superframe are tooOldFragment) while the normal
+//receiver sharing the same budget still gets all superframes.
+//The refusals are counted by mBudgetRefused, not as collision rejections.
+//With the DROP eviction policy the flooded receiver drops the oldest superframe instead and new data is accepted.
+//All memory must be returned to the budget when the receivers and the superframes held by the host are destroyed.
+//A pull mode receiver with a full BLOCK delivery queue and DELIVER_BROKEN under pressure drops the oldest superframes
+//(a superframe delivered broken would stay charged) so new data is accepted. Must not wait for the consumer.
+
+#include "UnitTest34.h"
+
+#define BUDGET_SIZE (100 * 1024)
+
+void UnitTest34::sendData(const std::vector<uint8_t> &subPacket) {
+    //Drop the second type1 fragment to make the superframe incomplete
+    if (dropFragment && (subPacket[0] & 0x0f) == 1 && subPacket[4] == 1 && subPacket[5] == 0) {
+        return;
+    }
+    ElasticFrameMessages info = currentReceiver->receiveFragment(subPacket, 3);
+    if (info == ElasticFrameMessages::memoryBudgetExceeded) {
+        budgetExceeded++;
+    } else if (info == ElasticFrameMessages::tooOldFragment && dropFragment) {
+        //The rest of a superframe refused by the budget
+    } else if (info != ElasticFrameMessages::noError) {
+        std::cout << "Error-> " << signed(info) << std::endl;
+        otherErrors++;
+    }
+}
+
+void UnitTest34::gotData(ElasticFrameProtocolReceiver::pFramePtr &packet) {
+    if (!packet->mBroken) {
+        intactFrames++;
+        //Keep the last superframe to verify it's still charged when the receiver is gone
+        heldFrame = std::move(packet);
+    }
+}
+
+bool UnitTest34::sendFrames(ElasticFrameProtocolReceiver *pReceiver, int lFrames, bool lComplete) {
+    std::vector<uint8_t> mydata(((MTU - myEFPPacker->geType1Size()) * 3) + 100);
+    currentReceiver = pReceiver;
+    dropFragment = !lComplete;
+    for (int frame = 0; frame < lFrames; frame++) {
+        if (myEFPPacker->packAndSend(mydata, ElasticFrameContent::adts, frame + 1, frame + 1, 2, 1, NO_FLAGS) != ElasticFrameMessages::noError) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool UnitTest34::startUnitTest() {
+    auto budget = std::make_shared<ElasticFrameProtocolMemoryBudget>(BUDGET_SIZE);
+    myEFPPacker = new (std::nothrow) ElasticFrameProtocolSender(MTU);
+    myEFPRecieverFlooded = new (std::nothrow) ElasticFrameProtocolReceiver(10000, 0, nullptr, ElasticFrameProtocolReceiver::EFPReceiverMode::RUN_TO_COMPLETION);
+    myEFPRecieverNormal = new (std::nothrow) ElasticFrameProtocolReceiver(10000, 0, nullptr, ElasticFrameProtocolReceiver::EFPReceiverMode::RUN_TO_COMPLETION);
+    if (myEFPPacker == nullptr || myEFPRecieverFlooded == nullptr || myEFPRecieverNormal == nullptr) {
+        return false;
+    }
+    myEFPPacker->sendCallback = std::bind(&UnitTest34::sendData, this, std::placeholders::_1);
+    myEFPRecieverFlooded->receiveCallback = std::bind(&UnitTest34::gotData, this, std::placeholders::_1);
+    myEFPRecieverNormal->receiveCallback = std::bind(&UnitTest34::gotData, this, std::placeholders::_1);
+    myEFPRecieverFlooded->setMemoryBudget(budget);
+    myEFPRecieverNormal->setMemoryBudget(budget);
+
+    bool passed = budget->getNumberOfReceivers() == 2;
+
+    //Flood. The flooded receiver may use more than its fair share until the budget is under pressure (3/4 used)
+    passed = passed && sendFrames(myEFPRecieverFlooded, 100, false);
+    ElasticFrameProtocolMemoryBudget::Usage floodedUsage = myEFPRecieverFlooded->getMemoryUsage();
+    ElasticFrameProtocolReceiver::EvictionCounters floodedCounters = myEFPRecieverFlooded->getEvictionCounters();
+    if (!passed || !budgetExceeded || otherErrors || !floodedUsage.mRefused ||
+        floodedCounters.mBudgetRefused != (uint64_t) budgetExceeded || floodedCounters.mRejected ||
+        floodedUsage.mBytes > (BUDGET_SIZE / 4) * 3 || floodedUsage.mBytes <= BUDGET_SIZE / 2 ||
+        floodedUsage.mSourceBytes[3] != floodedUsage.mBytes || budget->getUsedBytes() != floodedUsage.mBytes) {
+        std::cout << "Flooded receiver not limited by the budget" << std::endl;
+        passed = false;
+    }
+
+    //The normal receiver is within its fair share
+    budgetExceeded = 0;
+    passed = passed && sendFrames(myEFPRecieverNormal, 100, true);
+    if (!passed || budgetExceeded || otherErrors || intactFrames != 100 || myEFPRecieverNormal->getMemoryUsage().mRefused) {
+        std::cout << "Normal receiver starved by the flooded receiver" << std::endl;
+        passed = false;
+    }
+
+    //Evict the oldest superframe instead of refusing
+    budgetExceeded = 0;
+    myEFPRecieverFlooded->setEvictionPolicy(ElasticFrameProtocolReceiver::EFPEvictionPolicy::DROP);
+    passed = passed && sendFrames(myEFPRecieverFlooded, 100, false);
+    floodedCounters = myEFPRecieverFlooded->getEvictionCounters();
+    if (!passed || budgetExceeded || otherErrors || !floodedCounters.mBudgetDropped || floodedCounters.mDropped) {
+        std::cout << "Flooded receiver did not evict under pressure" << std::endl;
+        passed = false;
+    }
+
+    //The superframe held by the host is still charged when the receivers are gone
+    delete myEFPRecieverFlooded;
+    delete myEFPRecieverNormal;
+    delete myEFPPacker;
+    if (!heldFrame || budget->getUsedBytes() == 0 || budget->getNumberOfReceivers() != 0) {
+        std::cout << "Held superframe not charged" << std::endl;
+        passed = false;
+    }
+    heldFrame = nullptr;
+    if (budget->getUsedBytes() != 0) {
+        std::cout << "Memory not returned to the budget" << std::endl;
+        passed = false;
+    }
+
+    //DELIVER_BROKEN while the delivery queue is full
+    auto pullBudget = std::make_shared<ElasticFrameProtocolMemoryBudget>(BUDGET_SIZE);
+    myEFPPacker = new (std::nothrow) ElasticFrameProtocolSender(MTU);
+    auto *pullReceiver = new (std::nothrow) ElasticFrameProtocolReceiver(10000, 0, nullptr, ElasticFrameProtocolReceiver::EFPReceiverMode::PULL);
+    if (myEFPPacker == nullptr || pullReceiver == nullptr) {
+        return false;
+    }
+    myEFPPacker->sendCallback = std::bind(&UnitTest34::sendData, this, std::placeholders::_1);
+    pullReceiver->setMemoryBudget(pullBudget);
+    pullReceiver->setEvictionPolicy(ElasticFrameProtocolReceiver::EFPEvictionPolicy::DELIVER_BROKEN);
+    pullReceiver->setDeliveryQueueLimit(1, ElasticFrameProtocolReceiver::EFPQueuePolicy::BLOCK);
+    otherErrors = 0;
+    budgetExceeded = 0;
+    passed = passed && sendFrames(pullReceiver, 1, true);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    passed = passed && sendFrames(pullReceiver, 40, false);
+    std::vector<ElasticFrameProtocolReceiver::pFramePtr> frames;
+    for (int x = 0; x < 10; x++) {
+        pullReceiver->popFrames(frames, 1);
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    ElasticFrameProtocolReceiver::EvictionCounters pullCounters = pullReceiver->getEvictionCounters();
+    if (!passed || otherErrors || budgetExceeded || !pullCounters.mBudgetDropped || pullCounters.mDelivered ||
+        frames.size() != 1 || frames[0]->mBroken) {
+        std::cout << "Eviction under pressure with a blocking delivery queue failed" << std::endl;
+        passed = false;
+    }
+    frames.clear();
+    delete pullReceiver;
+    delete myEFPPacker;
+
+    if (!passed) {
+        std::cout << "Unit test number: " << unsigned(activeUnitTest) << " Failed." << std::endl;
+        return false;
+    }
+    std::cout << "UnitTest " << unsigned(activeUnitTest) << " done." << std::endl;
+    return true;
+}
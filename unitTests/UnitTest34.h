@@ -0,0 +1,27 @@
+#ifndef EFP_UNITTEST34_H
+#define EFP_UNITTEST34_H
+
+#include "../ElasticFrameProtocol.h"
+
+#define MTU 1456 //SRT-max
+
+class UnitTest34 {
+public:
+    bool startUnitTest();
+private:
+    void sendData(const std::vector<uint8_t> &subPacket);
+    void gotData(ElasticFrameProtocolReceiver::pFramePtr &packet);
+    bool sendFrames(ElasticFrameProtocolReceiver *pReceiver, int lFrames, bool lComplete);
+    ElasticFrameProtocolReceiver *myEFPRecieverFlooded = nullptr;
+    ElasticFrameProtocolReceiver *myEFPRecieverNormal = nullptr;
+    ElasticFrameProtocolReceiver *currentReceiver = nullptr;
+    ElasticFrameProtocolSender *myEFPPacker = nullptr;
+    int activeUnitTest = 34;
+    bool dropFragment = false;
+    int budgetExceeded = 0;
+    int otherErrors = 0;
+    int intactFrames = 0;
+    ElasticFrameProtocolReceiver::pFramePtr heldFrame = nullptr;
+};
+
+#endif //EFP_UNITTEST34_H
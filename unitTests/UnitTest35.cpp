@@ -0,0 +1,94 @@
+//UnitTest35
+//Test the adaptive bucket timeout.
+//The receiver is created with a 1000ms timeout. Fragments are fed with 500-1500us between them and every 10th
+//superframe has two fragments swapped. All superframes must be delivered intact and the learned timeout must be below
+//the timeout passed to the constructor. Then a superframe with a lost fragment is sent and the time until it's
+//delivered broken is measured. It must be well below the 1000ms a static timeout would cost.
+
+#include "UnitTest35.h"
+#include <random>
+
+#define NUMBER_OF_FRAMES 200
+
+void UnitTest35::sendData(const std::vector<uint8_t> &subPacket) {
+    fragments.push_back(subPacket);
+}
+
+void UnitTest35::gotData(ElasticFrameProtocolReceiver::pFramePtr &packet) {
+    if (packet->mBroken) {
+        brokenFrames++;
+    } else {
+        intactFrames++;
+    }
+}
+
+bool UnitTest35::startUnitTest() {
+    myEFPPacker = new (std::nothrow) ElasticFrameProtocolSender(MTU);
+    myEFPReciever = new (std::nothrow) ElasticFrameProtocolReceiver(1000, 0, nullptr, ElasticFrameProtocolReceiver::EFPReceiverMode::RUN_TO_COMPLETION);
+    if (myEFPPacker == nullptr || myEFPReciever == nullptr) {
+        return false;
+    }
+    myEFPPacker->sendCallback = std::bind(&UnitTest35::sendData, this, std::placeholders::_1);
+    myEFPReciever->receiveCallback = std::bind(&UnitTest35::gotData, this, std::placeholders::_1);
+    myEFPReciever->setAdaptiveTimeout(true, 0.99, 20, 1000);
+
+    std::mt19937 randomGenerator(35);
+    std::uniform_int_distribution<int> jitter(500, 1500);
+    std::vector<uint8_t> mydata(((MTU - myEFPPacker->geType1Size()) * 3) + 100);
+    bool passed = true;
+    for (int frame = 0; frame < NUMBER_OF_FRAMES; frame++) {
+        fragments.clear();
+        myEFPPacker->packAndSend(mydata, ElasticFrameContent::adts, frame + 1, frame + 1, 2, 1, NO_FLAGS);
+        if (frame % 10 == 5) {
+            std::swap(fragments[0], fragments[1]);
+        }
+        for (auto &rFragment: fragments) {
+            std::this_thread::sleep_for(std::chrono::microseconds(jitter(randomGenerator)));
+            ElasticFrameMessages info = myEFPReciever->receiveFragment(rFragment, 0);
+            if (info != ElasticFrameMessages::noError) {
+                std::cout << "Error-> " << signed(info) << std::endl;
+                passed = false;
+            }
+        }
+    }
+
+    std::vector<ElasticFrameProtocolReceiver::LearnedTimeout> learned = myEFPReciever->getLearnedTimeouts();
+    if (!passed || intactFrames != NUMBER_OF_FRAMES || brokenFrames || learned.size() != 1 ||
+        learned[0].mStreamID != 1 || learned[0].mSamples != NUMBER_OF_FRAMES * 3 || learned[0].mReorderDepth != 1 ||
+        learned[0].mTimeoutms < 20 || learned[0].mTimeoutms >= 1000) {
+        std::cout << "Adaptive timeout not learned" << std::endl;
+        passed = false;
+    }
+
+    //Lose the last type1 fragment and measure the time until the superframe is delivered broken
+    fragments.clear();
+    myEFPPacker->packAndSend(mydata, ElasticFrameContent::adts, NUMBER_OF_FRAMES + 1, NUMBER_OF_FRAMES + 1, 2, 1, NO_FLAGS);
+    fragments.erase(fragments.begin() + 2);
+    auto lossStart = std::chrono::steady_clock::now();
+    for (auto &rFragment: fragments) {
+        myEFPReciever->receiveFragment(rFragment, 0);
+    }
+    while (!brokenFrames && std::chrono::steady_clock::now() - lossStart < std::chrono::milliseconds(2000)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        myEFPReciever->processTimeouts();
+    }
+    int64_t lossLatencyms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - lossStart).count();
+    if (brokenFrames != 1 || lossLatencyms >= 500) {
+        std::cout << "Broken superframe not delivered by the adaptive timeout" << std::endl;
+        passed = false;
+    }
+
+    if (!learned.empty()) {
+        std::cout << "UnitTest " << unsigned(activeUnitTest) << " learned timeout " << learned[0].mTimeoutms << "ms, loss latency "
+                  << lossLatencyms << "ms, intact " << intactFrames << "/" << NUMBER_OF_FRAMES << std::endl;
+    }
+
+    delete myEFPReciever;
+    delete myEFPPacker;
+    if (!passed) {
+        std::cout << "Unit test number: " << unsigned(activeUnitTest) << " Failed." << std::endl;
+        return false;
+    }
+    std::cout << "UnitTest " << unsigned(activeUnitTest) << " done." << std::endl;
+    return true;
+}
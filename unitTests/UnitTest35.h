@@ -0,0 +1,22 @@
+#ifndef EFP_UNITTEST35_H
+#define EFP_UNITTEST35_H
+
+#include "../ElasticFrameProtocol.h"
+
+#define MTU 1456 //SRT-max
+
+class UnitTest35 {
+public:
+    bool startUnitTest();
+private:
+    void sendData(const std::vector<uint8_t> &subPacket);
+    void gotData(ElasticFrameProtocolReceiver::pFramePtr &packet);
+    ElasticFrameProtocolReceiver *myEFPReciever = nullptr;
+    ElasticFrameProtocolSender *myEFPPacker = nullptr;
+    int activeUnitTest = 35;
+    std::vector<std::vector<uint8_t>> fragments;
+    int intactFrames = 0;
+    int brokenFrames = 0;
+};
+
+#endif //EFP_UNITTEST35_H
@@ -0,0 +1,94 @@
+//UnitTest36
+//Test the playout mode.
+//30 superframes with 33.3ms between the PTS (90kHz time base) are sent in real time but every third superframe is
+//delayed 40ms so it arrives after the next superframe. The last superframe is delayed 250ms.
+//With 100ms latency all superframes but the last must be delivered in PTS order 33.3ms apart. The last one is late
+//and dropped.
+
+#include "UnitTest36.h"
+
+#define NUMBER_OF_FRAMES 30
+#define FRAME_DURATION_US 33333
+
+void UnitTest36::sendData(const std::vector<uint8_t> &subPacket) {
+    fragments.push_back(subPacket);
+}
+
+void UnitTest36::gotData(ElasticFrameProtocolReceiver::pFramePtr &packet) {
+    std::lock_guard<std::mutex> lock(deliveredMtx);
+    delivered.emplace_back(packet->mPts, std::chrono::steady_clock::now());
+}
+
+bool UnitTest36::startUnitTest() {
+    myEFPPacker = new (std::nothrow) ElasticFrameProtocolSender(MTU);
+    myEFPReciever = new (std::nothrow) ElasticFrameProtocolReceiver(50, 0, nullptr, ElasticFrameProtocolReceiver::EFPReceiverMode::THREADED);
+    if (myEFPPacker == nullptr || myEFPReciever == nullptr) {
+        return false;
+    }
+    myEFPPacker->sendCallback = std::bind(&UnitTest36::sendData, this, std::placeholders::_1);
+    myEFPReciever->receiveCallback = std::bind(&UnitTest36::gotData, this, std::placeholders::_1);
+    if (myEFPReciever->setPlayoutMode(true, 100, 90000) != ElasticFrameMessages::noError) {
+        std::cout << "Failed enabling the playout mode" << std::endl;
+        return false;
+    }
+
+    //Pack all superframes and decide when they arrive
+    std::vector<uint8_t> mydata(((MTU - myEFPPacker->geType1Size()) * 3) + 100);
+    std::vector<std::pair<int64_t, std::vector<std::vector<uint8_t>>>> arrivals; //Arrival time (us from start) and fragments
+    for (int frame = 0; frame < NUMBER_OF_FRAMES; frame++) {
+        fragments.clear();
+        uint64_t pts = 90000 + (uint64_t) frame * 3000;
+        myEFPPacker->packAndSend(mydata, ElasticFrameContent::adts, pts, pts, 2, 1, NO_FLAGS);
+        int64_t delay = frame % 3 == 1 ? 40000 : 0;
+        if (frame == NUMBER_OF_FRAMES - 1) {
+            delay = 250000;
+        }
+        arrivals.emplace_back((int64_t) frame * FRAME_DURATION_US + delay, fragments);
+    }
+    std::stable_sort(arrivals.begin(), arrivals.end(),
+                     [](const auto &rA, const auto &rB) { return rA.first < rB.first; });
+
+    bool passed = true;
+    auto start = std::chrono::steady_clock::now();
+    for (auto &rArrival: arrivals) {
+        std::this_thread::sleep_until(start + std::chrono::microseconds(rArrival.first));
+        for (auto &rFragment: rArrival.second) {
+            ElasticFrameMessages info = myEFPReciever->receiveFragment(rFragment, 0);
+            if (info != ElasticFrameMessages::noError) {
+                std::cout << "Error-> " << signed(info) << std::endl;
+                passed = false;
+            }
+        }
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    ElasticFrameProtocolReceiver::PlayoutCounters counters = myEFPReciever->getPlayoutCounters();
+    delete myEFPReciever;
+    delete myEFPPacker;
+
+    if (delivered.size() != NUMBER_OF_FRAMES - 1 || counters.mDelivered != NUMBER_OF_FRAMES - 1 || counters.mLate != 1) {
+        std::cout << "Playout delivered " << delivered.size() << " superframes, " << counters.mLate << " late" << std::endl;
+        passed = false;
+    }
+    for (size_t x = 1; x < delivered.size(); x++) {
+        int64_t interval = std::chrono::duration_cast<std::chrono::microseconds>(delivered[x].second - delivered[x - 1].second).count();
+        if (delivered[x].first != delivered[x - 1].first + 3000 || std::abs(interval - FRAME_DURATION_US) > 20000) {
+            std::cout << "Playout not smooth. PTS " << delivered[x].first << " delivered " << interval << "us after the previous" << std::endl;
+            passed = false;
+        }
+    }
+    if (!delivered.empty()) {
+        int64_t latency = std::chrono::duration_cast<std::chrono::milliseconds>(delivered[0].second - start).count();
+        if (latency < 90 || latency > 150) {
+            std::cout << "Playout latency " << latency << "ms" << std::endl;
+            passed = false;
+        }
+    }
+
+    if (!passed) {
+        std::cout << "Unit test number: " << unsigned(activeUnitTest) << " Failed." << std::endl;
+        return false;
+    }
+    std::cout << "UnitTest " << unsigned(activeUnitTest) << " done." << std::endl;
+    return true;
+}
@@ -0,0 +1,22 @@
+#ifndef EFP_UNITTEST36_H
+#define EFP_UNITTEST36_H
+
+#include "../ElasticFrameProtocol.h"
+
+#define MTU 1456 //SRT-max
+
+class UnitTest36 {
+public:
+    bool startUnitTest();
+private:
+    void sendData(const std::vector<uint8_t> &subPacket);
+    void gotData(ElasticFrameProtocolReceiver::pFramePtr &packet);
+    ElasticFrameProtocolReceiver *myEFPReciever = nullptr;
+    ElasticFrameProtocolSender *myEFPPacker = nullptr;
+    int activeUnitTest = 36;
+    std::vector<std::vector<uint8_t>> fragments;
+    std::mutex deliveredMtx;
+    std::vector<std::pair<uint64_t, std::chrono::steady_clock::time_point>> delivered; //PTS and delivery time
+};
+
+#endif //EFP_UNITTEST36_H
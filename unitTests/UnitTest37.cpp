@@ -0,0 +1,88 @@
+//UnitTest37
+//Test the max reorder distance.
+//The receivers use a 1000ms timeout and all superframes must be delivered without waiting for it.
+//Superframes: superframe 1 misses its second fragment, 2 and 3 are complete.
+//Max 1 superframe -> 2 is delivered, then 1 (broken) when 3 arrives, then 3.
+//Max 3 fragments -> 1 (broken) is delivered at the fourth fragment after it, that is when 2 is complete, then 2 and 3.
+//HOL with max 1 superframe -> superframe 1 is complete, all fragments of 2 are lost and 3, 4 are complete. 2 is
+//skipped when 4 arrives.
+
+#include "UnitTest37.h"
+
+void UnitTest37::sendData(const std::vector<uint8_t> &subPacket) {
+    fragments.push_back(subPacket);
+}
+
+void UnitTest37::gotData(ElasticFrameProtocolReceiver::pFramePtr &packet) {
+    delivered.emplace_back(packet->mPts, packet->mBroken);
+}
+
+std::vector<std::vector<uint8_t>> UnitTest37::packFrame(uint64_t lPts) {
+    std::vector<uint8_t> mydata(((MTU - myEFPPacker->geType1Size()) * 3) + 100);
+    fragments.clear();
+    myEFPPacker->packAndSend(mydata, ElasticFrameContent::adts, lPts, lPts, 2, 1, NO_FLAGS);
+    return fragments;
+}
+
+bool UnitTest37::runTest(uint32_t lHolTimeoutms, uint32_t lSuperFrames, uint32_t lFragments,
+                         const std::vector<std::vector<std::vector<uint8_t>>> &rFrames,
+                         const std::vector<std::pair<uint64_t, bool>> &rExpected) {
+    myEFPReciever = new (std::nothrow) ElasticFrameProtocolReceiver(1000, lHolTimeoutms, nullptr, ElasticFrameProtocolReceiver::EFPReceiverMode::RUN_TO_COMPLETION);
+    if (myEFPReciever == nullptr) {
+        return false;
+    }
+    myEFPReciever->receiveCallback = std::bind(&UnitTest37::gotData, this, std::placeholders::_1);
+    myEFPReciever->setMaxReorderDistance(lSuperFrames, lFragments);
+    delivered.clear();
+    bool passed = true;
+    auto start = std::chrono::steady_clock::now();
+    for (auto &rFrame: rFrames) {
+        for (auto &rFragment: rFrame) {
+            ElasticFrameMessages info = myEFPReciever->receiveFragment(rFragment, 0);
+            if (info != ElasticFrameMessages::noError) {
+                std::cout << "Error-> " << signed(info) << std::endl;
+                passed = false;
+            }
+        }
+    }
+    delete myEFPReciever;
+    if (!passed || delivered != rExpected || std::chrono::steady_clock::now() - start > std::chrono::milliseconds(500)) {
+        std::cout << "Max reorder distance " << lSuperFrames << " superframes " << lFragments << " fragments failed" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool UnitTest37::startUnitTest() {
+    myEFPPacker = new (std::nothrow) ElasticFrameProtocolSender(MTU);
+    if (myEFPPacker == nullptr) {
+        return false;
+    }
+    myEFPPacker->sendCallback = std::bind(&UnitTest37::sendData, this, std::placeholders::_1);
+
+    auto frame1 = packFrame(1);
+    frame1.erase(frame1.begin() + 1);
+    auto frame2 = packFrame(2);
+    auto frame3 = packFrame(3);
+    bool passed = runTest(0, 1, 0, {frame1, frame2, frame3}, {{2, false}, {1, true}, {3, false}});
+
+    frame1 = packFrame(1);
+    frame1.erase(frame1.begin() + 1);
+    frame2 = packFrame(2);
+    frame3 = packFrame(3);
+    passed = passed && runTest(0, 0, 3, {frame1, frame2, frame3}, {{1, true}, {2, false}, {3, false}});
+
+    frame1 = packFrame(1);
+    packFrame(2);
+    frame3 = packFrame(3);
+    auto frame4 = packFrame(4);
+    passed = passed && runTest(500, 1, 0, {frame1, frame3, frame4}, {{1, false}, {3, false}, {4, false}});
+
+    delete myEFPPacker;
+    if (!passed) {
+        std::cout << "Unit test number: " << unsigned(activeUnitTest) << " Failed." << std::endl;
+        return false;
+    }
+    std::cout << "UnitTest " << unsigned(activeUnitTest) << " done." << std::endl;
+    return true;
+}
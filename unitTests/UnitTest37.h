@@ -0,0 +1,24 @@
+#ifndef EFP_UNITTEST37_H
+#define EFP_UNITTEST37_H
+
+#include "../ElasticFrameProtocol.h"
+
+#define MTU 1456 //SRT-max
+
+class UnitTest37 {
+public:
+    bool startUnitTest();
+private:
+    void sendData(const std::vector<uint8_t> &subPacket);
+    void gotData(ElasticFrameProtocolReceiver::pFramePtr &packet);
+    std::vector<std::vector<uint8_t>> packFrame(uint64_t lPts);
+    bool runTest(uint32_t lHolTimeoutms, uint32_t lSuperFrames, uint32_t lFragments,
+                 const std::vector<std::vector<std::vector<uint8_t>>> &rFrames, const std::vector<std::pair<uint64_t, bool>> &rExpected);
+    ElasticFrameProtocolReceiver *myEFPReciever = nullptr;
+    ElasticFrameProtocolSender *myEFPPacker = nullptr;
+    int activeUnitTest = 37;
+    std::vector<std::vector<uint8_t>> fragments;
+    std::vector<std::pair<uint64_t, bool>> delivered; //PTS and broken
+};
+
+#endif //EFP_UNITTEST37_H
@@ -0,0 +1,155 @@
+//UnitTest38
+//Test the discontinuity detection in HOL mode (run to completion, 1000ms timeout, 500ms HOL timeout).
+//A sender sends superframes with PTS 1-5 and PTS 6 missing a fragment. The sender is restarted with an other
+//superframe number and sends PTS 7-10.
+//The discontinuity callback must be called once and PTS 7-10 delivered at once.
+//Restart to superframe 0 delivering the stale superframes -> PTS 6 is delivered broken before PTS 7.
+//Restart jumping forward dropping the stale superframes -> PTS 6 is never delivered.
+//Two sources where source 1 is restarted while a superframe (PTS 100) of source 0 is waiting for its last fragment.
+//The superframe of source 0 must not be flushed and is delivered intact when the last fragment arrives.
+//The receiver is called from within the callback.
+
+#include "UnitTest38.h"
+
+void UnitTest38::sendData(const std::vector<uint8_t> &subPacket) {
+    //Drop the second type1 fragment to make the superframe incomplete
+    if (dropFragment && (subPacket[0] & 0x0f) == 1 && subPacket[4] == 1 && subPacket[5] == 0) {
+        return;
+    }
+    ElasticFrameMessages info = myEFPReciever->receiveFragment(subPacket, 0);
+    if (info != ElasticFrameMessages::noError) {
+        std::cout << "Error-> " << signed(info) << std::endl;
+        errors = true;
+    }
+}
+
+void UnitTest38::gotData(ElasticFrameProtocolReceiver::pFramePtr &packet) {
+    delivered.emplace_back(packet->mPts, packet->mBroken);
+}
+
+void UnitTest38::gotDiscontinuity(uint8_t lSource, uint16_t lLastSuperFrameNo, uint16_t lNewSuperFrameNo) {
+    discontinuities.emplace_back(lLastSuperFrameNo, lNewSuperFrameNo);
+    //The receiver is not locked when the callback is called
+    myEFPReciever->nextDeadline();
+    if (myEFPReciever->setDiscontinuityDetection(100, deliverStale) != ElasticFrameMessages::noError) {
+        errors = true;
+    }
+}
+
+bool UnitTest38::runTest(uint16_t lFirstSuperFrameNo, uint16_t lRestartSuperFrameNo, bool lDeliverStale) {
+    myEFPReciever = new (std::nothrow) ElasticFrameProtocolReceiver(1000, 500, nullptr, ElasticFrameProtocolReceiver::EFPReceiverMode::RUN_TO_COMPLETION);
+    myEFPPacker = new (std::nothrow) ElasticFrameProtocolSender(MTU);
+    if (myEFPReciever == nullptr || myEFPPacker == nullptr) {
+        return false;
+    }
+    myEFPReciever->receiveCallback = std::bind(&UnitTest38::gotData, this, std::placeholders::_1);
+    myEFPReciever->discontinuityCallback = std::bind(&UnitTest38::gotDiscontinuity, this, std::placeholders::_1,
+                                                     std::placeholders::_2, std::placeholders::_3);
+    deliverStale = lDeliverStale;
+    myEFPReciever->setDiscontinuityDetection(100, deliverStale);
+    myEFPPacker->sendCallback = std::bind(&UnitTest38::sendData, this, std::placeholders::_1);
+    myEFPPacker->setSuperFrameNo(lFirstSuperFrameNo);
+    delivered.clear();
+    discontinuities.clear();
+    errors = false;
+
+    std::vector<uint8_t> mydata(((MTU - myEFPPacker->geType1Size()) * 3) + 100);
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t pts = 1; pts <= 10; pts++) {
+        if (pts == 7) {
+            //Restart the sender
+            delete myEFPPacker;
+            myEFPPacker = new (std::nothrow) ElasticFrameProtocolSender(MTU);
+            if (myEFPPacker == nullptr) {
+                delete myEFPReciever;
+                return false;
+            }
+            myEFPPacker->sendCallback = std::bind(&UnitTest38::sendData, this, std::placeholders::_1);
+            myEFPPacker->setSuperFrameNo(lRestartSuperFrameNo);
+        }
+        dropFragment = pts == 6;
+        myEFPPacker->packAndSend(mydata, ElasticFrameContent::adts, pts, pts, 2, 1, NO_FLAGS);
+    }
+    bool inTime = std::chrono::steady_clock::now() - start < std::chrono::milliseconds(200);
+    delete myEFPPacker;
+    delete myEFPReciever;
+
+    std::vector<std::pair<uint64_t, bool>> expected = {{1, false}, {2, false}, {3, false}, {4, false}, {5, false}};
+    if (lDeliverStale) {
+        expected.emplace_back(6, true);
+    }
+    for (uint64_t pts = 7; pts <= 10; pts++) {
+        expected.emplace_back(pts, false);
+    }
+    std::vector<std::pair<uint16_t, uint16_t>> expectedDiscontinuities = {{(uint16_t) (lFirstSuperFrameNo + 5), lRestartSuperFrameNo}};
+    if (errors || !inTime || delivered != expected || discontinuities != expectedDiscontinuities) {
+        std::cout << "Discontinuity from " << lFirstSuperFrameNo << " to " << lRestartSuperFrameNo << " failed" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool UnitTest38::otherSourceTest() {
+    myEFPReciever = new (std::nothrow) ElasticFrameProtocolReceiver(1000, 0, nullptr, ElasticFrameProtocolReceiver::EFPReceiverMode::RUN_TO_COMPLETION);
+    myEFPPacker = new (std::nothrow) ElasticFrameProtocolSender(MTU);
+    if (myEFPReciever == nullptr || myEFPPacker == nullptr) {
+        return false;
+    }
+    myEFPReciever->receiveCallback = std::bind(&UnitTest38::gotData, this, std::placeholders::_1);
+    myEFPReciever->discontinuityCallback = std::bind(&UnitTest38::gotDiscontinuity, this, std::placeholders::_1,
+                                                     std::placeholders::_2, std::placeholders::_3);
+    deliverStale = true;
+    myEFPReciever->setDiscontinuityDetection(100, deliverStale);
+    delivered.clear();
+    discontinuities.clear();
+    errors = false;
+
+    std::vector<uint8_t> mydata(((MTU - myEFPPacker->geType1Size()) * 3) + 100);
+    uint8_t source = 0;
+    std::vector<std::vector<uint8_t>> fragments;
+    myEFPPacker->sendCallback = [&](const std::vector<uint8_t> &rSubPacket, uint8_t lStreamID, ElasticFrameProtocolContext *pCTX) {
+        fragments.push_back(rSubPacket);
+    };
+    auto sendFrame = [&](uint8_t lSource, uint16_t lSuperFrameNo, uint64_t lPts, bool lHoldLast) {
+        fragments.clear();
+        myEFPPacker->setSuperFrameNo(lSuperFrameNo);
+        myEFPPacker->packAndSend(mydata, ElasticFrameContent::adts, lPts, lPts, 2, 1, NO_FLAGS);
+        for (size_t x = 0; x < fragments.size() - (lHoldLast ? 1 : 0); x++) {
+            if (myEFPReciever->receiveFragment(fragments[x], lSource) != ElasticFrameMessages::noError) {
+                errors = true;
+            }
+        }
+    };
+
+    //Source 0 waits for the last fragment
+    sendFrame(0, 5000, 100, true);
+    std::vector<uint8_t> lastFragment = fragments.back();
+    //Source 1 is restarted
+    sendFrame(1, 20000, 1, false);
+    sendFrame(1, 0, 2, false);
+    if (myEFPReciever->receiveFragment(lastFragment, source) != ElasticFrameMessages::noError) {
+        errors = true;
+    }
+    delete myEFPPacker;
+    delete myEFPReciever;
+
+    std::vector<std::pair<uint64_t, bool>> expected = {{1, false}, {2, false}, {100, false}};
+    std::vector<std::pair<uint16_t, uint16_t>> expectedDiscontinuities = {{20000, 0}};
+    if (errors || delivered != expected || discontinuities != expectedDiscontinuities) {
+        std::cout << "Discontinuity of an other source failed" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool UnitTest38::startUnitTest() {
+    bool passed = runTest(20000, 0, true);
+    passed = passed && runTest(100, 40000, false);
+    passed = passed && otherSourceTest();
+    if (!passed) {
+        std::cout << "Unit test number: " << unsigned(activeUnitTest) << " Failed." << std::endl;
+        return false;
+    }
+    std::cout << "UnitTest " << unsigned(activeUnitTest) << " done." << std::endl;
+    return true;
+}
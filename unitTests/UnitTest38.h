@@ -0,0 +1,27 @@
+#ifndef EFP_UNITTEST38_H
+#define EFP_UNITTEST38_H
+
+#include "../ElasticFrameProtocol.h"
+
+#define MTU 1456 //SRT-max
+
+class UnitTest38 {
+public:
+    bool startUnitTest();
+private:
+    void sendData(const std::vector<uint8_t> &subPacket);
+    void gotData(ElasticFrameProtocolReceiver::pFramePtr &packet);
+    void gotDiscontinuity(uint8_t lSource, uint16_t lLastSuperFrameNo, uint16_t lNewSuperFrameNo);
+    bool runTest(uint16_t lFirstSuperFrameNo, uint16_t lRestartSuperFrameNo, bool lDeliverStale);
+    bool otherSourceTest();
+    ElasticFrameProtocolReceiver *myEFPReciever = nullptr;
+    ElasticFrameProtocolSender *myEFPPacker = nullptr;
+    int activeUnitTest = 38;
+    bool dropFragment = false;
+    bool deliverStale = false;
+    bool errors = false;
+    std::vector<std::pair<uint64_t, bool>> delivered; //PTS and broken
+    std::vector<std::pair<uint16_t, uint16_t>> discontinuities;
+};
+
+#endif //EFP_UNITTEST38_H
@@ -0,0 +1,201 @@
+//UnitTest39
+//Test the fast path for superframes carried by a single fragment.
+//Run to completion in view mode -> The superframes are delivered during receiveFragment pointing into the fragment.
+//A duplicate of a delivered fragment must return tooOldFragment.
+//HOL mode -> A single fragment superframe received before the superframe ahead of it is delivered in order.
+//Threaded mode -> View mode is not available, the superframes are copied and delivered.
+//Threaded mode -> A single fragment superframe must not overtake a complete superframe of the same stream waiting
+//for the worker.
+
+#include "UnitTest39.h"
+
+void UnitTest39::sendData(const std::vector<uint8_t> &subPacket) {
+    if (holdFragments) {
+        heldFragments.push_back(subPacket);
+        return;
+    }
+    currentFragment = &subPacket;
+    ElasticFrameMessages info = myEFPReciever->receiveFragment(subPacket, 0);
+    currentFragment = nullptr;
+    if (info != ElasticFrameMessages::noError) {
+        std::cout << "Error-> " << signed(info) << std::endl;
+        errors = true;
+    }
+}
+
+void UnitTest39::gotData(ElasticFrameProtocolReceiver::pFramePtr &packet) {
+    if (packet->mView) {
+        //The data must be inside the fragment passed to receiveFragment
+        if (currentFragment == nullptr || packet->pFrameData < currentFragment->data() ||
+            packet->pFrameData + packet->mFrameSize > currentFragment->data() + currentFragment->size()) {
+            viewOk = false;
+        }
+    }
+    for (size_t x = 0; x < packet->mFrameSize; x++) {
+        if (packet->pFrameData[x] != (uint8_t) packet->mPts) {
+            viewOk = false;
+            break;
+        }
+    }
+    std::lock_guard<std::mutex> lock(deliveredMtx);
+    delivered.emplace_back(packet->mPts, packet->mView);
+}
+
+bool UnitTest39::testView() {
+    myEFPReciever = new (std::nothrow) ElasticFrameProtocolReceiver(50, 0, nullptr, ElasticFrameProtocolReceiver::EFPReceiverMode::RUN_TO_COMPLETION);
+    myEFPPacker = new (std::nothrow) ElasticFrameProtocolSender(MTU);
+    if (myEFPReciever == nullptr || myEFPPacker == nullptr) {
+        return false;
+    }
+    myEFPReciever->receiveCallback = std::bind(&UnitTest39::gotData, this, std::placeholders::_1);
+    bool passed = myEFPReciever->setSingleFragmentView(true) == ElasticFrameMessages::noError;
+
+    std::vector<uint8_t> lastFragment;
+    myEFPPacker->sendCallback = [&](const std::vector<uint8_t> &subPacket, uint8_t, ElasticFrameProtocolContext *) {
+        lastFragment = subPacket;
+        sendData(subPacket);
+    };
+    for (uint64_t pts = 1; pts <= 5; pts++) {
+        std::vector<uint8_t> mydata(100, (uint8_t) pts);
+        myEFPPacker->packAndSend(mydata, ElasticFrameContent::adts, pts, pts, 2, 1, NO_FLAGS);
+        //Delivered before receiveFragment returned
+        passed = passed && delivered.size() == pts && delivered.back() == std::make_pair(pts, true);
+    }
+    passed = passed && myEFPReciever->receiveFragment(lastFragment, 0) == ElasticFrameMessages::tooOldFragment;
+    passed = passed && delivered.size() == 5;
+    delete myEFPPacker;
+    delete myEFPReciever;
+    if (!passed || errors || !viewOk) {
+        std::cout << "View delivery failed" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool UnitTest39::testHeadOfLine() {
+    myEFPReciever = new (std::nothrow) ElasticFrameProtocolReceiver(1000, 500, nullptr, ElasticFrameProtocolReceiver::EFPReceiverMode::RUN_TO_COMPLETION);
+    myEFPPacker = new (std::nothrow) ElasticFrameProtocolSender(MTU);
+    if (myEFPReciever == nullptr || myEFPPacker == nullptr) {
+        return false;
+    }
+    myEFPReciever->receiveCallback = std::bind(&UnitTest39::gotData, this, std::placeholders::_1);
+    myEFPReciever->setSingleFragmentView(true);
+    myEFPPacker->sendCallback = std::bind(&UnitTest39::sendData, this, std::placeholders::_1);
+    delivered.clear();
+
+    std::vector<uint8_t> small(100, 0);
+    myEFPPacker->packAndSend(small, ElasticFrameContent::adts, 0, 0, 2, 1, NO_FLAGS);
+    //Hold the superframe in 3 fragments and send the next superframe ahead of it
+    holdFragments = true;
+    std::vector<uint8_t> large(((MTU - myEFPPacker->geType1Size()) * 2) + 100, 1);
+    myEFPPacker->packAndSend(large, ElasticFrameContent::adts, 1, 1, 2, 1, NO_FLAGS);
+    holdFragments = false;
+    small.assign(100, 2);
+    myEFPPacker->packAndSend(small, ElasticFrameContent::adts, 2, 2, 2, 1, NO_FLAGS);
+    bool passed = delivered.size() == 1;
+    for (auto &rFragment: heldFragments) {
+        sendData(rFragment);
+    }
+    heldFragments.clear();
+    small.assign(100, 3);
+    myEFPPacker->packAndSend(small, ElasticFrameContent::adts, 3, 3, 2, 1, NO_FLAGS);
+    delete myEFPPacker;
+    delete myEFPReciever;
+
+    std::vector<std::pair<uint64_t, bool>> expected = {{0, false}, {1, false}, {2, false}, {3, true}};
+    if (!passed || errors || !viewOk || delivered != expected) {
+        std::cout << "HOL delivery failed" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool UnitTest39::testThreaded() {
+    myEFPReciever = new (std::nothrow) ElasticFrameProtocolReceiver(50, 0);
+    myEFPPacker = new (std::nothrow) ElasticFrameProtocolSender(MTU);
+    if (myEFPReciever == nullptr || myEFPPacker == nullptr) {
+        return false;
+    }
+    myEFPReciever->receiveCallback = std::bind(&UnitTest39::gotData, this, std::placeholders::_1);
+    myEFPPacker->sendCallback = std::bind(&UnitTest39::sendData, this, std::placeholders::_1);
+    {
+        std::lock_guard<std::mutex> lock(deliveredMtx);
+        delivered.clear();
+    }
+    bool passed = myEFPReciever->setSingleFragmentView(true) == ElasticFrameMessages::notImplemented;
+    for (uint64_t pts = 1; pts <= 10; pts++) {
+        std::vector<uint8_t> mydata(100, (uint8_t) pts);
+        myEFPPacker->packAndSend(mydata, ElasticFrameContent::adts, pts, pts, 2, 1, NO_FLAGS);
+    }
+    for (int x = 0; x < 100; x++) {
+        {
+            std::lock_guard<std::mutex> lock(deliveredMtx);
+            if (delivered.size() == 10) {
+                break;
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    delete myEFPPacker;
+    delete myEFPReciever;
+
+    std::vector<std::pair<uint64_t, bool>> expected;
+    for (uint64_t pts = 1; pts <= 10; pts++) {
+        expected.emplace_back(pts, false);
+    }
+    if (!passed || errors || !viewOk || delivered != expected) {
+        std::cout << "Threaded delivery failed" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool UnitTest39::testOrder() {
+    myEFPReciever = new (std::nothrow) ElasticFrameProtocolReceiver(50, 0);
+    myEFPPacker = new (std::nothrow) ElasticFrameProtocolSender(MTU);
+    if (myEFPReciever == nullptr || myEFPPacker == nullptr) {
+        return false;
+    }
+    myEFPReciever->receiveCallback = std::bind(&UnitTest39::gotData, this, std::placeholders::_1);
+    myEFPPacker->sendCallback = std::bind(&UnitTest39::sendData, this, std::placeholders::_1);
+    {
+        std::lock_guard<std::mutex> lock(deliveredMtx);
+        delivered.clear();
+    }
+    //Complete when received but delivered by the worker
+    std::vector<uint8_t> large(((MTU - myEFPPacker->geType1Size()) * 2) + 100, 1);
+    myEFPPacker->packAndSend(large, ElasticFrameContent::adts, 1, 1, 2, 1, NO_FLAGS);
+    std::vector<uint8_t> small(50, 2);
+    myEFPPacker->packAndSend(small, ElasticFrameContent::adts, 2, 2, 2, 1, NO_FLAGS);
+    for (int x = 0; x < 100; x++) {
+        {
+            std::lock_guard<std::mutex> lock(deliveredMtx);
+            if (delivered.size() == 2) {
+                break;
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    delete myEFPPacker;
+    delete myEFPReciever;
+
+    std::vector<std::pair<uint64_t, bool>> expected = {{1, false}, {2, false}};
+    if (errors || !viewOk || delivered != expected) {
+        std::cout << "Same stream delivery order failed" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool UnitTest39::startUnitTest() {
+    bool passed = testView();
+    passed = passed && testHeadOfLine();
+    passed = passed && testThreaded();
+    passed = passed && testOrder();
+    if (!passed) {
+        std::cout << "Unit test number: " << unsigned(activeUnitTest) << " Failed." << std::endl;
+        return false;
+    }
+    std::cout << "UnitTest " << unsigned(activeUnitTest) << " done." << std::endl;
+    return true;
+}
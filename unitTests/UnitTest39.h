@@ -0,0 +1,30 @@
+#ifndef EFP_UNITTEST39_H
+#define EFP_UNITTEST39_H
+
+#include "../ElasticFrameProtocol.h"
+
+#define MTU 1456 //SRT-max
+
+class UnitTest39 {
+public:
+    bool startUnitTest();
+private:
+    void sendData(const std::vector<uint8_t> &subPacket);
+    void gotData(ElasticFrameProtocolReceiver::pFramePtr &packet);
+    bool testView();
+    bool testHeadOfLine();
+    bool testThreaded();
+    bool testOrder();
+    ElasticFrameProtocolReceiver *myEFPReciever = nullptr;
+    ElasticFrameProtocolSender *myEFPPacker = nullptr;
+    int activeUnitTest = 39;
+    bool holdFragments = false;
+    bool errors = false;
+    const std::vector<uint8_t> *currentFragment = nullptr;
+    std::vector<std::vector<uint8_t>> heldFragments;
+    std::mutex deliveredMtx;
+    std::vector<std::pair<uint64_t, bool>> delivered; //PTS and view
+    bool viewOk = true;
+};
+
+#endif //EFP_UNITTEST39_H
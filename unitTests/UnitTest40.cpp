@@ -0,0 +1,172 @@
+//UnitTest40
+//Test reading embedded data without copying it (nextEmbeddedData).
+//A superframe with three embedded sections and a payload is sent.
+//C++ -> nextEmbeddedData must point into the superframe and agree with extractEmbeddedData.
+//C-API -> the embedded data callback must be called for each section in order followed by the payload callback.
+//Malformed embedded data must be rejected.
+
+#include "UnitTest40.h"
+
+#define PAYLOAD_SIZE 3000
+
+static const uint8_t sectionTypes[3] = {ElasticEmbeddedFrameContent::embeddedprivatedata, 0x02, 0x03};
+
+std::vector<uint8_t> UnitTest40::buildFrame() {
+    std::vector<uint8_t> lFrame(PAYLOAD_SIZE);
+    for (size_t x = 0; x < lFrame.size(); x++) {
+        lFrame[x] = (uint8_t) x;
+    }
+    //Embedded in reverse order since each section is inserted at the front
+    for (int x = 2; x >= 0; x--) {
+        std::vector<uint8_t> lSection(10 + x * 5, (uint8_t) (x + 1));
+        ElasticFrameProtocolSender::addEmbeddedData(&lFrame, lSection.data(), lSection.size(),
+                                                    (ElasticEmbeddedFrameContent) sectionTypes[x], x == 2);
+    }
+    return lFrame;
+}
+
+bool UnitTest40::checkSections(const std::vector<std::pair<uint8_t, std::vector<uint8_t>>> &rSections,
+                               const uint8_t *pPayload, size_t lPayloadSize) {
+    if (rSections.size() != 3 || lPayloadSize != PAYLOAD_SIZE) {
+        return false;
+    }
+    for (size_t x = 0; x < rSections.size(); x++) {
+        if (rSections[x].first != sectionTypes[x] ||
+            rSections[x].second != std::vector<uint8_t>(10 + x * 5, (uint8_t) (x + 1))) {
+            return false;
+        }
+    }
+    for (size_t x = 0; x < lPayloadSize; x++) {
+        if (pPayload[x] != (uint8_t) x) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void UnitTest40::sendData(const std::vector<uint8_t> &subPacket) {
+    ElasticFrameMessages info = myEFPReciever->receiveFragment(subPacket, 0);
+    if (info != ElasticFrameMessages::noError) {
+        std::cout << "Error-> " << signed(info) << std::endl;
+        errors = true;
+    }
+}
+
+void UnitTest40::gotData(ElasticFrameProtocolReceiver::pFramePtr &packet) {
+    std::vector<std::pair<uint8_t, std::vector<uint8_t>>> lSections;
+    ElasticFrameProtocolReceiver::EmbeddedData lEmbeddedData;
+    size_t lPosition = 0;
+    do {
+        if (ElasticFrameProtocolReceiver::nextEmbeddedData(packet, &lPosition, &lEmbeddedData) != ElasticFrameMessages::noError ||
+            lEmbeddedData.pData < packet->pFrameData || lEmbeddedData.pData + lEmbeddedData.mSize > packet->pFrameData + lPosition) {
+            errors = true;
+            return;
+        }
+        lSections.emplace_back(lEmbeddedData.mDataContent, std::vector<uint8_t>(lEmbeddedData.pData, lEmbeddedData.pData + lEmbeddedData.mSize));
+    } while (!lEmbeddedData.mLast);
+
+    std::vector<std::vector<uint8_t>> lEmbeddedList;
+    std::vector<uint8_t> lContentList;
+    size_t lPayloadPosition = 0;
+    if (ElasticFrameProtocolReceiver::extractEmbeddedData(packet, &lEmbeddedList, &lContentList, &lPayloadPosition) != ElasticFrameMessages::noError ||
+        lPayloadPosition != lPosition || lEmbeddedList.size() != lSections.size()) {
+        errors = true;
+        return;
+    }
+    for (size_t x = 0; x < lSections.size(); x++) {
+        if (lContentList[x] != lSections[x].first || lEmbeddedList[x] != lSections[x].second) {
+            errors = true;
+            return;
+        }
+    }
+    if (!checkSections(lSections, packet->pFrameData + lPosition, packet->mFrameSize - lPosition)) {
+        errors = true;
+        return;
+    }
+    framesChecked++;
+}
+
+void UnitTest40::gotEmbeddedDataC(uint8_t *pData, size_t lSize, uint8_t lDataType, uint64_t lPts, void *pCtx) {
+    auto *lThis = (UnitTest40 *) pCtx;
+    //The sections must follow each other in the superframe
+    if (lThis->lastSectionEndC && pData <= lThis->lastSectionEndC) {
+        lThis->errors = true;
+    }
+    lThis->lastSectionEndC = pData + lSize;
+    lThis->sectionsC.emplace_back(lDataType, std::vector<uint8_t>(pData, pData + lSize));
+}
+
+void UnitTest40::gotDataC(uint8_t *pData, size_t lSize, uint8_t lDataContent, uint8_t lBroken, uint64_t lPts,
+                          uint64_t lDts, uint32_t lCode, uint8_t lStreamId, uint8_t lSource, uint8_t lFlags, void *pCtx) {
+    auto *lThis = (UnitTest40 *) pCtx;
+    //The payload follows the last section
+    if (lBroken || pData != lThis->lastSectionEndC ||
+        !lThis->checkSections(lThis->sectionsC, pData, lSize)) {
+        lThis->errors = true;
+        return;
+    }
+    lThis->sectionsC.clear();
+    lThis->lastSectionEndC = nullptr;
+    lThis->framesChecked++;
+}
+
+bool UnitTest40::testMalformed() {
+    std::vector<uint8_t> lFrame = buildFrame();
+    ElasticFrameProtocolReceiver::EmbeddedData lEmbeddedData;
+
+    //Truncated in the middle of the second section
+    ElasticFrameProtocolReceiver::pFramePtr lTruncated = std::make_unique<ElasticFrameProtocolReceiver::SuperFrame>(lFrame.data(), 20);
+    size_t lPosition = 0;
+    if (ElasticFrameProtocolReceiver::nextEmbeddedData(lTruncated, &lPosition, &lEmbeddedData) != ElasticFrameMessages::noError ||
+        ElasticFrameProtocolReceiver::nextEmbeddedData(lTruncated, &lPosition, &lEmbeddedData) != ElasticFrameMessages::bufferOutOfBounds) {
+        return false;
+    }
+
+    //Illegal section type
+    lFrame[0] = ElasticEmbeddedFrameContent::illegal;
+    ElasticFrameProtocolReceiver::pFramePtr lIllegal = std::make_unique<ElasticFrameProtocolReceiver::SuperFrame>(lFrame.data(), lFrame.size());
+    lPosition = 0;
+    return ElasticFrameProtocolReceiver::nextEmbeddedData(lIllegal, &lPosition, &lEmbeddedData) == ElasticFrameMessages::illegalEmbeddedData;
+}
+
+bool UnitTest40::startUnitTest() {
+    myEFPPacker = new (std::nothrow) ElasticFrameProtocolSender(MTU);
+    myEFPReciever = new (std::nothrow) ElasticFrameProtocolReceiver(50, 0, nullptr, ElasticFrameProtocolReceiver::EFPReceiverMode::RUN_TO_COMPLETION);
+    if (myEFPReciever == nullptr || myEFPPacker == nullptr) {
+        if (myEFPReciever) delete myEFPReciever;
+        if (myEFPPacker) delete myEFPPacker;
+        return false;
+    }
+    myEFPPacker->sendCallback = std::bind(&UnitTest40::sendData, this, std::placeholders::_1);
+    myEFPReciever->receiveCallback = std::bind(&UnitTest40::gotData, this, std::placeholders::_1);
+    std::vector<uint8_t> lFrame = buildFrame();
+    myEFPPacker->packAndSend(lFrame, ElasticFrameContent::h264, 1, 1, 2, 1, INLINE_PAYLOAD);
+    delete myEFPReciever;
+    bool passed = !errors && framesChecked == 1;
+
+    //The C-API path
+    auto lCtx = std::make_shared<ElasticFrameProtocolContext>();
+    lCtx->mUnsafePointer = this;
+    myEFPReciever = new (std::nothrow) ElasticFrameProtocolReceiver(50, 0, lCtx, ElasticFrameProtocolReceiver::EFPReceiverMode::RUN_TO_COMPLETION);
+    if (myEFPReciever == nullptr) {
+        delete myEFPPacker;
+        return false;
+    }
+    myEFPReciever->c_recieveCallback = &UnitTest40::gotDataC;
+    myEFPReciever->c_recieveEmbeddedDataCallback = &UnitTest40::gotEmbeddedDataC;
+    framesChecked = 0;
+    for (uint64_t pts = 1; pts <= 3; pts++) {
+        myEFPPacker->packAndSend(lFrame, ElasticFrameContent::h264, pts, pts, 2, 1, INLINE_PAYLOAD);
+    }
+    delete myEFPReciever;
+    delete myEFPPacker;
+    passed = passed && !errors && framesChecked == 3;
+    passed = passed && testMalformed();
+
+    if (!passed) {
+        std::cout << "Unit test number: " << unsigned(activeUnitTest) << " Failed." << std::endl;
+        return false;
+    }
+    std::cout << "UnitTest " << unsigned(activeUnitTest) << " done." << std::endl;
+    return true;
+}
@@ -0,0 +1,29 @@
+#ifndef EFP_UNITTEST40_H
+#define EFP_UNITTEST40_H
+
+#include "../ElasticFrameProtocol.h"
+
+#define MTU 1456 //SRT-max
+
+class UnitTest40 {
+public:
+    bool startUnitTest();
+private:
+    static void gotEmbeddedDataC(uint8_t *pData, size_t lSize, uint8_t lDataType, uint64_t lPts, void *pCtx);
+    static void gotDataC(uint8_t *pData, size_t lSize, uint8_t lDataContent, uint8_t lBroken, uint64_t lPts,
+                         uint64_t lDts, uint32_t lCode, uint8_t lStreamId, uint8_t lSource, uint8_t lFlags, void *pCtx);
+    void sendData(const std::vector<uint8_t> &subPacket);
+    void gotData(ElasticFrameProtocolReceiver::pFramePtr &packet);
+    bool checkSections(const std::vector<std::pair<uint8_t, std::vector<uint8_t>>> &rSections, const uint8_t *pPayload, size_t lPayloadSize);
+    bool testMalformed();
+    std::vector<uint8_t> buildFrame();
+    ElasticFrameProtocolReceiver *myEFPReciever = nullptr;
+    ElasticFrameProtocolSender *myEFPPacker = nullptr;
+    int activeUnitTest = 40;
+    bool errors = false;
+    int framesChecked = 0;
+    std::vector<std::pair<uint8_t, std::vector<uint8_t>>> sectionsC;
+    const uint8_t *lastSectionEndC = nullptr;
+};
+
+#endif //EFP_UNITTEST40_H
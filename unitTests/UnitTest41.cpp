@@ -0,0 +1,122 @@
+//UnitTest41
+//Test sending embedded data and the payload as separate buffers (packAndSend with EmbeddedSection).
+//The same superframe is sent using addEmbeddedData + packAndSend and using the gather version for a single
+//fragment superframe, a superframe ending with a type2 and a superframe needing a type3.
+//The number of fragments, the flags and the delivered sections and payload must be the same.
+//Illegal sections must be rejected.
+
+#include "UnitTest41.h"
+
+void UnitTest41::sendData(const std::vector<uint8_t> &subPacket) {
+    fragmentsSent++;
+    ElasticFrameMessages info = myEFPReciever->receiveFragment(subPacket, 0);
+    if (info != ElasticFrameMessages::noError) {
+        std::cout << "Error-> " << signed(info) << std::endl;
+        errors = true;
+    }
+}
+
+void UnitTest41::gotData(ElasticFrameProtocolReceiver::pFramePtr &packet) {
+    if (packet->mBroken) {
+        errors = true;
+        return;
+    }
+    delivered.emplace_back(packet->pFrameData, packet->pFrameData + packet->mFrameSize);
+    deliveredFlags.push_back(packet->mFlags);
+
+    //Check the sections and the payload
+    ElasticFrameProtocolReceiver::EmbeddedData lEmbeddedData;
+    size_t lPosition = 0;
+    for (uint8_t x = 1; x <= 2; x++) {
+        if (ElasticFrameProtocolReceiver::nextEmbeddedData(packet, &lPosition, &lEmbeddedData) != ElasticFrameMessages::noError ||
+            lEmbeddedData.mDataContent != x || lEmbeddedData.mLast != (x == 2) || lEmbeddedData.mSize != 20u * x ||
+            std::any_of(lEmbeddedData.pData, lEmbeddedData.pData + lEmbeddedData.mSize, [x](uint8_t v) { return v != x; })) {
+            errors = true;
+            return;
+        }
+    }
+    for (size_t x = lPosition; x < packet->mFrameSize; x++) {
+        if (packet->pFrameData[x] != (uint8_t) (x - lPosition)) {
+            errors = true;
+            return;
+        }
+    }
+}
+
+bool UnitTest41::runTest(size_t lPayloadSize) {
+    myEFPReciever = new (std::nothrow) ElasticFrameProtocolReceiver(50, 0, nullptr, ElasticFrameProtocolReceiver::EFPReceiverMode::RUN_TO_COMPLETION);
+    myEFPPacker = new (std::nothrow) ElasticFrameProtocolSender(MTU);
+    if (myEFPReciever == nullptr || myEFPPacker == nullptr) {
+        if (myEFPReciever) delete myEFPReciever;
+        if (myEFPPacker) delete myEFPPacker;
+        return false;
+    }
+    myEFPReciever->receiveCallback = std::bind(&UnitTest41::gotData, this, std::placeholders::_1);
+    myEFPPacker->sendCallback = std::bind(&UnitTest41::sendData, this, std::placeholders::_1);
+    delivered.clear();
+    deliveredFlags.clear();
+    errors = false;
+
+    std::vector<uint8_t> lPayload(lPayloadSize);
+    for (size_t x = 0; x < lPayload.size(); x++) {
+        lPayload[x] = (uint8_t) x;
+    }
+    std::vector<uint8_t> lSection1(20, 1);
+    std::vector<uint8_t> lSection2(40, 2);
+
+    //Assembled
+    std::vector<uint8_t> lFrame = lPayload;
+    ElasticFrameProtocolSender::addEmbeddedData(&lFrame, lSection2.data(), lSection2.size(), ElasticEmbeddedFrameContent::h222pmt, true);
+    ElasticFrameProtocolSender::addEmbeddedData(&lFrame, lSection1.data(), lSection1.size(), ElasticEmbeddedFrameContent::embeddedprivatedata);
+    fragmentsSent = 0;
+    myEFPPacker->packAndSend(lFrame, ElasticFrameContent::h264, 1, 1, 2, 1, INLINE_PAYLOAD);
+    size_t lFragmentsAssembled = fragmentsSent;
+
+    //Gathered
+    ElasticFrameProtocolSender::EmbeddedSection lSections[2];
+    lSections[0].pData = lSection1.data();
+    lSections[0].mSize = lSection1.size();
+    lSections[0].mContent = ElasticEmbeddedFrameContent::embeddedprivatedata;
+    lSections[1].pData = lSection2.data();
+    lSections[1].mSize = lSection2.size();
+    lSections[1].mContent = ElasticEmbeddedFrameContent::h222pmt;
+    fragmentsSent = 0;
+    ElasticFrameMessages lResult = myEFPPacker->packAndSend(lSections, 2, lPayload.data(), lPayload.size(),
+                                                            ElasticFrameContent::h264, 2, 2, 2, 1, NO_FLAGS);
+    size_t lFragmentsGathered = fragmentsSent;
+
+    //Illegal sections
+    lSections[1].mContent = ElasticEmbeddedFrameContent::illegal;
+    bool lRejected = myEFPPacker->packAndSend(lSections, 2, lPayload.data(), lPayload.size(), ElasticFrameContent::h264,
+                                              3, 3, 2, 1, NO_FLAGS) == ElasticFrameMessages::illegalEmbeddedData;
+    lSections[1].mContent = ElasticEmbeddedFrameContent::h222pmt;
+    lSections[1].mSize = UINT16_MAX + 1;
+    lRejected = lRejected && myEFPPacker->packAndSend(lSections, 2, lPayload.data(), lPayload.size(), ElasticFrameContent::h264,
+                                                      3, 3, 2, 1, NO_FLAGS) == ElasticFrameMessages::tooLargeEmbeddedData;
+    delete myEFPPacker;
+    delete myEFPReciever;
+
+    if (errors || lResult != ElasticFrameMessages::noError || !lRejected || delivered.size() != 2 ||
+        lFragmentsAssembled != lFragmentsGathered || delivered[0].size() != delivered[1].size() ||
+        deliveredFlags[0] != deliveredFlags[1]) {
+        std::cout << "Gather send of payload size " << lPayloadSize << " failed" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool UnitTest41::startUnitTest() {
+    size_t lType1Payload = MTU - ElasticFrameProtocolSender::geType1Size();
+    size_t lType2Payload = MTU - ElasticFrameProtocolSender::geType2Size();
+    size_t lEmbeddedSize = 2 * sizeof(ElasticFrameContentNamespace::ElasticEmbeddedHeader) + 60;
+    bool passed = runTest(100);
+    passed = passed && runTest((lType1Payload * 3) + 100 - lEmbeddedSize);
+    //The reminder does not fit a type2 -> type3
+    passed = passed && runTest((lType1Payload * 3) + lType2Payload + 1 - lEmbeddedSize);
+    if (!passed) {
+        std::cout << "Unit test number: " << unsigned(activeUnitTest) << " Failed." << std::endl;
+        return false;
+    }
+    std::cout << "UnitTest " << unsigned(activeUnitTest) << " done." << std::endl;
+    return true;
+}
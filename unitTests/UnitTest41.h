@@ -0,0 +1,24 @@
+#ifndef EFP_UNITTEST41_H
+#define EFP_UNITTEST41_H
+
+#include "../ElasticFrameProtocol.h"
+
+#define MTU 1456 //SRT-max
+
+class UnitTest41 {
+public:
+    bool startUnitTest();
+private:
+    void sendData(const std::vector<uint8_t> &subPacket);
+    void gotData(ElasticFrameProtocolReceiver::pFramePtr &packet);
+    bool runTest(size_t lPayloadSize);
+    ElasticFrameProtocolReceiver *myEFPReciever = nullptr;
+    ElasticFrameProtocolSender *myEFPPacker = nullptr;
+    int activeUnitTest = 41;
+    bool errors = false;
+    size_t fragmentsSent = 0;
+    std::vector<std::vector<uint8_t>> delivered;
+    std::vector<uint8_t> deliveredFlags;
+};
+
+#endif //EFP_UNITTEST41_H
@@ -0,0 +1,91 @@
+//UnitTest42
+//Test the non-temporal copy of received data (setNonTemporalCopyThreshold).
+//Superframes of sizes around the vector sizes and fragment sizes are sent with an odd MTU so the fragments are
+//copied to unaligned positions. Also a streamed superframe (type7) is sent.
+//All data must be intact using non-temporal copies for all superframes (0), from 4000 bytes and never (SIZE_MAX).
+
+#include "UnitTest42.h"
+
+#define ODD_MTU 1001 //The fragments are not aligned in the superframe
+
+static const size_t testSizes[] = {1, 15, 16, 17, 63, 64, 65, 985, 986, 987, 4000, 4001, 100003};
+
+void UnitTest42::sendData(const std::vector<uint8_t> &subPacket) {
+    ElasticFrameMessages info = myEFPReciever->receiveFragment(subPacket, 0);
+    if (info != ElasticFrameMessages::noError) {
+        std::cout << "Error-> " << signed(info) << std::endl;
+        errors = true;
+    }
+}
+
+void UnitTest42::gotData(ElasticFrameProtocolReceiver::pFramePtr &packet) {
+    if (packet->mBroken) {
+        errors = true;
+        return;
+    }
+    for (size_t x = 0; x < packet->mFrameSize; x++) {
+        if (packet->pFrameData[x] != (uint8_t) (x * 7 + packet->mPts)) {
+            errors = true;
+            return;
+        }
+    }
+    delivered.push_back(packet->mFrameSize);
+}
+
+bool UnitTest42::runTest(size_t lThreshold) {
+    myEFPReciever = new (std::nothrow) ElasticFrameProtocolReceiver(50, 0, nullptr, ElasticFrameProtocolReceiver::EFPReceiverMode::RUN_TO_COMPLETION);
+    myEFPPacker = new (std::nothrow) ElasticFrameProtocolSender(ODD_MTU);
+    if (myEFPReciever == nullptr || myEFPPacker == nullptr) {
+        if (myEFPReciever) delete myEFPReciever;
+        if (myEFPPacker) delete myEFPPacker;
+        return false;
+    }
+    myEFPReciever->receiveCallback = std::bind(&UnitTest42::gotData, this, std::placeholders::_1);
+    myEFPReciever->setNonTemporalCopyThreshold(lThreshold);
+    myEFPPacker->sendCallback = std::bind(&UnitTest42::sendData, this, std::placeholders::_1);
+    delivered.clear();
+    errors = false;
+
+    std::vector<size_t> lExpected;
+    uint64_t lPts = 1;
+    for (size_t lSize: testSizes) {
+        std::vector<uint8_t> mydata(lSize);
+        for (size_t x = 0; x < mydata.size(); x++) {
+            mydata[x] = (uint8_t) (x * 7 + lPts);
+        }
+        myEFPPacker->packAndSend(mydata, ElasticFrameContent::adts, lPts, lPts, 2, 1, NO_FLAGS);
+        lExpected.push_back(lSize);
+        lPts++;
+    }
+
+    //Streamed superframe
+    std::vector<uint8_t> mydata(50001);
+    for (size_t x = 0; x < mydata.size(); x++) {
+        mydata[x] = (uint8_t) (x * 7 + lPts);
+    }
+    myEFPPacker->beginSuperFrame(ElasticFrameContent::adts, 1, NO_FLAGS);
+    myEFPPacker->appendData(mydata.data(), 20000);
+    myEFPPacker->appendData(mydata.data() + 20000, mydata.size() - 20000);
+    myEFPPacker->endSuperFrame(lPts, lPts, 2);
+    lExpected.push_back(mydata.size());
+
+    delete myEFPPacker;
+    delete myEFPReciever;
+    if (errors || delivered != lExpected) {
+        std::cout << "Non-temporal threshold " << lThreshold << " failed" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool UnitTest42::startUnitTest() {
+    bool passed = runTest(0);
+    passed = passed && runTest(4000);
+    passed = passed && runTest(SIZE_MAX);
+    if (!passed) {
+        std::cout << "Unit test number: " << unsigned(activeUnitTest) << " Failed." << std::endl;
+        return false;
+    }
+    std::cout << "UnitTest " << unsigned(activeUnitTest) << " done." << std::endl;
+    return true;
+}
@@ -0,0 +1,22 @@
+#ifndef EFP_UNITTEST42_H
+#define EFP_UNITTEST42_H
+
+#include "../ElasticFrameProtocol.h"
+
+#define MTU 1456 //SRT-max
+
+class UnitTest42 {
+public:
+    bool startUnitTest();
+private:
+    void sendData(const std::vector<uint8_t> &subPacket);
+    void gotData(ElasticFrameProtocolReceiver::pFramePtr &packet);
+    bool runTest(size_t lThreshold);
+    ElasticFrameProtocolReceiver *myEFPReciever = nullptr;
+    ElasticFrameProtocolSender *myEFPPacker = nullptr;
+    int activeUnitTest = 42;
+    bool errors = false;
+    std::vector<size_t> delivered;
+};
+
+#endif //EFP_UNITTEST42_H
@@ -0,0 +1,103 @@
+//UnitTest43
+//Test huge pages for the bucket list and large superframes (setHugePages).
+//Half of a superframe is received, then huge pages are enabled (moving the bucket list) and the rest is received.
+//Superframes above and below the threshold are sent, then huge pages are disabled while a superframe is assembled.
+//All superframes must be delivered in order and intact. (Not implemented on other platforms than Linux)
+
+#include "UnitTest43.h"
+
+void UnitTest43::sendData(const std::vector<uint8_t> &subPacket) {
+    if (holdFragments) {
+        heldFragments.push_back(subPacket);
+        return;
+    }
+    ElasticFrameMessages info = myEFPReciever->receiveFragment(subPacket, 0);
+    if (info != ElasticFrameMessages::noError) {
+        std::cout << "Error-> " << signed(info) << std::endl;
+        errors = true;
+    }
+}
+
+void UnitTest43::gotData(ElasticFrameProtocolReceiver::pFramePtr &packet) {
+    if (packet->mBroken) {
+        errors = true;
+        return;
+    }
+    for (size_t x = 0; x < packet->mFrameSize; x++) {
+        if (packet->pFrameData[x] != (uint8_t) (x + packet->mPts)) {
+            errors = true;
+            return;
+        }
+    }
+    delivered.emplace_back(packet->mPts, packet->mFrameSize);
+}
+
+void UnitTest43::sendFrame(size_t lSize, uint64_t lPts) {
+    std::vector<uint8_t> mydata(lSize);
+    for (size_t x = 0; x < mydata.size(); x++) {
+        mydata[x] = (uint8_t) (x + lPts);
+    }
+    myEFPPacker->packAndSend(mydata, ElasticFrameContent::adts, lPts, lPts, 2, 1, NO_FLAGS);
+}
+
+bool UnitTest43::startUnitTest() {
+    myEFPReciever = new (std::nothrow) ElasticFrameProtocolReceiver(50, 0, nullptr, ElasticFrameProtocolReceiver::EFPReceiverMode::RUN_TO_COMPLETION);
+    myEFPPacker = new (std::nothrow) ElasticFrameProtocolSender(MTU);
+    if (myEFPReciever == nullptr || myEFPPacker == nullptr) {
+        if (myEFPReciever) delete myEFPReciever;
+        if (myEFPPacker) delete myEFPPacker;
+        return false;
+    }
+    myEFPReciever->receiveCallback = std::bind(&UnitTest43::gotData, this, std::placeholders::_1);
+    myEFPPacker->sendCallback = std::bind(&UnitTest43::sendData, this, std::placeholders::_1);
+
+    std::vector<std::pair<uint64_t, size_t>> lExpected;
+    uint64_t lPts = 1;
+
+    //Enable while a superframe is being assembled
+    holdFragments = true;
+    sendFrame(100000, lPts);
+    holdFragments = false;
+    for (size_t x = 0; x < heldFragments.size() / 2; x++) {
+        sendData(heldFragments[x]);
+    }
+    ElasticFrameMessages lResult = myEFPReciever->setHugePages(true, 64 * 1024);
+#ifdef __linux__
+    bool passed = lResult == ElasticFrameMessages::noError;
+#else
+    bool passed = lResult == ElasticFrameMessages::notImplemented;
+#endif
+    for (size_t x = heldFragments.size() / 2; x < heldFragments.size(); x++) {
+        sendData(heldFragments[x]);
+    }
+    heldFragments.clear();
+    lExpected.emplace_back(lPts++, 100000);
+
+    for (size_t lSize: {(size_t) 1000, (size_t) 64 * 1024, (size_t) 3 * 1024 * 1024 + 1, (size_t) 500000}) {
+        sendFrame(lSize, lPts);
+        lExpected.emplace_back(lPts++, lSize);
+    }
+
+    //Disable while a superframe is being assembled
+    holdFragments = true;
+    sendFrame(200000, lPts);
+    holdFragments = false;
+    sendData(heldFragments[0]);
+    myEFPReciever->setHugePages(false);
+    for (size_t x = 1; x < heldFragments.size(); x++) {
+        sendData(heldFragments[x]);
+    }
+    heldFragments.clear();
+    lExpected.emplace_back(lPts++, 200000);
+    sendFrame(200000, lPts);
+    lExpected.emplace_back(lPts++, 200000);
+
+    delete myEFPPacker;
+    delete myEFPReciever;
+    if (!passed || errors || delivered != lExpected) {
+        std::cout << "Unit test number: " << unsigned(activeUnitTest) << " Failed." << std::endl;
+        return false;
+    }
+    std::cout << "UnitTest " << unsigned(activeUnitTest) << " done." << std::endl;
+    return true;
+}
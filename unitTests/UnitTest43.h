@@ -0,0 +1,24 @@
+#ifndef EFP_UNITTEST43_H
+#define EFP_UNITTEST43_H
+
+#include "../ElasticFrameProtocol.h"
+
+#define MTU 1456 //SRT-max
+
+class UnitTest43 {
+public:
+    bool startUnitTest();
+private:
+    void sendData(const std::vector<uint8_t> &subPacket);
+    void gotData(ElasticFrameProtocolReceiver::pFramePtr &packet);
+    void sendFrame(size_t lSize, uint64_t lPts);
+    ElasticFrameProtocolReceiver *myEFPReciever = nullptr;
+    ElasticFrameProtocolSender *myEFPPacker = nullptr;
+    int activeUnitTest = 43;
+    bool errors = false;
+    bool holdFragments = false;
+    std::vector<std::vector<uint8_t>> heldFragments;
+    std::vector<std::pair<uint64_t, size_t>> delivered;
+};
+
+#endif //EFP_UNITTEST43_H
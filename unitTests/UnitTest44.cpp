@@ -0,0 +1,93 @@
+//UnitTest44
+//Test placing a threaded receiver on a NUMA node (setNumaNode).
+//Node 0 is set while a stream lane is running and large (mapped on the node) and small superframes are sent on two
+//EFP-streams. A node that does not exist must be rejected. The placement is removed and more superframes are sent.
+//All superframes must be delivered intact. (Not implemented on other platforms than Linux)
+
+#include "UnitTest44.h"
+
+void UnitTest44::sendData(const std::vector<uint8_t> &subPacket) {
+    ElasticFrameMessages info = myEFPReciever->receiveFragment(subPacket, 0);
+    if (info != ElasticFrameMessages::noError) {
+        std::cout << "Error-> " << signed(info) << std::endl;
+        errors = true;
+    }
+}
+
+void UnitTest44::gotData(ElasticFrameProtocolReceiver::pFramePtr &packet) {
+    if (packet->mBroken) {
+        errors = true;
+    }
+    for (size_t x = 0; x < packet->mFrameSize; x++) {
+        if (packet->pFrameData[x] != (uint8_t) (x + packet->mPts)) {
+            errors = true;
+            break;
+        }
+    }
+    std::lock_guard<std::mutex> lock(deliveredMtx);
+    delivered++;
+}
+
+bool UnitTest44::waitForFrames(size_t lFrames) {
+    for (int x = 0; x < 500; x++) {
+        {
+            std::lock_guard<std::mutex> lock(deliveredMtx);
+            if (delivered == lFrames) {
+                return true;
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return false;
+}
+
+bool UnitTest44::startUnitTest() {
+    myEFPReciever = new (std::nothrow) ElasticFrameProtocolReceiver(50, 0);
+    myEFPPacker = new (std::nothrow) ElasticFrameProtocolSender(MTU);
+    if (myEFPReciever == nullptr || myEFPPacker == nullptr) {
+        if (myEFPReciever) delete myEFPReciever;
+        if (myEFPPacker) delete myEFPPacker;
+        return false;
+    }
+    myEFPReciever->receiveCallback = std::bind(&UnitTest44::gotData, this, std::placeholders::_1);
+    myEFPReciever->setStreamCallback(2, std::bind(&UnitTest44::gotData, this, std::placeholders::_1));
+    myEFPPacker->sendCallback = std::bind(&UnitTest44::sendData, this, std::placeholders::_1);
+
+#ifdef __linux__
+    bool passed = myEFPReciever->setNumaNode(0) == ElasticFrameMessages::noError;
+    passed = passed && myEFPReciever->setNumaNode(5000) == ElasticFrameMessages::numaNodeNotAvailable;
+#else
+    bool passed = myEFPReciever->setNumaNode(0) == ElasticFrameMessages::notImplemented;
+#endif
+
+    uint64_t lPts = 1;
+    size_t lFrames = 0;
+    for (int lRound = 0; lRound < 2; lRound++) {
+        for (size_t lSize: {(size_t) 1000, (size_t) 3 * 1024 * 1024, (size_t) 100000}) {
+            for (uint8_t lStreamID = 1; lStreamID <= 2; lStreamID++) {
+                std::vector<uint8_t> mydata(lSize);
+                for (size_t x = 0; x < mydata.size(); x++) {
+                    mydata[x] = (uint8_t) (x + lPts);
+                }
+                myEFPPacker->packAndSend(mydata, ElasticFrameContent::adts, lPts, lPts, 2, lStreamID, NO_FLAGS);
+                lPts++;
+                lFrames++;
+            }
+        }
+        passed = passed && waitForFrames(lFrames);
+        if (!lRound) {
+#ifdef __linux__
+            passed = passed && myEFPReciever->setNumaNode(-1) == ElasticFrameMessages::noError;
+#endif
+        }
+    }
+
+    delete myEFPPacker;
+    delete myEFPReciever;
+    if (!passed || errors) {
+        std::cout << "Unit test number: " << unsigned(activeUnitTest) << " Failed." << std::endl;
+        return false;
+    }
+    std::cout << "UnitTest " << unsigned(activeUnitTest) << " done." << std::endl;
+    return true;
+}
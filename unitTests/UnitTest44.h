@@ -0,0 +1,23 @@
+#ifndef EFP_UNITTEST44_H
+#define EFP_UNITTEST44_H
+
+#include "../ElasticFrameProtocol.h"
+
+#define MTU 1456 //SRT-max
+
+class UnitTest44 {
+public:
+    bool startUnitTest();
+private:
+    void sendData(const std::vector<uint8_t> &subPacket);
+    void gotData(ElasticFrameProtocolReceiver::pFramePtr &packet);
+    bool waitForFrames(size_t lFrames);
+    ElasticFrameProtocolReceiver *myEFPReciever = nullptr;
+    ElasticFrameProtocolSender *myEFPPacker = nullptr;
+    int activeUnitTest = 44;
+    std::atomic_bool errors = {false};
+    std::mutex deliveredMtx;
+    size_t delivered = 0;
+};
+
+#endif //EFP_UNITTEST44_H
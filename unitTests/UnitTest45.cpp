@@ -0,0 +1,139 @@
+//UnitTest45
+//Test configuring the threads owned by a threaded receiver (setThreadConfig).
+//The threads are named, pinned to CPU 0 and niced while a stream lane is running. The worker, delivery and lane
+//threads (also a lane started after the configuration) must carry the name. A priority out of range must be rejected.
+//Superframes are sent on two EFP-streams and must be delivered intact. SCHED_FIFO may be refused without
+//CAP_SYS_NICE. (Not implemented on other platforms than Linux)
+
+#include "UnitTest45.h"
+
+#ifdef __linux__
+#include <dirent.h>
+#include <fstream>
+#endif
+
+void UnitTest45::sendData(const std::vector<uint8_t> &subPacket) {
+    ElasticFrameMessages info = myEFPReciever->receiveFragment(subPacket, 0);
+    if (info != ElasticFrameMessages::noError) {
+        std::cout << "Error-> " << signed(info) << std::endl;
+        errors = true;
+    }
+}
+
+void UnitTest45::gotData(ElasticFrameProtocolReceiver::pFramePtr &packet) {
+    if (packet->mBroken) {
+        errors = true;
+    }
+    for (size_t x = 0; x < packet->mFrameSize; x++) {
+        if (packet->pFrameData[x] != (uint8_t) (x + packet->mPts)) {
+            errors = true;
+            break;
+        }
+    }
+    std::lock_guard<std::mutex> lock(deliveredMtx);
+    delivered++;
+}
+
+bool UnitTest45::waitForFrames(size_t lFrames) {
+    for (int x = 0; x < 500; x++) {
+        {
+            std::lock_guard<std::mutex> lock(deliveredMtx);
+            if (delivered == lFrames) {
+                return true;
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return false;
+}
+
+// Is there a thread with the name in this process (the threads name themselves when started)
+bool UnitTest45::hasThread(const std::string &rName) {
+#ifdef __linux__
+    for (int x = 0; x < 100; x++) {
+        DIR *pDir = opendir("/proc/self/task");
+        if (pDir == nullptr) {
+            return false;
+        }
+        bool lFound = false;
+        while (dirent *pEntry = readdir(pDir)) {
+            std::ifstream lComm(std::string("/proc/self/task/") + pEntry->d_name + "/comm");
+            std::string lName;
+            if (std::getline(lComm, lName) && lName == rName) {
+                lFound = true;
+            }
+        }
+        closedir(pDir);
+        if (lFound) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+#endif
+    return false;
+}
+
+bool UnitTest45::startUnitTest() {
+    myEFPReciever = new (std::nothrow) ElasticFrameProtocolReceiver(50, 0);
+    myEFPPacker = new (std::nothrow) ElasticFrameProtocolSender(MTU);
+    if (myEFPReciever == nullptr || myEFPPacker == nullptr) {
+        if (myEFPReciever) delete myEFPReciever;
+        if (myEFPPacker) delete myEFPPacker;
+        return false;
+    }
+    myEFPReciever->receiveCallback = std::bind(&UnitTest45::gotData, this, std::placeholders::_1);
+    myEFPReciever->setStreamCallback(2, std::bind(&UnitTest45::gotData, this, std::placeholders::_1));
+    myEFPPacker->sendCallback = std::bind(&UnitTest45::sendData, this, std::placeholders::_1);
+
+    ElasticFrameProtocolReceiver::ThreadConfig lConfig;
+    lConfig.mName = "unittest45";
+    lConfig.mCpus = {0};
+    lConfig.mNice = 5;
+#ifdef __linux__
+    bool passed = myEFPReciever->setThreadConfig(lConfig) == ElasticFrameMessages::noError;
+    myEFPReciever->setStreamCallback(3, std::bind(&UnitTest45::gotData, this, std::placeholders::_1));
+    passed = passed && hasThread("unittest45-rx") && hasThread("unittest45-dlv") && hasThread("unittest45-ln2") &&
+             hasThread("unittest45-ln3");
+    ElasticFrameProtocolReceiver::ThreadConfig lBadConfig = lConfig;
+    lBadConfig.mPolicy = ElasticFrameProtocolReceiver::EFPThreadPolicy::FIFO;
+    lBadConfig.mPriority = 1000;
+    passed = passed && myEFPReciever->setThreadConfig(lBadConfig) == ElasticFrameMessages::threadConfigFailed;
+#else
+    bool passed = myEFPReciever->setThreadConfig(lConfig) == ElasticFrameMessages::notImplemented;
+#endif
+
+    uint64_t lPts = 1;
+    size_t lFrames = 0;
+    for (int lRound = 0; lRound < 2; lRound++) {
+        for (size_t lSize: {(size_t) 1000, (size_t) 100000}) {
+            for (uint8_t lStreamID = 1; lStreamID <= 3; lStreamID++) {
+                std::vector<uint8_t> mydata(lSize);
+                for (size_t x = 0; x < mydata.size(); x++) {
+                    mydata[x] = (uint8_t) (x + lPts);
+                }
+                myEFPPacker->packAndSend(mydata, ElasticFrameContent::adts, lPts, lPts, 2, lStreamID, NO_FLAGS);
+                lPts++;
+                lFrames++;
+            }
+        }
+        passed = passed && waitForFrames(lFrames);
+        if (!lRound) {
+#ifdef __linux__
+            lConfig.mPolicy = ElasticFrameProtocolReceiver::EFPThreadPolicy::FIFO;
+            lConfig.mPriority = 10;
+            ElasticFrameMessages lResult = myEFPReciever->setThreadConfig(lConfig);
+            passed = passed && (lResult == ElasticFrameMessages::noError ||
+                                lResult == ElasticFrameMessages::threadConfigFailed);
+#endif
+        }
+    }
+
+    delete myEFPPacker;
+    delete myEFPReciever;
+    if (!passed || errors) {
+        std::cout << "Unit test number: " << unsigned(activeUnitTest) << " Failed." << std::endl;
+        return false;
+    }
+    std::cout << "UnitTest " << unsigned(activeUnitTest) << " done." << std::endl;
+    return true;
+}
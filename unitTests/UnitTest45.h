@@ -0,0 +1,24 @@
+#ifndef EFP_UNITTEST45_H
+#define EFP_UNITTEST45_H
+
+#include "../ElasticFrameProtocol.h"
+
+#define MTU 1456 //SRT-max
+
+class UnitTest45 {
+public:
+    bool startUnitTest();
+private:
+    void sendData(const std::vector<uint8_t> &subPacket);
+    void gotData(ElasticFrameProtocolReceiver::pFramePtr &packet);
+    bool waitForFrames(size_t lFrames);
+    bool hasThread(const std::string &rName);
+    ElasticFrameProtocolReceiver *myEFPReciever = nullptr;
+    ElasticFrameProtocolSender *myEFPPacker = nullptr;
+    int activeUnitTest = 45;
+    std::atomic_bool errors = {false};
+    std::mutex deliveredMtx;
+    size_t delivered = 0;
+};
+
+#endif //EFP_UNITTEST45_H